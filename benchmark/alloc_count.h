@@ -0,0 +1,108 @@
+#pragma once
+
+// Replaces the global operator new & delete to count live heap bytes. Include in one translation unit per binary only.
+// Every block carries a header with its size, so unsized & aligned deletes are counted exactly
+
+#include "slot_alloc.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace alloc_count
+{
+    inline std::atomic<size_t> live_bytes{0};
+    inline std::atomic<size_t> peak_bytes{0};
+    inline std::atomic<size_t> allocations{0};
+
+    constexpr size_t HEADER = alignof(std::max_align_t);
+
+    inline void on_alloc(size_t n) noexcept
+    {
+        const size_t live = live_bytes.fetch_add(n, std::memory_order_relaxed) + n;
+        size_t peak = peak_bytes.load(std::memory_order_relaxed);
+        while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The size sits in the last word before the returned pointer, the block starts offset bytes earlier
+    inline void *allocate(size_t n, size_t align)
+    {
+        const size_t offset = align > HEADER ? align : HEADER;
+        void *base = align > HEADER ? std::aligned_alloc(align, (n + offset + align - 1) / align * align) : std::malloc(n + offset);
+        if (base == nullptr)
+            throw std::bad_alloc();
+        char *p = static_cast<char *>(base) + offset;
+        reinterpret_cast<size_t *>(p)[-1] = n;
+        on_alloc(n);
+        return p;
+    }
+
+    inline void deallocate(void *p, size_t align) noexcept
+    {
+        if (p == nullptr)
+            return;
+        const size_t offset = align > HEADER ? align : HEADER;
+        live_bytes.fetch_sub(reinterpret_cast<size_t *>(p)[-1], std::memory_order_relaxed);
+        std::free(static_cast<char *>(p) - offset);
+    }
+
+    // Start a new peak measurement from the current live bytes
+    inline void reset_peak() noexcept { peak_bytes.store(live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+    // Slot array backend counting the arrays of the tables using it apart from the global counters, so the bytes of the
+    // slot & control arrays show separately from the heap memory the keys & values own
+    template <typename Base = HashTable::HeapAlloc>
+    struct SlotAlloc
+    {
+        static constexpr bool PARALLEL_TOUCH = Base::PARALLEL_TOUCH;
+        inline static std::atomic<size_t> live_bytes{0};
+        inline static std::atomic<size_t> peak_bytes{0};
+
+        [[nodiscard]] static void *allocate(size_t bytes, size_t align) noexcept
+        {
+            const size_t live = live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            size_t peak = peak_bytes.load(std::memory_order_relaxed);
+            while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+            {
+            }
+            return Base::allocate(bytes, align);
+        }
+
+        static void deallocate(void *p, size_t bytes, size_t align) noexcept
+        {
+            live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            Base::deallocate(p, bytes, align);
+        }
+
+        static void reset_peak() noexcept { peak_bytes.store(live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+    };
+}
+
+void *operator new(size_t n) { return alloc_count::allocate(n, 0); }
+void *operator new[](size_t n) { return alloc_count::allocate(n, 0); }
+void *operator new(size_t n, std::align_val_t a) { return alloc_count::allocate(n, static_cast<size_t>(a)); }
+void *operator new[](size_t n, std::align_val_t a) { return alloc_count::allocate(n, static_cast<size_t>(a)); }
+void *operator new(size_t n, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return alloc_count::allocate(n, 0);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void operator delete(void *p) noexcept { alloc_count::deallocate(p, 0); }
+void operator delete[](void *p) noexcept { alloc_count::deallocate(p, 0); }
+void operator delete(void *p, size_t) noexcept { alloc_count::deallocate(p, 0); }
+void operator delete[](void *p, size_t) noexcept { alloc_count::deallocate(p, 0); }
+void operator delete(void *p, std::align_val_t a) noexcept { alloc_count::deallocate(p, static_cast<size_t>(a)); }
+void operator delete[](void *p, std::align_val_t a) noexcept { alloc_count::deallocate(p, static_cast<size_t>(a)); }
+void operator delete(void *p, size_t, std::align_val_t a) noexcept { alloc_count::deallocate(p, static_cast<size_t>(a)); }
+void operator delete[](void *p, size_t, std::align_val_t a) noexcept { alloc_count::deallocate(p, static_cast<size_t>(a)); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { alloc_count::deallocate(p, 0); }
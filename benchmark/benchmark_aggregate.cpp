@@ -0,0 +1,121 @@
+#include "benchmark/benchmark.h"
+#include "hash_aggregate.h"
+#include "bm.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Rows per iteration
+constexpr size_t AGG_ROWS = 1 << 22;
+
+// Rows of one of n groups each, keys spread over 64 bits. Shared by the benchmarks of one cardinality
+struct AggData
+{
+    std::vector<uint64_t> keys;
+    std::vector<int64_t> vals;
+};
+
+static const AggData &agg_data(size_t n_groups)
+{
+    static size_t cached = 0;
+    static AggData d;
+    if (cached != n_groups)
+    {
+        std::mt19937_64 gen(42);
+        d.keys.resize(AGG_ROWS);
+        d.vals.resize(AGG_ROWS);
+        for (size_t i = 0; i < AGG_ROWS; i++)
+        {
+            d.keys[i] = (gen() % n_groups) * 0x9E3779B97F4A7C15ull;
+            d.vals[i] = static_cast<int64_t>(gen() % 1000);
+        }
+        cached = n_groups;
+    }
+    return d;
+}
+
+// One find per row, then an emplace for the first row of a group
+static void Agg_RowByRow(benchmark::State &state)
+{
+    struct Agg
+    {
+        int64_t sum;
+        uint64_t count;
+        int64_t min;
+        int64_t max;
+    };
+    const auto &d = agg_data(state.range(0));
+    BM_PERF(state, AGG_ROWS);
+    for (auto _ : state)
+    {
+        HashTable::HashTable<uint64_t, Agg> m;
+        for (size_t i = 0; i < AGG_ROWS; i++)
+        {
+            const int64_t v = d.vals[i];
+            if (const auto a = m.find(d.keys[i]))
+            {
+                Agg &g = *a.value();
+                g.sum += v;
+                g.count += 1;
+                g.min = std::min(g.min, v);
+                g.max = std::max(g.max, v);
+            }
+            else
+                m.emplace(d.keys[i], Agg{v, 1, v, v});
+        }
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * AGG_ROWS);
+}
+
+static void Agg_Hash(benchmark::State &state)
+{
+    const auto &d = agg_data(state.range(0));
+    BM_PERF(state, AGG_ROWS);
+    for (auto _ : state)
+    {
+        HashTable::HashAggregate<uint64_t, int64_t> a;
+        a.consume(d.keys.data(), d.vals.data(), AGG_ROWS);
+        benchmark::DoNotOptimize(a.size());
+    }
+    state.SetItemsProcessed(state.iterations() * AGG_ROWS);
+}
+
+// Only sum & count, the cost of the two extra columns
+static void Agg_HashSumCount(benchmark::State &state)
+{
+    const auto &d = agg_data(state.range(0));
+    BM_PERF(state, AGG_ROWS);
+    for (auto _ : state)
+    {
+        HashTable::HashAggregate<uint64_t, int64_t, HashTable::AGG_SUM | HashTable::AGG_COUNT> a;
+        a.consume(d.keys.data(), d.vals.data(), AGG_ROWS);
+        benchmark::DoNotOptimize(a.size());
+    }
+    state.SetItemsProcessed(state.iterations() * AGG_ROWS);
+}
+
+static void Agg_Partitioned(benchmark::State &state)
+{
+    const auto &d = agg_data(state.range(0));
+    BM_PERF(state, AGG_ROWS);
+    for (auto _ : state)
+    {
+        HashTable::PartitionedAggregate<uint64_t, int64_t> a;
+        a.consume(d.keys.data(), d.vals.data(), AGG_ROWS);
+        a.flush();
+        benchmark::DoNotOptimize(a.size());
+    }
+    state.SetItemsProcessed(state.iterations() * AGG_ROWS);
+}
+
+// 16 & 1K groups stay in L1 & L2, 64K groups in the LLC, 4M groups far past it with most rows in a group of their own
+#define AGG_BM(bm) BENCHMARK(bm)->Arg(1 << 4)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 22)->Unit(benchmark::kMillisecond)
+AGG_BM(Agg_RowByRow);
+AGG_BM(Agg_Hash);
+AGG_BM(Agg_HashSumCount);
+AGG_BM(Agg_Partitioned);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+#include "benchmark/benchmark.h"
+#include "hashcache.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+constexpr size_t CACHE_KEYS = 1 << 20;
+constexpr size_t CACHE_OPS = 1 << 20;
+#define BM_CACHE(bm) BENCHMARK(bm)->ArgsProduct({{1 << 10, 1 << 14, 1 << 17}, {80, 99, 120}})
+
+// Classic LRU, a map into a recency list
+class ListLRU
+{
+private:
+    using List = std::list<std::pair<uint64_t, uint64_t>>;
+    List m_list;
+    std::unordered_map<uint64_t, List::iterator> m_map;
+    size_t m_capacity;
+
+public:
+    size_t hits = 0;
+    size_t misses = 0;
+
+    explicit ListLRU(size_t capacity) : m_capacity(capacity) { m_map.reserve(capacity); }
+
+    uint64_t *find(uint64_t key)
+    {
+        const auto it = m_map.find(key);
+        if (it == m_map.end())
+        {
+            misses += 1;
+            return nullptr;
+        }
+        hits += 1;
+        m_list.splice(m_list.begin(), m_list, it->second);
+        return &it->second->second;
+    }
+
+    void emplace(uint64_t key, uint64_t val)
+    {
+        if (m_map.size() == m_capacity)
+        {
+            m_map.erase(m_list.back().first);
+            m_list.pop_back();
+        }
+        m_list.emplace_front(key, val);
+        m_map.emplace(key, m_list.begin());
+    }
+};
+
+// Memoization loop, every miss inserts the key. Args are capacity & Zipf skew * 100
+static void ListLRU_Zipf(benchmark::State &state)
+{
+    const auto trace = make_zipf_trace(CACHE_KEYS, CACHE_OPS, static_cast<double>(state.range(1)) / 100);
+    double hit_rate = 0;
+    BM_PERF(state, trace.size());
+    for (auto _ : state)
+    {
+        ListLRU c(state.range(0));
+        for (const uint64_t k : trace)
+            if (!c.find(k))
+                c.emplace(k, k);
+        hit_rate = static_cast<double>(c.hits) / static_cast<double>(c.hits + c.misses);
+    }
+    state.SetItemsProcessed(state.iterations() * trace.size());
+    state.counters["hit_rate"] = hit_rate;
+}
+BM_CACHE(ListLRU_Zipf);
+
+static void HashCache_Zipf(benchmark::State &state)
+{
+    const auto trace = make_zipf_trace(CACHE_KEYS, CACHE_OPS, static_cast<double>(state.range(1)) / 100);
+    double hit_rate = 0;
+    BM_PERF(state, trace.size());
+    for (auto _ : state)
+    {
+        HashTable::HashCache<uint64_t, uint64_t> c(state.range(0));
+        for (const uint64_t k : trace)
+            if (!c.find(k))
+                c.emplace(k, k);
+        hit_rate = c.hit_rate();
+    }
+    state.SetItemsProcessed(state.iterations() * trace.size());
+    state.counters["hit_rate"] = hit_rate;
+}
+BM_CACHE(HashCache_Zipf);
+
+BENCHMARK_MAIN();
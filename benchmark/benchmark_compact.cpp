@@ -0,0 +1,84 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "int_hashtable.h"
+#include "compact_hashtable.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <cassert>
+#include <random>
+#include <vector>
+
+using Table = HashTable::HashTable<uint32_t, uint32_t>;
+using IntTable = HashTable::IntHashTable<uint32_t, uint32_t>;
+using CompactSet = HashTable::CompactIntSet<uint32_t>;
+
+// Distinct random keys, ones below 2 are skipped as IntHashTable reserves the top keys as sentinels
+std::vector<uint32_t> make_keys(size_t n, uint64_t seed)
+{
+    std::vector<uint32_t> v;
+    v.reserve(n);
+    for (uint32_t i = 0; i < n; i++)
+        v.push_back(HashTable::detail::InvertibleMix<uint32_t>::mix(i + static_cast<uint32_t>(seed)) >> 1);
+    return v;
+}
+
+void insert(Table &m, uint32_t k) { m.emplace(k, k); }
+void insert(IntTable &m, uint32_t k) { m.emplace(k, k); }
+void insert(CompactSet &m, uint32_t k) { m.insert(k); }
+
+bool contains(const Table &m, uint32_t k) { return m.find(k).has_value(); }
+bool contains(const IntTable &m, uint32_t k) { return m.find(k).has_value(); }
+bool contains(const CompactSet &m, uint32_t k) { return m.contains(k); }
+
+// Bytes held by the slot arrays
+size_t bytes(const Table &m) { return m.capacity() * (sizeof(std::pair<uint32_t, uint32_t>) + 1); }
+size_t bytes(const IntTable &m) { return m.capacity() * (sizeof(uint32_t) + sizeof(uint32_t)); }
+size_t bytes(const CompactSet &m) { return m.memory_usage(); }
+
+template <typename Map>
+static void Compact_Insertion(benchmark::State &state)
+{
+    const auto v = make_keys(state.range(0), 0);
+    double bpe = 0;
+    BM_PERF(state, v.size());
+    for (auto _ : state)
+    {
+        Map m;
+        for (size_t i = 0; i < v.size(); i++)
+            insert(m, v[i]);
+        bpe = static_cast<double>(bytes(m)) / static_cast<double>(v.size());
+    }
+    state.SetItemsProcessed(state.iterations() * v.size());
+    state.counters["bytes_per_entry"] = bpe;
+}
+
+// Lookups in shuffled order, half of them misses
+template <typename Map>
+static void Compact_Lookup(benchmark::State &state)
+{
+    const auto v = make_keys(state.range(0), 0);
+    Map m;
+    for (size_t i = 0; i < v.size(); i++)
+        insert(m, v[i]);
+
+    auto order = make_keys(state.range(0), 1ull << 31);
+    order.resize(v.size() / 2);
+    order.insert(order.end(), v.begin(), v.begin() + v.size() / 2);
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(7));
+    BM_PERF(state, order.size());
+    for (auto _ : state)
+        for (size_t i = 0; i < order.size(); i++)
+            benchmark::DoNotOptimize(contains(m, order[i]));
+    state.SetItemsProcessed(state.iterations() * order.size());
+    state.counters["bytes_per_entry"] = static_cast<double>(bytes(m)) / static_cast<double>(v.size());
+}
+
+#define BM_COMPACT(bm) BENCHMARK_TEMPLATE(bm, Table)->RangeMultiplier(16)->Range(1 << 16, 1 << 24)->Unit(benchmark::kMillisecond); \
+    BENCHMARK_TEMPLATE(bm, IntTable)->RangeMultiplier(16)->Range(1 << 16, 1 << 24)->Unit(benchmark::kMillisecond);                \
+    BENCHMARK_TEMPLATE(bm, CompactSet)->RangeMultiplier(16)->Range(1 << 16, 1 << 24)->Unit(benchmark::kMillisecond)
+
+BM_COMPACT(Compact_Insertion);
+BM_COMPACT(Compact_Lookup);
+
+BENCHMARK_MAIN();
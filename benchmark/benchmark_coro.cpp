@@ -0,0 +1,107 @@
+#include "benchmark/benchmark.h"
+#include "coro_find.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+// Lookups per iteration
+constexpr size_t CORO_OPS = 1 << 20;
+constexpr size_t CORO_BATCH = 16;
+
+using Table = HashTable::HashTable<uint64_t, uint64_t>;
+
+// Table of n random keys, shared by the benchmarks of one size, & a trace of lookups of present keys
+struct CoroData
+{
+    Table m;
+    std::vector<uint64_t> ops;
+};
+
+static const CoroData &coro_data(size_t n)
+{
+    static size_t cached_n = 0;
+    static CoroData d;
+    if (cached_n != n)
+    {
+        std::mt19937_64 gen(42);
+        std::vector<uint64_t> keys(n);
+        d.m = Table();
+        d.m.reserve(n);
+        for (auto &k : keys)
+        {
+            k = gen();
+            d.m.emplace(k, k);
+        }
+        d.ops.resize(CORO_OPS);
+        for (auto &op : d.ops)
+            op = keys[gen() % n];
+        cached_n = n;
+    }
+    return d;
+}
+
+// One find after another, each miss stalls the loop
+static void Coro_Sequential(benchmark::State &state)
+{
+    const auto &d = coro_data(state.range(0));
+    uint64_t sum = 0;
+    BM_PERF(state, d.ops.size());
+    for (auto _ : state)
+        for (const uint64_t k : d.ops)
+            sum += *d.m.find(k).value();
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * d.ops.size());
+}
+
+// Prefetch a batch of home slots, then find the batch. Needs every key of the batch up front
+static void Coro_BatchedPrefetch(benchmark::State &state)
+{
+    const auto &d = coro_data(state.range(0));
+    uint64_t sum = 0;
+    BM_PERF(state, d.ops.size());
+    for (auto _ : state)
+        for (size_t b = 0; b < d.ops.size(); b += CORO_BATCH)
+        {
+            size_t hashes[CORO_BATCH];
+            for (size_t i = 0; i < CORO_BATCH; i++)
+            {
+                hashes[i] = d.m.hash(d.ops[b + i]);
+                d.m.prefetch(hashes[i]);
+            }
+            for (size_t i = 0; i < CORO_BATCH; i++)
+                sum += *d.m.find(d.ops[b + i], hashes[i]).value();
+        }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * d.ops.size());
+}
+
+// co_find interleaved N at a time by the round-robin scheduler
+template <size_t N>
+static void Coro_Interleaved(benchmark::State &state)
+{
+    const auto &d = coro_data(state.range(0));
+    uint64_t sum = 0;
+    BM_PERF(state, d.ops.size());
+    for (auto _ : state)
+        HashTable::interleave<N>(
+            d.ops.size(), [&](size_t i)
+            { return HashTable::co_find(d.m, d.ops[i]); },
+            [&](size_t, std::optional<const uint64_t *> val)
+            { sum += *val.value(); });
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * d.ops.size());
+}
+
+// 64K keys fit in the caches & show the coroutine overhead, 16M keys take ~400 MB, far past the LLC
+#define CORO_BM(...) BENCHMARK(__VA_ARGS__)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMillisecond)
+CORO_BM(Coro_Sequential);
+CORO_BM(Coro_BatchedPrefetch);
+CORO_BM(Coro_Interleaved<4>);
+CORO_BM(Coro_Interleaved<8>);
+CORO_BM(Coro_Interleaved<16>);
+CORO_BM(Coro_Interleaved<32>);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,82 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "cuckoo_hashtable.h"
+#include "bm.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+constexpr size_t CUCKOO_TABLE_SIZE = 1 << 22;
+constexpr size_t CUCKOO_N_OPS = 1 << 20;
+
+using Table = HashTable::HashTable<uint64_t, uint64_t, HashTable::HighLoadPolicy>;
+using Cuckoo = HashTable::CuckooHashTable<uint64_t, uint64_t>;
+using Cuckoo4 = HashTable::CuckooHashTable<uint64_t, uint64_t, 4>;
+
+float load_factor(const Table &m) { return static_cast<float>(m.size()) / static_cast<float>(m.capacity()); }
+float load_factor(const Cuckoo &m) { return m.load_factor(); }
+float load_factor(const Cuckoo4 &m) { return m.load_factor(); }
+
+// Table sized for CUCKOO_TABLE_SIZE keys, filled with random keys up to state.range(0) percent load
+template <typename Map>
+Map make_table(float load, std::vector<uint64_t> &keys)
+{
+    Map m;
+    if constexpr (std::is_same_v<Map, Table>)
+        m.max_load_factor(0.99f);
+    m.reserve(CUCKOO_TABLE_SIZE);
+    std::mt19937_64 gen(42);
+    while (load_factor(m) < load)
+    {
+        keys.push_back(gen());
+        m.emplace(keys.back(), keys.size());
+    }
+    return m;
+}
+
+// Per lookup latency, half hits & half misses, reported as percentiles of the last iteration
+template <typename Map>
+static void Lookup_Latency(benchmark::State &state)
+{
+    const float load = static_cast<float>(state.range(0)) / 100;
+    std::vector<uint64_t> keys;
+    const Map m = make_table<Map>(load, keys);
+
+    std::mt19937_64 gen(7);
+    std::vector<uint64_t> ops(CUCKOO_N_OPS);
+    for (size_t i = 0; i < ops.size(); i++)
+        ops[i] = i % 2 ? keys[gen() % keys.size()] : gen();
+
+    std::vector<double> ns(ops.size());
+    size_t hits = 0;
+    BM_PERF(state, ops.size());
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < ops.size(); i++)
+        {
+            const auto t0 = std::chrono::steady_clock::now();
+            hits += m.find(ops[i]).has_value();
+            const auto t1 = std::chrono::steady_clock::now();
+            ns[i] = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        }
+    }
+    benchmark::DoNotOptimize(hits);
+
+    std::sort(ns.begin(), ns.end());
+    const auto pct = [&](double p)
+    { return ns[std::min(ns.size() - 1, static_cast<size_t>(p * static_cast<double>(ns.size())))]; };
+    state.counters["load"] = load_factor(m);
+    state.counters["p50_ns"] = pct(0.5);
+    state.counters["p99_ns"] = pct(0.99);
+    state.counters["p99.9_ns"] = pct(0.999);
+    state.counters["max_ns"] = ns.back();
+    state.SetItemsProcessed(state.iterations() * ops.size());
+}
+BENCHMARK_TEMPLATE(Lookup_Latency, Table)->Arg(90)->Arg(95)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(Lookup_Latency, Cuckoo)->Arg(90)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(Lookup_Latency, Cuckoo4)->Arg(90)->Arg(95)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,80 @@
+#include "benchmark/benchmark.h"
+#include "durable_hashtable.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// Directory on the local file system, under the system temp dir unless DURABLE_BM_DIR is set
+static fs::path bm_dir(const char *name)
+{
+    const char *base = std::getenv("DURABLE_BM_DIR");
+    const auto dir = (base ? fs::path(base) : fs::temp_directory_path()) / (std::string("durable_bm_") + name);
+    fs::remove_all(dir);
+    return dir;
+}
+
+// Logged inserts, one write & fdatasync per group of range(0) records
+static void Durable_Write_GroupCommit(benchmark::State &state)
+{
+    const size_t group = state.range(0);
+    const auto dir = bm_dir("write");
+    HashTable::DurableHashTable<uint64_t, uint64_t> m(dir, {group, 0});
+    uint64_t i = 0;
+    BM_PERF(state, 1);
+    for (auto _ : state)
+    {
+        m.emplace(i, i);
+        i += 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["fsyncs"] = benchmark::Counter(static_cast<double>(state.iterations()) / group, benchmark::Counter::kIsRate);
+}
+BENCHMARK(Durable_Write_GroupCommit)->RangeMultiplier(8)->Range(1, 4096);
+
+// The table without durability, the upper bound for the above
+static void Durable_Write_InMemory(benchmark::State &state)
+{
+    HashTable::HashTable<uint64_t, uint64_t> m;
+    uint64_t i = 0;
+    BM_PERF(state, 1);
+    for (auto _ : state)
+    {
+        m.emplace(i, i);
+        i += 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(Durable_Write_InMemory);
+
+// Reopen a table of range(0) entries, with range(1) percent of them in the log tail & the rest in the checkpoint
+static void Durable_Recovery(benchmark::State &state)
+{
+    const size_t n = state.range(0);
+    const size_t in_log = n * state.range(1) / 100;
+    const auto dir = bm_dir("recovery");
+    {
+        HashTable::DurableHashTable<uint64_t, uint64_t> m(dir, {4096, 0});
+        for (uint64_t i = 0; i < n - in_log; i++)
+            m.emplace(i, i);
+        m.checkpoint();
+        for (uint64_t i = n - in_log; i < n; i++)
+            m.emplace(i, i);
+    }
+
+    BM_PERF(state, n);
+    for (auto _ : state)
+    {
+        HashTable::DurableHashTable<uint64_t, uint64_t> m(dir);
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+    state.counters["disk_bytes"] = static_cast<double>(fs::file_size(dir / "checkpoint") + fs::file_size(dir / "wal"));
+    fs::remove_all(dir);
+}
+BENCHMARK(Durable_Recovery)->ArgsProduct({{1 << 16, 1 << 20, 1 << 23}, {0, 10, 100}})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,111 @@
+#include "benchmark/benchmark.h"
+#include "expiring_hashtable.h"
+#include "bm.h"
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+constexpr size_t TTL_KEYS = 1 << 18;
+constexpr size_t TTL_OPS = 1 << 20;
+constexpr size_t TTL_SCAN_PERIOD = 1 << 14;
+#define BM_TTL(bm) BENCHMARK(bm)
+
+// Clock ticking once per operation, so runs are deterministic
+struct OpClock
+{
+    using duration = std::chrono::duration<int64_t>;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<OpClock>;
+    static constexpr bool is_steady = true;
+
+    static inline time_point current{};
+    static time_point now() noexcept { return current; }
+    static void tick() noexcept { current += duration(1); }
+};
+
+// Mixed TTLs, short lived rate limit entries & long lived sessions
+std::vector<OpClock::duration> make_ttls(size_t n)
+{
+    std::mt19937_64 generator(42);
+    std::vector<OpClock::duration> ttls;
+    ttls.reserve(n);
+    for (size_t i = 0; i < n; i++)
+        ttls.emplace_back(generator() % 4 == 0 ? 1000 + generator() % 100000 : 10 + generator() % 1000);
+    return ttls;
+}
+
+// Baseline: deadline stored in the value & a full table sweep on a timer
+static void HashTable_Expiry_FullScan(benchmark::State &state)
+{
+    const auto trace = make_zipf_trace(TTL_KEYS, TTL_OPS, 0.8);
+    const auto ttls = make_ttls(TTL_OPS);
+    BM_PERF(state, trace.size());
+    for (auto _ : state)
+    {
+        HashTable::HashTable<uint64_t, std::pair<uint64_t, OpClock::time_point>> m;
+        for (size_t i = 0; i < trace.size(); i++)
+        {
+            OpClock::tick();
+            const auto now = OpClock::now();
+            const auto v = m.find(trace[i]);
+            if (!v || v.value()->second <= now)
+                m.emplace(trace[i], std::pair(trace[i], now + ttls[i]));
+            if (i % TTL_SCAN_PERIOD == 0)
+                m.erase_if([now](uint64_t, const std::pair<uint64_t, OpClock::time_point> &e) { return e.second <= now; });
+        }
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * trace.size());
+}
+BM_TTL(HashTable_Expiry_FullScan);
+
+// Lazy expiry on find & bounded sweep on emplace, arg is the sweep budget
+static void ExpiringHashTable_Expiry(benchmark::State &state)
+{
+    const auto trace = make_zipf_trace(TTL_KEYS, TTL_OPS, 0.8);
+    const auto ttls = make_ttls(TTL_OPS);
+    size_t max_size = 0;
+    BM_PERF(state, trace.size());
+    for (auto _ : state)
+    {
+        HashTable::ExpiringHashTable<uint64_t, uint64_t, OpClock> m;
+        m.sweep_budget(state.range(0));
+        for (size_t i = 0; i < trace.size(); i++)
+        {
+            OpClock::tick();
+            if (!m.find(trace[i]))
+                m.emplace(trace[i], trace[i], ttls[i]);
+            max_size = std::max(max_size, m.size());
+        }
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * trace.size());
+    state.counters["max_size"] = max_size;
+}
+BM_TTL(ExpiringHashTable_Expiry)->Arg(0)->Arg(2)->Arg(8)->Arg(32);
+
+// Lookup latency on a populated table where a quarter of the entries are expired
+static void ExpiringHashTable_Lookup(benchmark::State &state)
+{
+    const auto ttls = make_ttls(TTL_KEYS);
+    HashTable::ExpiringHashTable<uint64_t, uint64_t, OpClock> m;
+    m.sweep_budget(0);
+    for (uint64_t i = 0; i < TTL_KEYS; i++)
+        m.emplace(i * 0x9E3779B97F4A7C15ull, i, ttls[i] + OpClock::duration(1000000));
+    OpClock::current += OpClock::duration(1000000 + 800);
+
+    size_t i = 0;
+    BM_PERF(state, 1);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(m.find(i * 0x9E3779B97F4A7C15ull));
+        i = (i + 1) % TTL_KEYS;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BM_TTL(ExpiringHashTable_Lookup);
+
+BENCHMARK_MAIN();
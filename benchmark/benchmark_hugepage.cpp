@@ -0,0 +1,40 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#ifndef HUGEPAGE_TABLE_SIZE
+#define HUGEPAGE_TABLE_SIZE (1 << 24) // 16M entries, a slot array of about 500 MB, far past the 4 KB page TLB reach
+#endif
+constexpr size_t HUGEPAGE_N_OPS = 1 << 20;
+
+// Random hits into a table far larger than the TLB reach, each lookup a likely TLB miss with 4 KB pages
+template <typename Alloc>
+static void Lookup_Random_PageSize(benchmark::State &state)
+{
+    HashTable::HashTable<uint64_t, uint64_t, HashTable::PowerOfTwoPolicy, Alloc> m;
+    m.reserve(HUGEPAGE_TABLE_SIZE);
+    for (uint64_t i = 0; i < HUGEPAGE_TABLE_SIZE; i++)
+        m.emplace(i * 0x9E3779B97F4A7C15ull, i);
+
+    std::mt19937_64 gen(42);
+    std::vector<uint64_t> ops(HUGEPAGE_N_OPS);
+    for (auto &op : ops)
+        op = (gen() % HUGEPAGE_TABLE_SIZE) * 0x9E3779B97F4A7C15ull;
+
+    BM_PERF(state, ops.size());
+    for (auto _ : state)
+        for (size_t i = 0; i < ops.size(); i++)
+            benchmark::DoNotOptimize(m.find(ops[i]));
+    state.SetItemsProcessed(state.iterations() * ops.size());
+}
+BENCHMARK_TEMPLATE(Lookup_Random_PageSize, HashTable::HeapAlloc)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(Lookup_Random_PageSize, HashTable::MmapAlloc<HashTable::HugePages::None>)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(Lookup_Random_PageSize, HashTable::MmapAlloc<HashTable::HugePages::Transparent>)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(Lookup_Random_PageSize, HashTable::MmapAlloc<HashTable::HugePages::Explicit>)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(Lookup_Random_PageSize, HashTable::MmapAlloc<HashTable::HugePages::Transparent, HashTable::Numa::Interleave>)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
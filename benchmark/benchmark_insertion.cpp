@@ -14,6 +14,7 @@ static void Map_Insertion_StringView(benchmark::State &state)
 {
     size_t s = state.range(0);
     const auto v = make_rand_vec(VEC_SIZE, s);
+    BM_PERF(state, v.size());
     for (auto _ : state)
     {
         std::vector<std::string> v_copy = v;
@@ -28,6 +29,7 @@ static void HashTable_Insertion_StringView(benchmark::State &state)
 {
     size_t s = state.range(0);
     const auto v = make_rand_vec(VEC_SIZE, s);
+    BM_PERF(state, v.size());
     for (auto _ : state)
     {
         std::vector<std::string> v_copy = v;
@@ -42,6 +44,7 @@ static void Map_Insertion_String(benchmark::State &state)
 {
     size_t s = state.range(0);
     const auto v = make_rand_vec(VEC_SIZE, s);
+    BM_PERF(state, v.size());
     for (auto _ : state)
     {
         std::vector<std::string> v_copy = v;
@@ -56,6 +59,7 @@ static void HashTable_Insertion_String(benchmark::State &state)
 {
     size_t s = state.range(0);
     const auto v = make_rand_vec(VEC_SIZE, s);
+    BM_PERF(state, v.size());
     for (auto _ : state)
     {
         std::vector<std::string> v_copy = v;
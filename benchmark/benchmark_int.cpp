@@ -0,0 +1,84 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "int_hashtable.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#define BM_INT(bm) BENCHMARK(bm)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)
+
+std::vector<uint64_t> make_rand_int_vec(size_t vec_size)
+{
+    std::mt19937_64 generator(42);
+    std::vector<uint64_t> v(vec_size);
+    for (auto &x : v)
+        x = generator() % (UINT64_MAX - 1); // Keep clear of the default sentinels
+    return v;
+}
+
+template <typename Map>
+static void Insertion(benchmark::State &state)
+{
+    const auto v = make_rand_int_vec(state.range(0));
+    BM_PERF(state, v.size());
+    for (auto _ : state)
+    {
+        Map m;
+        for (size_t i = 0; i < v.size(); i++)
+            m.emplace(v[i], i);
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * v.size());
+}
+
+template <typename Map>
+static void Lookup(benchmark::State &state)
+{
+    const auto v = make_rand_int_vec(state.range(0));
+    Map m;
+    for (size_t i = 0; i < v.size(); i++)
+        m.emplace(v[i], i);
+
+    // Shuffle so lookups do not follow insertion order
+    auto order = v;
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(7));
+    BM_PERF(state, order.size());
+    for (auto _ : state)
+        for (const uint64_t k : order)
+            benchmark::DoNotOptimize(m.find(k));
+    state.SetItemsProcessed(state.iterations() * v.size());
+}
+
+// Dense keys 0..n-1, then lookups of n..2n-1 which all miss
+template <typename Map>
+static void DenseMiss(benchmark::State &state)
+{
+    const uint64_t n = state.range(0);
+    Map m;
+    for (uint64_t i = 0; i < n; i++)
+        m.emplace(i, i);
+    BM_PERF(state, n);
+    for (auto _ : state)
+        for (uint64_t k = n; k < 2 * n; k++)
+            benchmark::DoNotOptimize(m.find(k));
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+using StdMap = std::unordered_map<uint64_t, uint64_t>;
+using Table = HashTable::HashTable<uint64_t, uint64_t>;
+using IntTable = HashTable::IntHashTable<uint64_t, uint64_t>;
+
+BM_INT(Insertion<StdMap>);
+BM_INT(Insertion<Table>);
+BM_INT(Insertion<IntTable>);
+BM_INT(Lookup<StdMap>);
+BM_INT(Lookup<Table>);
+BM_INT(Lookup<IntTable>);
+BENCHMARK(DenseMiss<StdMap>)->RangeMultiplier(8)->Range(1 << 10, 1 << 16);
+BENCHMARK(DenseMiss<Table>)->RangeMultiplier(8)->Range(1 << 10, 1 << 16);
+BENCHMARK(DenseMiss<IntTable>)->RangeMultiplier(8)->Range(1 << 10, 1 << 16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,118 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "string_interner.h"
+#include "bm.h"
+
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <cassert>
+#include <vector>
+#include <optional>
+
+constexpr size_t INTERN_VEC_SIZE = 1 << 16;
+constexpr size_t INTERN_REPEAT = 4;
+
+// Symbol table built from a table of owned strings & a vector of owned strings for ID to string
+class NaiveInterner
+{
+private:
+    HashTable::HashTable<std::string, uint32_t> m_ids;
+    std::vector<std::string> m_strings;
+
+public:
+    uint32_t intern(std::string_view s)
+    {
+        std::string key(s);
+        const auto id = m_ids.find(key);
+        if (id.has_value())
+            return *id.value();
+        const uint32_t new_id = static_cast<uint32_t>(m_strings.size());
+        m_strings.push_back(key);
+        m_ids.emplace(std::move(key), new_id);
+        return new_id;
+    }
+
+    std::optional<uint32_t> find(std::string_view s) const
+    {
+        const auto id = m_ids.find(std::string(s));
+        if (!id.has_value())
+            return std::nullopt;
+        return *id.value();
+    }
+
+    std::string_view resolve(uint32_t id) const { return m_strings[id]; }
+
+    size_t size() const { return m_strings.size(); }
+
+    // Slots, control bytes, the ID vector & heap buffers of strings past the SSO limit
+    size_t memory_usage() const
+    {
+        size_t heap = 0;
+        for (const auto &s : m_strings)
+            heap += s.capacity() > 15 ? 2 * (s.capacity() + 1) : 0;
+        return m_ids.capacity() * (sizeof(std::pair<std::string, uint32_t>) + 1) + m_strings.capacity() * sizeof(std::string) + heap;
+    }
+};
+
+// Each string is interned INTERN_REPEAT times, as symbols recur in real input
+template <typename Interner>
+static void Interner_Insertion(benchmark::State &state)
+{
+    const auto v = make_rand_vec(INTERN_VEC_SIZE, state.range(0));
+    double bps = 0;
+    BM_PERF(state, v.size() * INTERN_REPEAT);
+    for (auto _ : state)
+    {
+        Interner interner;
+        for (size_t r = 0; r < INTERN_REPEAT; r++)
+            for (size_t i = 0; i < v.size(); i++)
+                benchmark::DoNotOptimize(interner.intern(v[i]));
+        bps = static_cast<double>(interner.memory_usage()) / static_cast<double>(interner.size());
+    }
+    state.SetItemsProcessed(state.iterations() * v.size() * INTERN_REPEAT);
+    state.counters["bytes_per_string"] = bps;
+}
+
+template <typename Interner>
+static void Interner_Lookup(benchmark::State &state)
+{
+    const auto v = make_rand_vec(INTERN_VEC_SIZE, state.range(0));
+    Interner interner;
+    for (size_t i = 0; i < v.size(); i++)
+        interner.intern(v[i]);
+
+    BM_PERF(state, v.size());
+    for (auto _ : state)
+        for (size_t i = 0; i < v.size(); i++)
+        {
+            const auto id = interner.find(v[i]);
+            assert(id);
+            benchmark::DoNotOptimize(id);
+        }
+    state.SetItemsProcessed(state.iterations() * v.size());
+}
+
+template <typename Interner>
+static void Interner_Resolve(benchmark::State &state)
+{
+    const auto v = make_rand_vec(INTERN_VEC_SIZE, state.range(0));
+    Interner interner;
+    for (size_t i = 0; i < v.size(); i++)
+        interner.intern(v[i]);
+
+    BM_PERF(state, v.size());
+    for (auto _ : state)
+        for (uint32_t i = 0; i < v.size(); i++)
+            benchmark::DoNotOptimize(interner.resolve(i));
+    state.SetItemsProcessed(state.iterations() * v.size());
+}
+
+BENCHMARK_TEMPLATE(Interner_Insertion, NaiveInterner)->Arg(8 - 1)->Arg(32 - 1)->Arg(128 - 1);
+BENCHMARK_TEMPLATE(Interner_Insertion, HashTable::StringInterner)->Arg(8 - 1)->Arg(32 - 1)->Arg(128 - 1);
+BENCHMARK_TEMPLATE(Interner_Lookup, NaiveInterner)->Arg(8 - 1)->Arg(32 - 1)->Arg(128 - 1);
+BENCHMARK_TEMPLATE(Interner_Lookup, HashTable::StringInterner)->Arg(8 - 1)->Arg(32 - 1)->Arg(128 - 1);
+BENCHMARK_TEMPLATE(Interner_Resolve, NaiveInterner)->Arg(8 - 1)->Arg(32 - 1)->Arg(128 - 1);
+BENCHMARK_TEMPLATE(Interner_Resolve, HashTable::StringInterner)->Arg(8 - 1)->Arg(32 - 1)->Arg(128 - 1);
+
+BENCHMARK_MAIN();
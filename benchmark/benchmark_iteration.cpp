@@ -0,0 +1,78 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+constexpr size_t ITER_TABLE_SIZE = 1 << 20;
+#define BM_ITER(bm) BENCHMARK(bm)->Arg(1)->Arg(10)->Arg(50)->Arg(85)
+
+// Table filled to 85% load, then thinned out to the given load percentage
+HashTable::HashTable<uint64_t, uint64_t, HashTable::PowerOfTwoPolicy> make_table(size_t load_pct)
+{
+    HashTable::HashTable<uint64_t, uint64_t, HashTable::PowerOfTwoPolicy> m;
+    m.max_load_factor(0.9);
+    std::mt19937_64 gen(42);
+    const size_t n = ITER_TABLE_SIZE * 85 / 100;
+    for (size_t i = 0; i < n; i++)
+        m.emplace(gen(), i);
+    const size_t keep = ITER_TABLE_SIZE * load_pct / 100;
+    m.erase_if([keep](uint64_t, uint64_t v) { return v >= keep; });
+    return m;
+}
+
+static void Map_Iteration(benchmark::State &state)
+{
+    // Setup
+    const auto t = make_table(state.range(0));
+    std::unordered_map<uint64_t, uint64_t> m;
+    for (const auto [k, v] : t.key_values())
+        m.emplace(k, v);
+
+    BM_PERF(state, m.size());
+    for (auto _ : state)
+    {
+        uint64_t sum = 0;
+        for (const auto &[k, v] : m)
+            sum += v;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * m.size());
+}
+BM_ITER(Map_Iteration);
+
+static void HashTable_Iteration(benchmark::State &state)
+{
+    // Setup
+    const auto m = make_table(state.range(0));
+
+    BM_PERF(state, m.size());
+    for (auto _ : state)
+    {
+        uint64_t sum = 0;
+        for (const auto [k, v] : m.key_values())
+            sum += v;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * m.size());
+}
+BM_ITER(HashTable_Iteration);
+
+static void HashTable_EraseIf(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto m = make_table(85);
+        state.ResumeTiming();
+        const size_t keep = ITER_TABLE_SIZE * state.range(0) / 100;
+        benchmark::DoNotOptimize(m.erase_if([keep](uint64_t, uint64_t v) { return v >= keep; }));
+    }
+    state.SetItemsProcessed(state.iterations() * ITER_TABLE_SIZE * 85 / 100);
+}
+BM_ITER(HashTable_EraseIf);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,135 @@
+#include "benchmark/benchmark.h"
+#include "hash_join.h"
+#include "bm.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Probe rows per iteration, half of them match one build row
+constexpr size_t JOIN_PROBE_ROWS = 1 << 22;
+
+// n distinct build keys & the probe keys, shared by the benchmarks of one build size
+struct JoinData
+{
+    std::vector<uint64_t> build;
+    std::vector<uint64_t> probe;
+};
+
+static const JoinData &join_data(size_t n)
+{
+    static size_t cached = 0;
+    static JoinData d;
+    if (cached != n)
+    {
+        std::mt19937_64 gen(42);
+        d.build.resize(n);
+        for (auto &k : d.build)
+            k = gen() | 1;
+        d.probe.resize(JOIN_PROBE_ROWS);
+        for (auto &k : d.probe)
+            k = gen() % 2 ? d.build[gen() % n] : gen() & ~uint64_t(1); // Even keys never match
+        cached = n;
+    }
+    return d;
+}
+
+static size_t n_threads() { return std::max(std::thread::hardware_concurrency(), 1u); }
+
+// Backends
+// Each builds from a key column & probes another into match pairs
+
+// emplace per build row & find per probe row
+struct FindPerRow
+{
+    HashTable::HashTable<uint64_t, uint32_t> m;
+
+    void build(const std::vector<uint64_t> &keys)
+    {
+        m = HashTable::HashTable<uint64_t, uint32_t>();
+        for (size_t i = 0; i < keys.size(); i++)
+            m.emplace(keys[i], static_cast<uint32_t>(i));
+    }
+
+    [[nodiscard]] size_t probe(const std::vector<uint64_t> &keys) const
+    {
+        HashTable::JoinMatches out;
+        for (size_t i = 0; i < keys.size(); i++)
+            if (const auto r = m.find(keys[i]))
+            {
+                out.build.push_back(*r.value());
+                out.probe.push_back(static_cast<uint32_t>(i));
+            }
+        return out.size();
+    }
+};
+
+template <bool PARALLEL>
+struct Hash
+{
+    HashTable::HashJoin<uint64_t> j;
+
+    void build(const std::vector<uint64_t> &keys) { j.build(keys.data(), keys.size()); }
+
+    [[nodiscard]] size_t probe(const std::vector<uint64_t> &keys) const
+    {
+        if constexpr (PARALLEL)
+            return j.parallel_probe(keys.data(), keys.size(), n_threads()).size();
+        HashTable::JoinMatches out;
+        j.probe(keys.data(), keys.size(), out);
+        return out.size();
+    }
+};
+
+template <bool PARALLEL>
+struct Radix
+{
+    HashTable::RadixHashJoin<uint64_t> j;
+
+    void build(const std::vector<uint64_t> &keys) { j.build(keys.data(), keys.size(), PARALLEL ? n_threads() : 1); }
+    [[nodiscard]] size_t probe(const std::vector<uint64_t> &keys) const { return j.probe(keys.data(), keys.size(), PARALLEL ? n_threads() : 1).size(); }
+};
+
+template <typename B>
+static void Join_Build(benchmark::State &state)
+{
+    const auto &d = join_data(state.range(0));
+    BM_PERF(state, d.build.size());
+    for (auto _ : state)
+    {
+        B b;
+        b.build(d.build);
+        benchmark::DoNotOptimize(b);
+    }
+    state.SetItemsProcessed(state.iterations() * d.build.size());
+}
+
+template <typename B>
+static void Join_Probe(benchmark::State &state)
+{
+    const auto &d = join_data(state.range(0));
+    B b;
+    b.build(d.build);
+    size_t matches = 0;
+    BM_PERF(state, d.probe.size());
+    for (auto _ : state)
+        matches = b.probe(d.probe);
+    state.SetItemsProcessed(state.iterations() * d.probe.size());
+    state.counters["matches"] = static_cast<double>(matches);
+}
+
+// 10K build rows stay in L2, 100M take several GB
+#define JOIN_BM(bm, ...) BENCHMARK_TEMPLATE(bm, __VA_ARGS__)->Arg(10'000)->Arg(100'000)->Arg(1'000'000)->Arg(10'000'000)->Arg(100'000'000)->UseRealTime()->Unit(benchmark::kMillisecond)
+JOIN_BM(Join_Build, FindPerRow);
+JOIN_BM(Join_Build, Hash<false>);
+JOIN_BM(Join_Build, Radix<false>);
+JOIN_BM(Join_Build, Radix<true>);
+JOIN_BM(Join_Probe, FindPerRow);
+JOIN_BM(Join_Probe, Hash<false>);
+JOIN_BM(Join_Probe, Hash<true>);
+JOIN_BM(Join_Probe, Radix<false>);
+JOIN_BM(Join_Probe, Radix<true>);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,72 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "bm.h"
+
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <cassert>
+#include <vector>
+
+constexpr size_t LF_VEC_SIZE = 1 << 16;
+constexpr size_t LF_STR_SIZE = 16 - 1;
+#define BM_LF(bm) BENCHMARK_TEMPLATE(bm, HashTable::DefaultPolicy)->DenseRange(50, 90, 10); \
+    BENCHMARK_TEMPLATE(bm, HashTable::PowerOfTwoPolicy)->DenseRange(50, 90, 10);             \
+    BENCHMARK_TEMPLATE(bm, HashTable::PrimePolicy)->DenseRange(50, 90, 10);                  \
+    BENCHMARK_TEMPLATE(bm, HashTable::FrugalPolicy)->DenseRange(50, 90, 10);                 \
+    BENCHMARK_TEMPLATE(bm, HashTable::HighLoadPolicy)->DenseRange(50, 90, 10)->Arg(95)
+
+// Bytes held by the slot array & control bytes, per entry
+template <typename K, typename V, typename P>
+double bytes_per_entry(const HashTable::HashTable<K, V, P> &m)
+{
+    return static_cast<double>(m.capacity() * (sizeof(std::pair<K, V>) + 1)) / static_cast<double>(m.size());
+}
+
+template <typename Policy>
+static void HashTable_Insertion_LoadFactor(benchmark::State &state)
+{
+    const float lf = static_cast<float>(state.range(0)) / 100;
+    const auto v = make_rand_vec(LF_VEC_SIZE, LF_STR_SIZE);
+    double bpe = 0;
+    BM_PERF(state, v.size());
+    for (auto _ : state)
+    {
+        HashTable::HashTable<std::string_view, size_t, Policy> m;
+        m.max_load_factor(lf);
+        for (size_t i = 0; i < v.size(); i++)
+            m.emplace(v[i], i);
+        bpe = bytes_per_entry(m);
+    }
+    state.counters["ns_per_op"] = benchmark::Counter(static_cast<double>(v.size()), benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.counters["bytes_per_entry"] = bpe;
+}
+BM_LF(HashTable_Insertion_LoadFactor);
+
+template <typename Policy>
+static void HashTable_Lookup_LoadFactor(benchmark::State &state)
+{
+    // Setup
+    const float lf = static_cast<float>(state.range(0)) / 100;
+    const auto v = make_rand_vec(LF_VEC_SIZE, LF_STR_SIZE);
+    HashTable::HashTable<std::string_view, size_t, Policy> m;
+    m.max_load_factor(lf);
+    for (size_t i = 0; i < v.size(); i++)
+        m.emplace(v[i], i);
+
+    BM_PERF(state, v.size());
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < v.size(); i++)
+        {
+            const auto val = m.find(v[i]);
+            assert(val);
+            benchmark::DoNotOptimize(val);
+        }
+    }
+    state.counters["ns_per_op"] = benchmark::Counter(static_cast<double>(v.size()), benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.counters["bytes_per_entry"] = bytes_per_entry(m);
+}
+BM_LF(HashTable_Lookup_LoadFactor);
+
+BENCHMARK_MAIN();
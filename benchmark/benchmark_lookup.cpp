@@ -24,6 +24,7 @@ static void Map_Lookup_StringView(benchmark::State &state)
         m.emplace(s1, s2);
     }
 
+    BM_PERF(state, v1.size());
     for (auto _ : state)
     {
         for (size_t i = 0; i < v1.size(); i++)
@@ -50,6 +51,7 @@ static void HashTable_Lookup_StringView(benchmark::State &state)
         m.emplace(s1, s2);
     }
 
+    BM_PERF(state, v1.size());
     for (auto _ : state)
     {
         for (size_t i = 0; i < v1.size(); i++)
@@ -76,6 +78,7 @@ static void Map_Lookup_String(benchmark::State &state)
         m.emplace(s1, s2);
     }
 
+    BM_PERF(state, v1.size());
     for (auto _ : state)
     {
         for (size_t i = 0; i < v1.size(); i++)
@@ -102,6 +105,7 @@ static void HashTable_Lookup_String(benchmark::State &state)
         m.emplace(s1, s2);
     }
 
+    BM_PERF(state, v1.size());
     for (auto _ : state)
     {
         for (size_t i = 0; i < v1.size(); i++)
@@ -0,0 +1,142 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "alloc_count.h"
+#include "workload.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+template <typename K>
+using Table = HashTable::HashTable<K, uint64_t>;
+template <typename K>
+using Map = std::unordered_map<K, uint64_t>;
+
+static void memory_sizes(benchmark::internal::Benchmark *b) { b->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20); }
+
+// Nothing to add for tables without memory_usage()
+template <typename M>
+static void report_memory_usage(benchmark::State &, const M &, size_t) {}
+
+template <typename K, typename V, typename P, typename A>
+static void report_memory_usage(benchmark::State &state, const HashTable::HashTable<K, V, P, A> &m, size_t n)
+{
+    state.counters["table_bytes_per_entry"] = static_cast<double>(m.memory_usage()) / n;
+    state.counters["owned_bytes_per_entry"] = static_cast<double>(m.memory_usage(true) - m.memory_usage()) / n;
+}
+
+// Build a table of n keys from empty. Reports the heap allocations per insert, with the key copies & the rehashes, then
+// the heap bytes per entry of the built table & the peak while it grew
+template <typename M, typename K>
+static void Memory_Insert(benchmark::State &state)
+{
+    const size_t n = state.range(0);
+    const auto keys = workload::make_keys<K>(0, n);
+    size_t allocs = 0;
+    for (auto _ : state)
+    {
+        const size_t before = alloc_count::allocations;
+        auto m = std::make_unique<M>();
+        for (size_t i = 0; i < n; i++)
+            m->emplace(keys[i], i);
+        allocs += alloc_count::allocations - before;
+        state.PauseTiming();
+        m.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+    state.counters["allocs_per_insert"] = static_cast<double>(allocs) / (state.iterations() * n);
+
+    const size_t before = alloc_count::live_bytes;
+    alloc_count::reset_peak();
+    M m;
+    for (size_t i = 0; i < n; i++)
+        m.emplace(keys[i], i);
+    state.counters["bytes_per_entry"] = static_cast<double>(alloc_count::live_bytes - before) / n;
+    state.counters["peak_bytes_per_entry"] = static_cast<double>(alloc_count::peak_bytes - before) / n;
+    report_memory_usage(state, m, n);
+}
+BENCHMARK_TEMPLATE(Memory_Insert, Table<uint64_t>, uint64_t)->Apply(memory_sizes);
+BENCHMARK_TEMPLATE(Memory_Insert, Map<uint64_t>, uint64_t)->Apply(memory_sizes);
+BENCHMARK_TEMPLATE(Memory_Insert, Table<std::string>, std::string)->Apply(memory_sizes);
+BENCHMARK_TEMPLATE(Memory_Insert, Map<std::string>, std::string)->Apply(memory_sizes);
+
+// Lookups of present string keys. Looking up a const char * builds a std::string temporary per lookup, the allocations
+// per lookup show the hidden copies
+template <typename M, bool CSTR>
+static void Memory_Lookup(benchmark::State &state)
+{
+    const size_t n = state.range(0);
+    const auto keys = workload::make_keys<std::string>(0, n);
+    std::vector<const char *> cstrs;
+    for (const auto &k : keys)
+        cstrs.push_back(k.c_str());
+    M m;
+    for (size_t i = 0; i < n; i++)
+        m.emplace(keys[i], i);
+
+    const size_t before = alloc_count::allocations;
+    BM_PERF(state, n);
+    for (auto _ : state)
+        for (size_t i = 0; i < n; i++)
+        {
+            if constexpr (CSTR)
+                benchmark::DoNotOptimize(m.find(cstrs[i]));
+            else
+                benchmark::DoNotOptimize(m.find(keys[i]));
+        }
+    state.SetItemsProcessed(state.iterations() * n);
+    state.counters["allocs_per_lookup"] = static_cast<double>(alloc_count::allocations - before) / (state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(Memory_Lookup, Table<std::string>, false)->Apply(memory_sizes);
+BENCHMARK_TEMPLATE(Memory_Lookup, Table<std::string>, true)->Apply(memory_sizes);
+BENCHMARK_TEMPLATE(Memory_Lookup, Map<std::string>, false)->Apply(memory_sizes);
+BENCHMARK_TEMPLATE(Memory_Lookup, Map<std::string>, true)->Apply(memory_sizes);
+
+// One rehash of a table of n keys to about twice its capacity. The old & new slot arrays are both live while the elements
+// move, the peak is reported per entry next to the steady bytes per entry after the rehash
+template <typename K>
+static void Memory_Rehash(benchmark::State &state)
+{
+    using Slots = alloc_count::SlotAlloc<>;
+    using T = HashTable::HashTable<K, uint64_t, HashTable::DefaultPolicy, Slots>;
+    const size_t n = state.range(0);
+    const auto keys = workload::make_keys<K>(0, n);
+    T base;
+    for (size_t i = 0; i < n; i++)
+        base.emplace(keys[i], i);
+
+    size_t slot_peak = 0;
+    size_t heap_peak = 0;
+    size_t steady = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto m = std::make_unique<T>(base);
+        const size_t slot_others = Slots::live_bytes - m->memory_usage(); // Arrays of the other tables
+        const size_t heap_before = alloc_count::live_bytes;
+        Slots::reset_peak();
+        alloc_count::reset_peak();
+        state.ResumeTiming();
+
+        m->reserve(2 * n);
+
+        state.PauseTiming();
+        slot_peak = std::max(slot_peak, Slots::peak_bytes - slot_others);
+        heap_peak = std::max(heap_peak, alloc_count::peak_bytes - heap_before);
+        steady = m->memory_usage();
+        m.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+    state.counters["steady_bytes_per_entry"] = static_cast<double>(steady) / n;
+    state.counters["rehash_peak_bytes_per_entry"] = static_cast<double>(slot_peak) / n;
+    state.counters["rehash_new_heap_bytes_per_entry"] = static_cast<double>(heap_peak) / n;
+}
+BENCHMARK_TEMPLATE(Memory_Rehash, uint64_t)->Apply(memory_sizes);
+BENCHMARK_TEMPLATE(Memory_Rehash, std::string)->Apply(memory_sizes);
+
+BENCHMARK_MAIN();
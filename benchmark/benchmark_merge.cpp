@@ -0,0 +1,87 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#ifndef MERGE_PARTIAL_SIZE
+#define MERGE_PARTIAL_SIZE (1 << 20)
+#endif
+constexpr size_t MERGE_N_PARTIALS = 32;
+
+using Table = HashTable::HashTable<uint64_t, uint64_t>;
+
+// Per-thread style partial counts, keys from a universe of range(0) times the partial size, so partials overlap
+static std::vector<Table> make_partials(size_t universe_factor)
+{
+    std::vector<Table> partials(MERGE_N_PARTIALS);
+    std::mt19937_64 gen(42);
+    for (auto &p : partials)
+    {
+        p.reserve(MERGE_PARTIAL_SIZE);
+        while (p.size() < MERGE_PARTIAL_SIZE)
+            p.emplace(gen() % (MERGE_PARTIAL_SIZE * universe_factor), uint64_t(1));
+    }
+    return partials;
+}
+
+// key_values() & emplace per element, the way merges were written before merge()
+static void Merge_Emplace(benchmark::State &state)
+{
+    BM_PERF(state, MERGE_N_PARTIALS * MERGE_PARTIAL_SIZE);
+    for (auto _ : state)
+    {
+        BM_PERF_PAUSE(state);
+        auto partials = make_partials(state.range(0));
+        BM_PERF_RESUME(state);
+
+        Table result;
+        for (auto &p : partials)
+            for (auto [k, v] : p.key_values())
+            {
+                if (auto cur = result.find(k))
+                    *cur.value() += v;
+                else
+                    result.emplace(k, v);
+            }
+        benchmark::DoNotOptimize(result.size());
+        state.counters["result_size"] = static_cast<double>(result.size());
+
+        BM_PERF_PAUSE(state);
+        partials.clear();
+        result = Table();
+        BM_PERF_RESUME(state);
+    }
+    state.SetItemsProcessed(state.iterations() * MERGE_N_PARTIALS * MERGE_PARTIAL_SIZE);
+}
+BENCHMARK(Merge_Emplace)->Arg(2)->Arg(8)->Arg(64)->Iterations(2)->Unit(benchmark::kMillisecond);
+
+// merge() with a summing reducer
+static void Merge_Bulk(benchmark::State &state)
+{
+    BM_PERF(state, MERGE_N_PARTIALS * MERGE_PARTIAL_SIZE);
+    for (auto _ : state)
+    {
+        BM_PERF_PAUSE(state);
+        auto partials = make_partials(state.range(0));
+        BM_PERF_RESUME(state);
+
+        Table result;
+        for (auto &p : partials)
+            result.merge(std::move(p), [](uint64_t &val, uint64_t &&other)
+                         { val += other; });
+        benchmark::DoNotOptimize(result.size());
+        state.counters["result_size"] = static_cast<double>(result.size());
+
+        BM_PERF_PAUSE(state);
+        partials.clear();
+        result = Table();
+        BM_PERF_RESUME(state);
+    }
+    state.SetItemsProcessed(state.iterations() * MERGE_N_PARTIALS * MERGE_PARTIAL_SIZE);
+}
+BENCHMARK(Merge_Bulk)->Arg(2)->Arg(8)->Arg(64)->Iterations(2)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
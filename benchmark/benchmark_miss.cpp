@@ -0,0 +1,70 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "bloom_filter.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <cassert>
+#include <random>
+#include <vector>
+
+constexpr size_t MISS_TABLE_SIZE = 1 << 22;
+constexpr size_t MISS_N_OPS = 1 << 20;
+
+// Scramble so keys do not form one cluster under the identity hash
+constexpr uint64_t scramble(uint64_t i) noexcept { return i * 0x9E3779B97F4A7C15ull; }
+
+// Lookups where state.range(0) percent of the keys are absent, in random order
+template <typename Map>
+static void run_lookups(benchmark::State &state, Map &m, uint64_t first_key)
+{
+    std::mt19937_64 gen(42);
+    std::vector<uint64_t> ops(MISS_N_OPS);
+    for (size_t i = 0; i < ops.size(); i++)
+    {
+        const bool miss = static_cast<int64_t>(gen() % 100) < state.range(0);
+        ops[i] = scramble(first_key + gen() % MISS_TABLE_SIZE + (miss ? 2 * MISS_TABLE_SIZE : 0));
+    }
+
+    size_t hits = 0;
+    BM_PERF(state, ops.size());
+    for (auto _ : state)
+        for (size_t i = 0; i < ops.size(); i++)
+            hits += m.find(ops[i]).has_value();
+    benchmark::DoNotOptimize(hits);
+    state.SetItemsProcessed(state.iterations() * ops.size());
+}
+
+template <typename Map>
+static void Lookup_MissRatio(benchmark::State &state)
+{
+    Map m;
+    for (uint64_t i = 0; i < MISS_TABLE_SIZE; i++)
+        m.emplace(scramble(i), i);
+    run_lookups(state, m, 0);
+}
+
+// Same lookups after the table churned through as many removals & inserts as it holds keys, so probe chains run through deleted slots
+template <typename Map>
+static void Lookup_MissRatio_Churned(benchmark::State &state)
+{
+    Map m;
+    for (uint64_t i = 0; i < MISS_TABLE_SIZE; i++)
+        m.emplace(scramble(i), i);
+    for (uint64_t i = 0; i < MISS_TABLE_SIZE; i++)
+    {
+        m.remove(scramble(i));
+        m.emplace(scramble(MISS_TABLE_SIZE + i), i);
+    }
+    run_lookups(state, m, MISS_TABLE_SIZE);
+}
+
+#define BM_MISS(bm) BENCHMARK_TEMPLATE(bm, HashTable::HashTable<uint64_t, uint64_t>)->Arg(0)->Arg(50)->Arg(90)->Arg(99)->Arg(100);                                   \
+    BENCHMARK_TEMPLATE(bm, HashTable::FilteredHashTable<uint64_t, uint64_t>)->Arg(0)->Arg(50)->Arg(90)->Arg(99)->Arg(100);                                          \
+    BENCHMARK_TEMPLATE(bm, HashTable::HashTable<uint64_t, uint64_t, HashTable::HighLoadPolicy>)->Arg(0)->Arg(50)->Arg(90)->Arg(99)->Arg(100); \
+    BENCHMARK_TEMPLATE(bm, HashTable::FilteredHashTable<uint64_t, uint64_t, HashTable::HighLoadPolicy>)->Arg(0)->Arg(50)->Arg(90)->Arg(99)->Arg(100)
+
+BM_MISS(Lookup_MissRatio);
+BM_MISS(Lookup_MissRatio_Churned);
+
+BENCHMARK_MAIN();
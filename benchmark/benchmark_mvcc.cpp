@@ -0,0 +1,114 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "mvcc_hashtable.h"
+#include "bm.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+// Readers scan a consistent view while one writer churns, inserting key i & removing key i - n, so the table stays at n keys
+
+// Readers pin an epoch & never block the writer
+struct MvccBackend
+{
+    HashTable::MvccHashTable<uint64_t, uint64_t> m;
+
+    void insert(uint64_t k) { m.emplace(k, k); }
+    void remove(uint64_t k) { m.remove(k); }
+
+    [[nodiscard]] uint64_t scan() const
+    {
+        uint64_t sum = 0;
+        m.pin().for_each([&](uint64_t key, uint64_t val) { sum += key ^ val; });
+        return sum;
+    }
+};
+
+// One global reader-writer lock around a plain table, a scan holds out the writer until it ends
+struct LockedBackend
+{
+    HashTable::HashTable<uint64_t, uint64_t> m;
+    mutable std::shared_mutex mutex;
+
+    void insert(uint64_t k)
+    {
+        std::unique_lock lock(mutex);
+        m.emplace(k, k);
+    }
+    void remove(uint64_t k)
+    {
+        std::unique_lock lock(mutex);
+        m.remove(k);
+    }
+
+    [[nodiscard]] uint64_t scan() const
+    {
+        std::shared_lock lock(mutex);
+        uint64_t sum = 0;
+        for (const auto [key, val] : m)
+            sum += key ^ val;
+        return sum;
+    }
+};
+
+template <typename Backend>
+struct ChurnFixture
+{
+    static inline std::unique_ptr<Backend> backend;
+    static inline std::thread writer;
+    static inline std::atomic<bool> stop{false};
+    static inline std::atomic<uint64_t> writes{0};
+
+    static void start(uint64_t n)
+    {
+        backend = std::make_unique<Backend>();
+        for (uint64_t i = 0; i < n; i++)
+            backend->insert(i);
+        stop = false;
+        writes = 0;
+        writer = std::thread([n] {
+            for (uint64_t i = n; !stop.load(std::memory_order_relaxed); i++)
+            {
+                backend->insert(i);
+                backend->remove(i - n);
+                writes.fetch_add(2, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    static uint64_t finish()
+    {
+        stop = true;
+        writer.join();
+        backend.reset();
+        return writes.load();
+    }
+};
+
+// Full scans of range(0) keys per reader thread. Reports keys scanned & writer operations per second
+template <typename Backend>
+static void Scan_UnderWrites(benchmark::State &state)
+{
+    using Fixture = ChurnFixture<Backend>;
+    const uint64_t n = state.range(0);
+    if (state.thread_index() == 0)
+        Fixture::start(n);
+
+    BM_PERF(state, n);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Fixture::backend->scan());
+    state.SetItemsProcessed(state.iterations() * n);
+
+    if (state.thread_index() == 0)
+        state.counters["writes"] = benchmark::Counter(static_cast<double>(Fixture::finish()), benchmark::Counter::kIsRate);
+}
+
+#define SCAN_BM(backend) BENCHMARK_TEMPLATE(Scan_UnderWrites, backend)->Arg(1 << 12)->Arg(1 << 16)->ThreadRange(1, 4)->UseRealTime()->Unit(benchmark::kMicrosecond)
+SCAN_BM(MvccBackend);
+SCAN_BM(LockedBackend);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,73 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#ifndef PAR_TABLE_SIZE
+#define PAR_TABLE_SIZE 100'000'000
+#endif
+#define BM_PAR(bm) BENCHMARK(bm)->RangeMultiplier(2)->Range(1, std::max(std::thread::hardware_concurrency(), 1u))->UseRealTime()->Unit(benchmark::kMillisecond)
+
+using Table = HashTable::HashTable<uint64_t, uint64_t, HashTable::HighLoadPolicy>;
+
+// Built once & shared by all benchmarks, the table is too large to rebuild per run
+Table &table()
+{
+    static Table m = []() {
+        Table t;
+        t.reserve(PAR_TABLE_SIZE);
+        for (uint64_t i = 0; i < PAR_TABLE_SIZE; i++)
+            t.emplace(i * 0x9E3779B97F4A7C15ull, i);
+        return t;
+    }();
+    return m;
+}
+
+static void HashTable_Sum_Partition(benchmark::State &state)
+{
+    // Setup
+    const Table &m = table();
+    const size_t n = state.range(0);
+
+    BM_PERF(state, m.size());
+    for (auto _ : state)
+    {
+        const auto ranges = m.partition(n);
+        std::vector<uint64_t> sums(n, 0);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < n; i++)
+            threads.emplace_back([&, i]() {
+                uint64_t sum = 0;
+                for (const auto [k, v] : ranges[i])
+                    sum += v;
+                sums[i] = sum;
+            });
+        for (auto &t : threads)
+            t.join();
+
+        uint64_t total = 0;
+        for (const uint64_t s : sums)
+            total += s;
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * m.size());
+}
+BM_PAR(HashTable_Sum_Partition);
+
+static void HashTable_Update_ParallelForEach(benchmark::State &state)
+{
+    // Setup
+    Table &m = table();
+    const size_t n = state.range(0);
+
+    BM_PERF(state, m.size());
+    for (auto _ : state)
+        m.parallel_for_each([](const uint64_t &, uint64_t &v) { v += 1; }, n);
+    state.SetItemsProcessed(state.iterations() * m.size());
+}
+BM_PAR(HashTable_Update_ParallelForEach);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+#include "benchmark/benchmark.h"
+#include "partitioned_hashtable.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// hash % n, the hand routing consistent hashing replaces. Nearly every key moves when n changes
+struct ModuloRouter
+{
+    [[nodiscard]] static constexpr uint32_t route(uint64_t hash, uint32_t n) noexcept { return static_cast<uint32_t>(hash % n); }
+};
+
+static const std::vector<uint64_t> &partitioned_keys(size_t n)
+{
+    static std::vector<uint64_t> keys;
+    if (keys.size() != n)
+    {
+        std::mt19937_64 gen(42);
+        keys.resize(n);
+        for (auto &k : keys)
+            k = gen();
+    }
+    return keys;
+}
+
+// Grow n keys from range(1) to range(2) partitions. Reports the share of keys moved & the moved keys & batch bytes per second
+template <typename Router>
+static void Migrate(benchmark::State &state)
+{
+    const auto &keys = partitioned_keys(state.range(0));
+    const uint32_t from = static_cast<uint32_t>(state.range(1));
+    const uint32_t to = static_cast<uint32_t>(state.range(2));
+    HashTable::MigrationStats stats;
+    BM_PERF(state, keys.size());
+    for (auto _ : state)
+    {
+        BM_PERF_PAUSE(state);
+        HashTable::PartitionedHashTable<uint64_t, uint64_t, Router> m(from);
+        for (const uint64_t k : keys)
+            m.emplace(k, k);
+        BM_PERF_RESUME(state);
+        stats = m.resize(to);
+        benchmark::DoNotOptimize(m);
+    }
+    state.SetItemsProcessed(state.iterations() * stats.keys_moved);
+    state.SetBytesProcessed(state.iterations() * stats.bytes);
+    state.counters["moved"] = static_cast<double>(stats.keys_moved) / static_cast<double>(keys.size());
+}
+
+#define MIGRATE_BM(router) BENCHMARK_TEMPLATE(Migrate, router)->ArgsProduct({{1'000'000, 10'000'000}, {8}, {9, 16}})->Args({1'000'000, 64, 65})->Iterations(3)->Unit(benchmark::kMillisecond)
+MIGRATE_BM(HashTable::JumpRouter);
+MIGRATE_BM(HashTable::RendezvousRouter);
+MIGRATE_BM(ModuloRouter);
+
+BENCHMARK_MAIN();
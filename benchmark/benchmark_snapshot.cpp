@@ -0,0 +1,110 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "snapshot_hashtable.h"
+#include "bm.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+constexpr size_t SNAPSHOT_N_WRITES = 1 << 12;
+
+// Consistent view by the copy constructor, a deep copy of every slot
+static void Snapshot_FullCopy(benchmark::State &state)
+{
+    const size_t n = state.range(0);
+    HashTable::HashTable<uint64_t, uint64_t> m;
+    for (uint64_t i = 0; i < n; i++)
+        m.emplace(i, i);
+
+    BM_PERF(state, 1);
+    for (auto _ : state)
+    {
+        const auto copy = m;
+        benchmark::DoNotOptimize(copy.size());
+    }
+    state.counters["bytes_copied"] = static_cast<double>(m.capacity() * (2 * sizeof(uint64_t) + 1));
+}
+BENCHMARK(Snapshot_FullCopy)->RangeMultiplier(16)->Range(1 << 12, 1 << 22)->Unit(benchmark::kMicrosecond);
+
+// Consistent view by snapshot(), one shared pointer per segment
+static void Snapshot_CopyOnWrite(benchmark::State &state)
+{
+    const size_t n = state.range(0);
+    HashTable::SnapshotHashTable<uint64_t, uint64_t> m;
+    for (uint64_t i = 0; i < n; i++)
+        m.emplace(i, i);
+
+    BM_PERF(state, 1);
+    for (auto _ : state)
+    {
+        const auto snap = m.snapshot();
+        benchmark::DoNotOptimize(snap.size());
+    }
+    state.counters["segments"] = static_cast<double>(m.segments());
+}
+BENCHMARK(Snapshot_CopyOnWrite)->RangeMultiplier(16)->Range(1 << 12, 1 << 22)->Unit(benchmark::kMicrosecond);
+
+// Random updates after a snapshot, every first write to a segment copies it.
+// write_amp is the bytes copied per byte updated, against a full copy of the table
+static void Snapshot_WriteAmplification(benchmark::State &state)
+{
+    const size_t n = state.range(0);
+    const size_t n_writes = state.range(1);
+    using Table = HashTable::SnapshotHashTable<uint64_t, uint64_t>;
+    Table m;
+    for (uint64_t i = 0; i < n; i++)
+        m.emplace(i, i);
+
+    std::mt19937_64 gen(42);
+    std::vector<uint64_t> keys(n_writes);
+    for (auto &k : keys)
+        k = gen() % n;
+
+    size_t copied = 0;
+    BM_PERF(state, n_writes);
+    for (auto _ : state)
+    {
+        BM_PERF_PAUSE(state);
+        const size_t before = m.segments_copied();
+        auto snap = m.snapshot();
+        BM_PERF_RESUME(state);
+
+        for (const auto k : keys)
+            m.emplace(k, k + 1);
+
+        BM_PERF_PAUSE(state);
+        copied += m.segments_copied() - before;
+        snap = Table::Snapshot();
+        BM_PERF_RESUME(state);
+    }
+    const double iters = static_cast<double>(state.iterations());
+    state.counters["bytes_copied"] = copied * Table::segment_bytes() / iters;
+    state.counters["write_amp"] = copied * Table::segment_bytes() / iters / (n_writes * 2 * sizeof(uint64_t));
+    state.counters["vs_full_copy"] = copied / iters / m.segments();
+    state.SetItemsProcessed(state.iterations() * n_writes);
+}
+BENCHMARK(Snapshot_WriteAmplification)->ArgsProduct({{1 << 16, 1 << 22}, {1, 1 << 8, SNAPSHOT_N_WRITES}})->Unit(benchmark::kMicrosecond);
+
+// Same updates without a live snapshot, the cost of writes in place
+static void Snapshot_WriteNoSnapshot(benchmark::State &state)
+{
+    const size_t n = state.range(0);
+    HashTable::SnapshotHashTable<uint64_t, uint64_t> m;
+    for (uint64_t i = 0; i < n; i++)
+        m.emplace(i, i);
+
+    std::mt19937_64 gen(42);
+    std::vector<uint64_t> keys(SNAPSHOT_N_WRITES);
+    for (auto &k : keys)
+        k = gen() % n;
+
+    BM_PERF(state, keys.size());
+    for (auto _ : state)
+        for (const auto k : keys)
+            m.emplace(k, k + 1);
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(Snapshot_WriteNoSnapshot)->Arg(1 << 16)->Arg(1 << 22)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,131 @@
+#include "benchmark/benchmark.h"
+#include "sorted_index.h"
+#include "bm.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Key span of a range scan, about 1000 of 1M uniform keys
+constexpr uint64_t SCAN_SPAN = uint64_t(1000) << 44;
+
+template <typename K>
+static K make_key(std::mt19937_64 &gen)
+{
+    if constexpr (std::is_same_v<K, std::string>)
+        return std::to_string(gen());
+    else
+        return static_cast<K>(gen());
+}
+
+template <typename K>
+static const HashTable::HashTable<K, uint64_t> &sorted_table(size_t n)
+{
+    static size_t cached = 0;
+    static HashTable::HashTable<K, uint64_t> m;
+    if (cached != n)
+    {
+        std::mt19937_64 gen(42);
+        m = HashTable::HashTable<K, uint64_t>();
+        while (m.size() < n)
+            m.emplace(make_key<K>(gen), m.size());
+        cached = n;
+    }
+    return m;
+}
+
+// Copy the elements out & std::sort them
+template <typename K>
+static void Export_CopySort(benchmark::State &state)
+{
+    const auto &m = sorted_table<K>(state.range(0));
+    BM_PERF(state, m.size());
+    for (auto _ : state)
+    {
+        std::vector<std::pair<K, uint64_t>> kvs;
+        kvs.reserve(m.size());
+        for (const auto [key, val] : m)
+            kvs.emplace_back(key, val);
+        std::sort(kvs.begin(), kvs.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        benchmark::DoNotOptimize(kvs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * m.size());
+}
+
+template <typename K>
+static void Export_Sorted(benchmark::State &state)
+{
+    const auto &m = sorted_table<K>(state.range(0));
+    BM_PERF(state, m.size());
+    for (auto _ : state)
+    {
+        auto kvs = m.sorted();
+        benchmark::DoNotOptimize(kvs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * m.size());
+}
+
+// The copy the table is extracted from is made with the timer paused
+template <typename K>
+static void Export_ExtractSorted(benchmark::State &state)
+{
+    const auto &m = sorted_table<K>(state.range(0));
+    BM_PERF(state, m.size());
+    for (auto _ : state)
+    {
+        BM_PERF_PAUSE(state);
+        HashTable::HashTable<K, uint64_t> copy = m;
+        BM_PERF_RESUME(state);
+        auto kvs = copy.extract_sorted();
+        benchmark::DoNotOptimize(kvs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * m.size());
+}
+
+// Range scans from random keys, each sorting the table in full vs one sorted index
+static void Scan_FullSort(benchmark::State &state)
+{
+    const auto &m = sorted_table<uint64_t>(state.range(0));
+    std::mt19937_64 gen(7);
+    uint64_t sum = 0;
+    BM_PERF(state, 1);
+    for (auto _ : state)
+    {
+        const uint64_t lo = gen();
+        const auto kvs = m.sorted();
+        for (auto it = std::lower_bound(kvs.begin(), kvs.end(), std::pair(lo, uint64_t(0))); it != kvs.end() && it->first - lo < SCAN_SPAN; ++it)
+            sum += it->second;
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void Scan_SortedIndex(benchmark::State &state)
+{
+    const auto &m = sorted_table<uint64_t>(state.range(0));
+    HashTable::SortedIndex index(m);
+    std::mt19937_64 gen(7);
+    uint64_t sum = 0;
+    BM_PERF(state, 1);
+    for (auto _ : state)
+    {
+        const uint64_t lo = gen();
+        index.range(lo, lo + std::min(SCAN_SPAN, ~lo), [&](uint64_t, uint64_t val) { sum += val; });
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+
+#define SORTED_BM(bm, ...) BENCHMARK_TEMPLATE(bm, __VA_ARGS__)->Arg(10'000)->Arg(1'000'000)->Arg(10'000'000)->Unit(benchmark::kMillisecond)
+SORTED_BM(Export_CopySort, uint64_t);
+SORTED_BM(Export_Sorted, uint64_t);
+SORTED_BM(Export_ExtractSorted, uint64_t);
+SORTED_BM(Export_CopySort, std::string);
+SORTED_BM(Export_Sorted, std::string);
+BENCHMARK(Scan_FullSort)->Arg(1'000'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(Scan_SortedIndex)->Arg(1'000'000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,143 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "string_hashtable.h"
+#include "bm.h"
+
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <cassert>
+#include <vector>
+
+constexpr size_t LARGE_VEC_SIZE = 1 << 20;
+
+static void HashTable_Insertion_StringKey(benchmark::State &state)
+{
+    size_t s = state.range(0);
+    const auto v = make_rand_vec(VEC_SIZE, s);
+    BM_PERF(state, v.size());
+    for (auto _ : state)
+    {
+        HashTable::HashTable<std::string, std::string_view> m;
+        for (size_t i = 0; i < v.size(); i++)
+            m.emplace(v[i], v[i]);
+    }
+}
+BM(HashTable_Insertion_StringKey);
+
+static void StringHashTable_Insertion_StringKey(benchmark::State &state)
+{
+    size_t s = state.range(0);
+    const auto v = make_rand_vec(VEC_SIZE, s);
+    BM_PERF(state, v.size());
+    for (auto _ : state)
+    {
+        HashTable::StringHashTable<std::string_view> m;
+        for (size_t i = 0; i < v.size(); i++)
+            m.emplace(v[i], v[i]);
+    }
+}
+BM(StringHashTable_Insertion_StringKey);
+
+static void HashTable_Lookup_StringKey(benchmark::State &state)
+{
+    // Setup
+    size_t s = state.range(0);
+    const auto v1 = make_rand_vec(VEC_SIZE, s);
+    const auto v2 = make_rand_vec(VEC_SIZE, s);
+    HashTable::HashTable<std::string, std::string_view> m;
+    for (size_t i = 0; i < v1.size(); i++)
+        m.emplace(v1[i], v2[i]);
+
+    BM_PERF(state, v1.size());
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < v1.size(); i++)
+        {
+            const auto val = m.find(v1[i]);
+            assert(val);
+            benchmark::DoNotOptimize(val);
+        }
+    }
+}
+BM(HashTable_Lookup_StringKey);
+
+static void StringHashTable_Lookup_StringKey(benchmark::State &state)
+{
+    // Setup
+    size_t s = state.range(0);
+    const auto v1 = make_rand_vec(VEC_SIZE, s);
+    const auto v2 = make_rand_vec(VEC_SIZE, s);
+    HashTable::StringHashTable<std::string_view> m;
+    for (size_t i = 0; i < v1.size(); i++)
+        m.emplace(v1[i], v2[i]);
+
+    BM_PERF(state, v1.size());
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < v1.size(); i++)
+        {
+            const auto val = m.find(v1[i]);
+            assert(val);
+            benchmark::DoNotOptimize(val);
+        }
+    }
+}
+BM(StringHashTable_Lookup_StringKey);
+
+// Lookups of absent keys, where the length & prefix reject most candidates
+static void HashTable_Miss_StringKey(benchmark::State &state)
+{
+    size_t s = state.range(0);
+    const auto v1 = make_rand_vec(VEC_SIZE, s);
+    const auto v2 = make_rand_vec(VEC_SIZE, s);
+    HashTable::HashTable<std::string, size_t> m;
+    for (size_t i = 0; i < v1.size(); i++)
+        m.emplace(v1[i], i);
+
+    BM_PERF(state, v2.size());
+    for (auto _ : state)
+        for (size_t i = 0; i < v2.size(); i++)
+            benchmark::DoNotOptimize(m.find(v2[i]));
+}
+BM(HashTable_Miss_StringKey);
+
+static void StringHashTable_Miss_StringKey(benchmark::State &state)
+{
+    size_t s = state.range(0);
+    const auto v1 = make_rand_vec(VEC_SIZE, s);
+    const auto v2 = make_rand_vec(VEC_SIZE, s);
+    HashTable::StringHashTable<size_t> m;
+    for (size_t i = 0; i < v1.size(); i++)
+        m.emplace(v1[i], i);
+
+    BM_PERF(state, v2.size());
+    for (auto _ : state)
+        for (size_t i = 0; i < v2.size(); i++)
+            benchmark::DoNotOptimize(m.find(v2[i]));
+}
+BM(StringHashTable_Miss_StringKey);
+
+// Table far larger than cache, where std::string keys past the SSO limit cost an extra miss per compare
+template <typename Map>
+static void Lookup_Large_StringKey(benchmark::State &state)
+{
+    size_t s = state.range(0);
+    const auto v = make_rand_vec(LARGE_VEC_SIZE, s);
+    Map m;
+    for (size_t i = 0; i < v.size(); i++)
+        m.emplace(v[i], i);
+
+    // Look up in a different order than insertion, so heap allocated keys are not visited in allocation order
+    auto order = v;
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(7));
+    BM_PERF(state, order.size());
+    for (auto _ : state)
+        for (size_t i = 0; i < order.size(); i++)
+            benchmark::DoNotOptimize(m.find(order[i]));
+    state.SetItemsProcessed(state.iterations() * order.size());
+}
+BENCHMARK_TEMPLATE(Lookup_Large_StringKey, HashTable::HashTable<std::string, size_t>)->Arg(15)->Arg(23)->Arg(31);
+BENCHMARK_TEMPLATE(Lookup_Large_StringKey, HashTable::StringHashTable<size_t>)->Arg(15)->Arg(23)->Arg(31);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,167 @@
+#include "benchmark/benchmark.h"
+#include "hashtable.h"
+#include "alloc_count.h"
+#include "workload.h"
+#include "perf_counters.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Workload matrix over table sizes, key types, distributions, hit ratios, read/write mixes & churn, against std::unordered_map &
+// a textbook open addressing table. Reports throughput, p50/p99/p99.9 per-op latency & heap bytes per entry.
+// BM_SUITE_MAX_SIZE caps the table sizes, 1M by default & 100M for the full matrix. BM_SUITE_OPS sets the trace length
+
+static size_t env_size(const char *name, size_t fallback)
+{
+    const char *v = std::getenv(name);
+    return v ? static_cast<size_t>(std::strtoull(v, nullptr, 10)) : fallback;
+}
+
+static const size_t SUITE_MAX_SIZE = env_size("BM_SUITE_MAX_SIZE", 1 << 20);
+static const size_t SUITE_OPS = env_size("BM_SUITE_OPS", 1 << 20);
+static const std::vector<size_t> SUITE_SIZES = {1 << 10, 1 << 15, 1 << 20, 1 << 25, 100'000'000};
+
+// Ring of 2n keys for tables of n, only the latest size is kept as the benchmarks run size by size
+template <typename K>
+static const std::vector<K> &key_ring(size_t n)
+{
+    static size_t cached_n = 0;
+    static std::vector<K> keys;
+    if (cached_n != n)
+    {
+        keys = std::vector<K>();
+        keys = workload::make_keys<K>(0, 2 * n);
+        cached_n = n;
+    }
+    return keys;
+}
+
+static void set_latency(benchmark::State &state, std::vector<uint32_t> &ns)
+{
+    const auto p = workload::percentiles(ns);
+    state.counters["p50_ns"] = p.p50;
+    state.counters["p99_ns"] = p.p99;
+    state.counters["p999_ns"] = p.p999;
+    state.counters["max_ns"] = p.max;
+}
+
+// Build a table of n keys from empty, growth included
+template <typename Backend, typename K>
+static void Suite_Insert(benchmark::State &state, size_t n)
+{
+    const auto &keys = key_ring<K>(n);
+    for (auto _ : state)
+    {
+        auto b = std::make_unique<Backend>();
+        for (size_t i = 0; i < n; i++)
+            b->insert(keys[i], i);
+        state.PauseTiming();
+        b.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+
+    // Heap bytes of a built table, & the peak while it grew
+    {
+        const size_t before = alloc_count::live_bytes;
+        alloc_count::reset_peak();
+        auto b = std::make_unique<Backend>();
+        for (size_t i = 0; i < n; i++)
+            b->insert(keys[i], i);
+        state.counters["bytes_per_entry"] = static_cast<double>(alloc_count::live_bytes - before) / n;
+        state.counters["peak_bytes_per_entry"] = static_cast<double>(alloc_count::peak_bytes - before) / n;
+    }
+
+    // Timed build, the tail percentiles show the rehash pauses
+    std::vector<workload::Op> ops(n);
+    for (size_t i = 0; i < n; i++)
+        ops[i] = {workload::OpKind::Update, i};
+    auto b = std::make_unique<Backend>();
+    workload::Runner<Backend, K> r(*b, keys, n);
+    size_t sink = 0;
+    auto ns = r.timed(ops, sink);
+    set_latency(state, ns);
+}
+
+// Run a trace against a table loaded with n keys
+template <typename Backend, typename K>
+static void Suite_Trace(benchmark::State &state, size_t n, workload::Mix mix)
+{
+    const auto &keys = key_ring<K>(n);
+    const size_t before = alloc_count::live_bytes;
+    auto b = std::make_unique<Backend>();
+    for (size_t i = 0; i < n; i++)
+        b->insert(keys[i], i);
+    const double bytes = static_cast<double>(alloc_count::live_bytes - before) / n;
+
+    const auto ops = workload::make_trace(n, SUITE_OPS, mix);
+    workload::Runner<Backend, K> r(*b, keys, n);
+    size_t sink = 0;
+    {
+        BM_PERF(state, ops.size()); // Counts the loop only, not the latency pass below
+        for (auto _ : state)
+            for (const auto &op : ops)
+                sink += r.run(op);
+    }
+    state.SetItemsProcessed(state.iterations() * ops.size());
+
+    auto ns = r.timed(ops, sink);
+    set_latency(state, ns);
+    state.counters["bytes_per_entry"] = bytes;
+    benchmark::DoNotOptimize(sink);
+}
+
+struct NamedMix
+{
+    const char *name;
+    workload::Mix mix;
+};
+
+static const NamedMix SUITE_MIXES[] = {
+    {"find_hit", {1, 1, false, workload::Dist::Uniform}},
+    {"find_hit_zipf", {1, 1, false, workload::Dist::Zipf}},
+    {"find_miss50", {1, 0.5, false, workload::Dist::Uniform}},
+    {"find_miss", {1, 0, false, workload::Dist::Uniform}},
+    {"mixed_r95_zipf", {0.95, 1, false, workload::Dist::Zipf}},
+    {"mixed_r50", {0.5, 1, false, workload::Dist::Uniform}},
+    {"churn_r50", {0.5, 1, true, workload::Dist::Uniform}},
+};
+
+template <typename Backend, typename K>
+static void register_backend(const std::string &key_name, size_t n)
+{
+    const std::string suffix = "/" + key_name + "/" + Backend::NAME + "/n:" + std::to_string(n);
+    benchmark::RegisterBenchmark(("Suite/insert" + suffix).c_str(), [n](benchmark::State &state)
+                                 { Suite_Insert<Backend, K>(state, n); })
+        ->Unit(benchmark::kMillisecond);
+    for (const auto &m : SUITE_MIXES)
+        benchmark::RegisterBenchmark(("Suite/" + std::string(m.name) + suffix).c_str(), [n, mix = m.mix](benchmark::State &state)
+                                     { Suite_Trace<Backend, K>(state, n, mix); })
+            ->Unit(benchmark::kMillisecond);
+}
+
+template <typename K>
+static void register_key(const std::string &key_name)
+{
+    for (const size_t n : SUITE_SIZES)
+    {
+        if (n > SUITE_MAX_SIZE)
+            break;
+        register_backend<workload::HashTableBackend<K, uint64_t>, K>(key_name, n);
+        register_backend<workload::UnorderedMapBackend<K, uint64_t>, K>(key_name, n);
+        register_backend<workload::RefOpenBackend<K, uint64_t>, K>(key_name, n);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    register_key<uint64_t>("int");
+    register_key<std::string>("string");
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+}
@@ -29,6 +29,7 @@ static void Map_Update_StringView(benchmark::State &state)
         m.emplace(vkey[i], voval[i]);
 
     size_t i = 0;
+    BM_PERF(state, vkey.size());
     for (auto _ : state)
     {
         std::vector<std::string> &vnval = new_val_vecs[i++ % new_val_vecs.size()];
@@ -60,6 +61,7 @@ static void HashTable_Update_StringView(benchmark::State &state)
         m.emplace(vkey[i], voval[i]);
 
     size_t i = 0;
+    BM_PERF(state, vkey.size());
     for (auto _ : state)
     {
         std::vector<std::string> &vnval = new_val_vecs[i++ % new_val_vecs.size()];
@@ -88,6 +90,7 @@ static void Map_Update_String(benchmark::State &state)
         m.emplace(vkey[i], voval[i]);
 
     size_t i = 0;
+    BM_PERF(state, vkey.size());
     for (auto _ : state)
     {
         std::vector<std::string> &vnval = new_val_vecs[i++ % new_val_vecs.size()];
@@ -119,6 +122,7 @@ static void HashTable_Update_String(benchmark::State &state)
         m.emplace(vkey[i], voval[i]);
 
     size_t i = 0;
+    BM_PERF(state, vkey.size());
     for (auto _ : state)
     {
         std::vector<std::string> &vnval = new_val_vecs[i++ % new_val_vecs.size()];
@@ -1,6 +1,9 @@
 
 #include "benchmark/benchmark.h"
+#include "perf_counters.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <random>
 #include <string>
@@ -36,4 +39,28 @@ std::vector<std::string> make_rand_vec(size_t vec_size, size_t str_size)
         v.push_back(generateRandomString(str_size));
     }
     return v;
-}
\ No newline at end of file
+}
+// Trace of n_ops keys drawn from [0, n_keys) with Zipfian skew s, key 0 being the most popular
+std::vector<uint64_t> make_zipf_trace(size_t n_keys, size_t n_ops, double s, uint64_t seed = 42)
+{
+    // Build the cumulative distribution
+    std::vector<double> cdf(n_keys);
+    double sum = 0;
+    for (size_t i = 0; i < n_keys; i++)
+    {
+        sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+        cdf[i] = sum;
+    }
+
+    // Sample by inverting the distribution, then scatter ranks so popular keys are not adjacent
+    std::mt19937_64 generator(seed);
+    std::uniform_real_distribution<double> distribution(0, sum);
+    std::vector<uint64_t> trace;
+    trace.reserve(n_ops);
+    for (size_t i = 0; i < n_ops; i++)
+    {
+        const size_t rank = std::lower_bound(cdf.begin(), cdf.end(), distribution(generator)) - cdf.begin();
+        trace.push_back(static_cast<uint64_t>(std::min(rank, n_keys - 1)) * 0x9E3779B97F4A7C15ull);
+    }
+    return trace;
+}
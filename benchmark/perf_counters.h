@@ -0,0 +1,205 @@
+#pragma once
+
+// Hardware counters around a benchmark loop, read through perf_event_open & reported as per-op user counters, so they land in
+// the JSON or CSV output next to the times. Each event is opened alone, an event the CPU, kernel or container refuses is left
+// out & the others are still reported. BM_PERF=0 in the environment turns collection off
+
+#include "benchmark/benchmark.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class PerfCounters
+{
+public:
+    struct Event
+    {
+        const char *name;
+        uint32_t type;
+        uint64_t config;
+        int fd;
+    };
+
+private:
+    std::vector<Event> m_events;
+
+#if defined(__linux__)
+    static constexpr uint64_t cache_miss(uint64_t cache) noexcept
+    {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+
+    // Counts of the calling thread & the threads it starts, user space only so it works under perf_event_paranoid 2
+    static int open_event(uint32_t type, uint64_t config) noexcept
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    PerfCounters()
+    {
+        const char *env = std::getenv("BM_PERF");
+        if (env != nullptr && std::strcmp(env, "0") == 0)
+            return;
+
+#if defined(__linux__)
+        const Event wanted[] = {
+            {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1},
+            {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1},
+            {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, -1},
+            {"l1d_misses", PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D), -1},
+            {"llc_misses", PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL), -1},
+            {"dtlb_misses", PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_DTLB), -1},
+        };
+        std::string missing;
+        for (Event e : wanted)
+        {
+            e.fd = open_event(e.type, e.config);
+            if (e.fd >= 0)
+                m_events.push_back(e);
+            else
+                missing += std::string(missing.empty() ? "" : ", ") + e.name + " (" + std::strerror(errno) + ")";
+        }
+        if (!missing.empty())
+            std::fprintf(stderr, "perf counters unavailable: %s\n", missing.c_str());
+#else
+        std::fprintf(stderr, "perf counters unavailable: not Linux\n");
+#endif
+    }
+
+public:
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+    ~PerfCounters()
+    {
+#if defined(__linux__)
+        for (const Event &e : m_events)
+            close(e.fd);
+#endif
+    }
+
+    // Opened once per process, the first benchmark pays for the syscalls
+    static PerfCounters &instance()
+    {
+        static PerfCounters counters;
+        return counters;
+    }
+
+    [[nodiscard]] const std::vector<Event> &events() const noexcept { return m_events; }
+
+    void start() noexcept
+    {
+#if defined(__linux__)
+        for (const Event &e : m_events)
+            ioctl(e.fd, PERF_EVENT_IOC_RESET, 0);
+        for (const Event &e : m_events)
+            ioctl(e.fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    // Stop & restart counting without a reset, around work the benchmark does not time
+    void pause() noexcept
+    {
+#if defined(__linux__)
+        for (const Event &e : m_events)
+            ioctl(e.fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+    }
+    void resume() noexcept
+    {
+#if defined(__linux__)
+        for (const Event &e : m_events)
+            ioctl(e.fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    // Counts since start(), scaled up when the kernel multiplexed more events than the CPU has counters
+    [[nodiscard]] std::vector<double> stop() noexcept
+    {
+        std::vector<double> counts;
+#if defined(__linux__)
+        for (const Event &e : m_events)
+            ioctl(e.fd, PERF_EVENT_IOC_DISABLE, 0);
+        for (const Event &e : m_events)
+        {
+            uint64_t v[3] = {0, 0, 0}; // Value, time enabled, time running
+            if (read(e.fd, v, sizeof(v)) != static_cast<ssize_t>(sizeof(v)) || v[2] == 0)
+                counts.push_back(0);
+            else
+                counts.push_back(static_cast<double>(v[0]) * static_cast<double>(v[1]) / static_cast<double>(v[2]));
+        }
+#endif
+        return counts;
+    }
+};
+
+// Counts the rest of the enclosing scope & reports every counter per operation, plus IPC. Put it right before the timing loop,
+// as ops_per_iter operations are assumed per iteration
+class PerfScope
+{
+private:
+    benchmark::State &m_state;
+    double m_ops_per_iter;
+
+public:
+    PerfScope(benchmark::State &state, size_t ops_per_iter) noexcept : m_state(state), m_ops_per_iter(static_cast<double>(ops_per_iter))
+    {
+        PerfCounters::instance().start();
+    }
+
+    ~PerfScope()
+    {
+        auto &perf = PerfCounters::instance();
+        const auto counts = perf.stop();
+        const double ops = static_cast<double>(m_state.iterations()) * m_ops_per_iter;
+        if (counts.empty() || ops == 0)
+            return;
+
+        double cycles = 0;
+        double instructions = 0;
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            const std::string name = perf.events()[i].name;
+            m_state.counters[name + "_per_op"] = counts[i] / ops;
+            if (name == "cycles")
+                cycles = counts[i];
+            else if (name == "instructions")
+                instructions = counts[i];
+        }
+        if (cycles > 0 && instructions > 0)
+            m_state.counters["ipc"] = instructions / cycles;
+    }
+
+    PerfScope(const PerfScope &) = delete;
+    PerfScope &operator=(const PerfScope &) = delete;
+};
+
+#define BM_PERF_CONCAT_(a, b) a##b
+#define BM_PERF_CONCAT(a, b) BM_PERF_CONCAT_(a, b)
+#define BM_PERF(state, ops_per_iter) PerfScope BM_PERF_CONCAT(bm_perf_, __LINE__)(state, ops_per_iter)
+
+// PauseTiming & ResumeTiming that also stop the counters, for setup inside a loop under BM_PERF
+#define BM_PERF_PAUSE(state) ((state).PauseTiming(), PerfCounters::instance().pause())
+#define BM_PERF_RESUME(state) (PerfCounters::instance().resume(), (state).ResumeTiming())
@@ -0,0 +1,376 @@
+#pragma once
+
+// Workloads for the benchmark suite: key sets, operation traces & latency percentiles, run against interchangeable backends
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace workload
+{
+    // Backends
+    // Each exposes insert (new or update), find, erase, size & a name
+
+    template <typename K, typename V>
+    struct HashTableBackend
+    {
+        static constexpr const char *NAME = "HashTable";
+        HashTable::HashTable<K, V> m;
+
+        void insert(const K &k, const V &v) { m.emplace(k, v); }
+        [[nodiscard]] bool find(const K &k) const { return m.find(k).has_value(); }
+        void erase(const K &k) { m.remove(k); }
+        [[nodiscard]] size_t size() const { return m.size(); }
+    };
+
+    template <typename K, typename V>
+    struct UnorderedMapBackend
+    {
+        static constexpr const char *NAME = "unordered_map";
+        std::unordered_map<K, V> m;
+
+        void insert(const K &k, const V &v) { m.insert_or_assign(k, v); }
+        [[nodiscard]] bool find(const K &k) const { return m.find(k) != m.end(); }
+        void erase(const K &k) { m.erase(k); }
+        [[nodiscard]] size_t size() const { return m.size(); }
+    };
+
+    // Textbook open addressing: linear probing one slot at a time, power of two capacity, tombstones, max load 1/2 & a
+    // mixed hash. The baseline the SIMD control bytes of HashTable are measured against
+    template <typename K, typename V>
+    class RefOpenTable
+    {
+    private:
+        enum State : uint8_t
+        {
+            EMPTY,
+            FULL,
+            DELETED
+        };
+
+        std::vector<std::pair<K, V>> m_slots;
+        std::vector<uint8_t> m_state;
+        size_t m_size = 0;
+        size_t m_used = 0; // Full & deleted slots
+
+        [[nodiscard]] static size_t hash(const K &k) { return static_cast<size_t>(HashTable::detail::mix_hash(std::hash<K>{}(k))); }
+
+        // Slot of the key, or the first reusable slot of its chain
+        [[nodiscard]] size_t probe(const K &k, bool &found) const
+        {
+            const size_t mask = m_state.size() - 1;
+            size_t first_del = SIZE_MAX;
+            for (size_t i = hash(k) & mask;; i = (i + 1) & mask)
+            {
+                if (m_state[i] == EMPTY)
+                {
+                    found = false;
+                    return first_del != SIZE_MAX ? first_del : i;
+                }
+                if (m_state[i] == DELETED)
+                {
+                    if (first_del == SIZE_MAX)
+                        first_del = i;
+                }
+                else if (m_slots[i].first == k)
+                {
+                    found = true;
+                    return i;
+                }
+            }
+        }
+
+        void rehash(size_t cap)
+        {
+            auto slots = std::move(m_slots);
+            auto state = std::move(m_state);
+            m_slots.assign(cap, {});
+            m_state.assign(cap, EMPTY);
+            m_used = m_size;
+            for (size_t i = 0; i < state.size(); i++)
+            {
+                if (state[i] != FULL)
+                    continue;
+                bool found;
+                const size_t j = probe(slots[i].first, found);
+                m_slots[j] = std::move(slots[i]);
+                m_state[j] = FULL;
+            }
+        }
+
+    public:
+        void insert(const K &k, const V &v)
+        {
+            if (m_state.empty() || 2 * (m_used + 1) > m_state.size())
+                rehash(std::max<size_t>(16, m_size * 4 > m_state.size() ? m_state.size() * 2 : m_state.size()));
+            bool found;
+            const size_t i = probe(k, found);
+            if (!found)
+            {
+                m_size += 1;
+                m_used += m_state[i] == EMPTY;
+                m_state[i] = FULL;
+                m_slots[i].first = k;
+            }
+            m_slots[i].second = v;
+        }
+
+        [[nodiscard]] bool find(const K &k) const
+        {
+            if (m_state.empty())
+                return false;
+            bool found;
+            (void)probe(k, found);
+            return found;
+        }
+
+        void erase(const K &k)
+        {
+            if (m_state.empty())
+                return;
+            bool found;
+            const size_t i = probe(k, found);
+            if (found)
+            {
+                m_state[i] = DELETED;
+                m_size -= 1;
+            }
+        }
+
+        [[nodiscard]] size_t size() const { return m_size; }
+    };
+
+    template <typename K, typename V>
+    struct RefOpenBackend
+    {
+        static constexpr const char *NAME = "RefOpen";
+        RefOpenTable<K, V> m;
+
+        void insert(const K &k, const V &v) { m.insert(k, v); }
+        [[nodiscard]] bool find(const K &k) const { return m.find(k); }
+        void erase(const K &k) { m.erase(k); }
+        [[nodiscard]] size_t size() const { return m.size(); }
+    };
+
+    // Keys
+    // Key i is a deterministic function of i, distinct for distinct i. Keys [0, n) are loaded, keys from n up are absent or churned in
+
+    [[nodiscard]] inline uint64_t mix(uint64_t i) noexcept
+    {
+        i += 0x9E3779B97F4A7C15ull;
+        i = (i ^ (i >> 30)) * 0xBF58476D1CE4E5B9ull;
+        i = (i ^ (i >> 27)) * 0x94D049BB133111EBull;
+        return i ^ (i >> 31);
+    }
+
+    template <typename K>
+    [[nodiscard]] K make_key(uint64_t i);
+
+    template <>
+    [[nodiscard]] inline uint64_t make_key<uint64_t>(uint64_t i) { return mix(i); } // Bijective, so distinct
+
+    // 24 characters, past the small string buffer like most real string keys
+    template <>
+    [[nodiscard]] inline std::string make_key<std::string>(uint64_t i)
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "key:%016llx:%03u", static_cast<unsigned long long>(mix(i)), static_cast<unsigned>(i % 1000));
+        return buf;
+    }
+
+    template <typename K>
+    [[nodiscard]] std::vector<K> make_keys(uint64_t begin, uint64_t end)
+    {
+        std::vector<K> keys;
+        keys.reserve(end - begin);
+        for (uint64_t i = begin; i < end; i++)
+            keys.push_back(make_key<K>(i));
+        return keys;
+    }
+
+    // Key distributions
+    enum class Dist
+    {
+        Uniform,
+        Zipf
+    };
+
+    // Zipfian ranks in [0, n) with skew s != 1, by inverting the continuous power law. Needs no O(n) table, so it scales to 100M keys
+    class ZipfSampler
+    {
+    private:
+        double m_n;
+        double m_s;
+        double m_a; // n^(1 - s) - 1
+        std::uniform_real_distribution<double> m_u;
+
+    public:
+        ZipfSampler(size_t n, double s) : m_n(static_cast<double>(n)), m_s(s), m_a(std::pow(m_n, 1 - s) - 1), m_u(0, 1) {}
+
+        template <typename Gen>
+        [[nodiscard]] size_t operator()(Gen &gen)
+        {
+            const double x = std::pow(m_a * m_u(gen) + 1, 1 / (1 - m_s));
+            return std::min(static_cast<size_t>(x) - 1, static_cast<size_t>(m_n) - 1);
+        }
+    };
+
+    // Rank r of the distribution maps to a scattered key index, so the hot keys are not neighbours in the key order
+    [[nodiscard]] inline uint64_t scatter(uint64_t rank, uint64_t n) noexcept { return (rank * 0x9E3779B97F4A7C15ull) % n; }
+
+    // Traces
+    enum class OpKind : uint8_t
+    {
+        Find,
+        Update,
+        Insert,
+        Erase
+    };
+
+    struct Op
+    {
+        OpKind kind;
+        uint64_t key; // Index into the key set
+    };
+
+    struct Mix
+    {
+        double read = 1;    // Finds among reads & writes
+        double hit = 1;     // Finds of present keys, the rest look up absent keys
+        bool churn = false; // Writes insert a new key & erase the oldest, the size stays constant
+        Dist dist = Dist::Uniform;
+    };
+
+    // Present keys are [0, n) & absent ones [n, 2n), see Runner
+    [[nodiscard]] inline std::vector<Op> make_trace(size_t n, size_t n_ops, const Mix &mix, uint64_t seed = 42)
+    {
+        std::mt19937_64 gen(seed);
+        std::uniform_real_distribution<double> coin(0, 1);
+        std::uniform_int_distribution<uint64_t> uniform(0, n - 1);
+        ZipfSampler zipf(n, 0.99);
+        const auto pick = [&]
+        { return mix.dist == Dist::Zipf ? scatter(zipf(gen), n) : uniform(gen); };
+
+        std::vector<Op> ops;
+        ops.reserve(n_ops);
+        for (size_t i = 0; i < n_ops; i++)
+        {
+            if (coin(gen) < mix.read)
+                ops.push_back({OpKind::Find, coin(gen) < mix.hit ? pick() : n + pick()});
+            else if (mix.churn)
+            {
+                // The insert & erase keys are taken from the window when run
+                ops.push_back({OpKind::Insert, 0});
+                ops.push_back({OpKind::Erase, 0});
+                i++;
+            }
+            else
+                ops.push_back({OpKind::Update, pick()});
+        }
+        return ops;
+    }
+
+    // Per-op latency
+    using Clock = std::chrono::steady_clock;
+
+    // Cost of reading the clock, subtracted from every sample
+    [[nodiscard]] inline uint64_t clock_overhead_ns()
+    {
+        uint64_t best = UINT64_MAX;
+        for (int i = 0; i < 1000; i++)
+        {
+            const auto a = Clock::now();
+            const auto b = Clock::now();
+            best = std::min<uint64_t>(best, std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+        }
+        return best;
+    }
+
+    struct Percentiles
+    {
+        double p50;
+        double p99;
+        double p999;
+        double max;
+    };
+
+    [[nodiscard]] inline Percentiles percentiles(std::vector<uint32_t> &ns)
+    {
+        if (ns.empty())
+            return {0, 0, 0, 0};
+        const auto at = [&](double q)
+        {
+            const size_t i = std::min(ns.size() - 1, static_cast<size_t>(q * static_cast<double>(ns.size())));
+            std::nth_element(ns.begin(), ns.begin() + i, ns.end());
+            return static_cast<double>(ns[i]);
+        };
+        return {at(0.5), at(0.99), at(0.999), static_cast<double>(*std::max_element(ns.begin(), ns.end()))};
+    }
+
+    // Runs a trace against a backend holding the n keys of a window over a ring of 2n keys. Trace indices below n are
+    // present keys & those from n up absent ones, both relative to the window, which only churn moves
+    template <typename Backend, typename K>
+    class Runner
+    {
+    private:
+        Backend &m_backend;
+        const std::vector<K> &m_keys;
+        size_t m_n;
+        size_t m_window = 0; // Oldest key of the window
+
+        [[nodiscard]] const K &key(uint64_t i) const noexcept
+        {
+            i += m_window;
+            return m_keys[i >= 2 * m_n ? i - 2 * m_n : i];
+        }
+
+    public:
+        Runner(Backend &backend, const std::vector<K> &keys, size_t n) : m_backend(backend), m_keys(keys), m_n(n) {}
+
+        // Returns 1 for a find that hits, so the work cannot be optimized out
+        inline size_t run(const Op &op)
+        {
+            switch (op.kind)
+            {
+            case OpKind::Find:
+                return m_backend.find(key(op.key));
+            case OpKind::Update:
+                m_backend.insert(key(op.key), op.key);
+                return 0;
+            case OpKind::Insert:
+                m_backend.insert(key(m_n), op.key);
+                return 0;
+            case OpKind::Erase:
+                m_backend.erase(key(0));
+                m_window = m_window + 1 == 2 * m_n ? 0 : m_window + 1;
+                return 0;
+            }
+            return 0;
+        }
+
+        [[nodiscard]] std::vector<uint32_t> timed(const std::vector<Op> &ops, size_t &sink)
+        {
+            const uint64_t overhead = clock_overhead_ns();
+            std::vector<uint32_t> ns;
+            ns.reserve(ops.size());
+            for (const auto &op : ops)
+            {
+                const auto t0 = Clock::now();
+                sink += run(op);
+                const auto t1 = Clock::now();
+                const uint64_t d = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+                ns.push_back(static_cast<uint32_t>(std::min<uint64_t>(d > overhead ? d - overhead : 0, UINT32_MAX)));
+            }
+            return ns;
+        }
+    };
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace HashTable
+{
+    // Bloom filter where all bits of a key live in one 64-bit word, so a query is a single load & compare.
+    // The top 32 bits of the hash pick the word & the low 30 bits pick K bits within it
+    class BlockedBloomFilter
+    {
+    public:
+        static constexpr size_t K = 5;
+        static constexpr size_t DEFAULT_BITS_PER_KEY = 12; // About 1% false positives
+
+    private:
+        std::vector<uint64_t> m_words;
+
+        [[nodiscard]] size_t word_index(uint64_t hash) const noexcept
+        {
+            return static_cast<size_t>(((hash >> 32) * m_words.size()) >> 32);
+        }
+
+        [[nodiscard]] static constexpr uint64_t mask(uint64_t hash) noexcept
+        {
+            uint64_t m = 0;
+            for (size_t i = 0; i < K; i++)
+                m |= uint64_t(1) << ((hash >> (6 * i)) & 63);
+            return m;
+        }
+
+    public:
+        // ctors
+        BlockedBloomFilter() noexcept = default;
+        explicit BlockedBloomFilter(size_t n, size_t bits_per_key = DEFAULT_BITS_PER_KEY) noexcept
+            : m_words(std::max<size_t>((n * bits_per_key + 63) / 64, 1), 0) {}
+
+        // getters
+        [[nodiscard]] size_t memory_usage() const noexcept { return m_words.size() * sizeof(uint64_t); }
+        [[nodiscard]] bool empty() const noexcept { return m_words.empty(); }
+
+        // functions
+        void insert(uint64_t hash) noexcept { m_words[word_index(hash)] |= mask(hash); }
+
+        // False means the hash was never inserted, true may be a false positive
+        [[nodiscard]] bool may_contain(uint64_t hash) const noexcept
+        {
+            if (m_words.empty())
+                return false;
+            const uint64_t m = mask(hash);
+            return (m_words[word_index(hash)] & m) == m;
+        }
+
+        void clear() noexcept { std::fill(m_words.begin(), m_words.end(), 0); }
+    };
+
+    // Hash table with a blocked Bloom filter in front, most lookups of absent keys are answered without probing the table.
+    // Removed keys leave their bits set, the filter is rebuilt from the table once they make up half of the filtered keys
+    template <typename K, typename V, typename Policy = DefaultPolicy>
+    class FilteredHashTable
+    {
+    private:
+        HashTable<K, V, Policy> m_table;
+        BlockedBloomFilter m_filter;
+        size_t m_filter_capacity; // Keys the filter is sized for
+        size_t m_filtered;        // Keys inserted into the filter since it was built, removed ones included
+        size_t m_bits_per_key;
+
+        void rebuild_filter(size_t n) noexcept
+        {
+            m_filter_capacity = std::max<size_t>(n, Policy::INIT_SIZE);
+            m_filter = BlockedBloomFilter(m_filter_capacity, m_bits_per_key);
+            for (const auto [k, v] : m_table.key_values())
+                m_filter.insert(m_table.hash(k));
+            m_filtered = m_table.size();
+        }
+
+    public:
+        // ctors
+        explicit FilteredHashTable(size_t bits_per_key = BlockedBloomFilter::DEFAULT_BITS_PER_KEY) noexcept
+            : m_filter_capacity(0), m_filtered(0), m_bits_per_key(bits_per_key) {}
+
+        // getters
+        [[nodiscard]] constexpr size_t size() const noexcept { return m_table.size(); }
+        [[nodiscard]] constexpr size_t capacity() const noexcept { return m_table.capacity(); }
+        [[nodiscard]] constexpr bool empty() const noexcept { return m_table.empty(); }
+        [[nodiscard]] size_t filter_memory_usage() const noexcept { return m_filter.memory_usage(); }
+        [[nodiscard]] constexpr auto key_values() noexcept { return m_table.key_values(); }
+        [[nodiscard]] constexpr auto key_values() const noexcept { return m_table.key_values(); }
+
+        // functions
+        // Each key is hashed once, the filter & the table share the hash
+        template <typename KK, typename VV>
+        std::optional<V> emplace(KK &&key, VV &&val) noexcept
+        {
+            const size_t hash = m_table.hash(key);
+            auto old = m_table.emplace(std::forward<KK>(key), std::forward<VV>(val), hash);
+            if (old)
+                return old;
+
+            // Double the filter when it is full, the false positive rate grows fast past its sizing
+            if (m_filtered + 1 > m_filter_capacity)
+                rebuild_filter(2 * m_table.size());
+            else
+            {
+                m_filter.insert(hash);
+                m_filtered += 1;
+            }
+            return std::nullopt;
+        }
+
+        std::optional<V *> find(const K &key) noexcept
+        {
+            const size_t hash = m_table.hash(key);
+            if (!m_filter.may_contain(hash))
+                return std::nullopt;
+            return m_table.find(key, hash);
+        }
+
+        std::optional<const V *> find(const K &key) const noexcept
+        {
+            const size_t hash = m_table.hash(key);
+            if (!m_filter.may_contain(hash))
+                return std::nullopt;
+            return m_table.find(key, hash);
+        }
+
+        std::optional<std::pair<K, V>> remove(const K &key) noexcept
+        {
+            const size_t hash = m_table.hash(key);
+            if (!m_filter.may_contain(hash))
+                return std::nullopt;
+            auto kv = m_table.remove(key, hash);
+            if (kv && m_table.size() < m_filtered / 2)
+                rebuild_filter(2 * m_table.size());
+            return kv;
+        }
+
+        void reserve(size_t n) noexcept
+        {
+            m_table.reserve(n);
+            if (n > m_filter_capacity)
+                rebuild_filter(n);
+        }
+    };
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace HashTable
+{
+    // Binary Encoding
+    // Checksums & key & value encodings shared by the files of a durable table & the migration batches of a partitioned one
+    namespace detail
+    {
+        // CRC-32C, bitwise table
+        [[nodiscard]] inline uint32_t crc32c(const void *data, size_t n, uint32_t crc = 0) noexcept
+        {
+            static const auto table = []
+            {
+                std::array<uint32_t, 256> t{};
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    uint32_t c = i;
+                    for (int j = 0; j < 8; j++)
+                        c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+                    t[i] = c;
+                }
+                return t;
+            }();
+
+            const auto *p = static_cast<const uint8_t *>(data);
+            crc = ~crc;
+            for (size_t i = 0; i < n; i++)
+                crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+            return ~crc;
+        }
+
+        // Bounds checked reader over bytes in memory, e.g. a received migration batch
+        class ByteReader
+        {
+        private:
+            const char *m_data;
+            size_t m_size;
+            size_t m_pos;
+
+        public:
+            ByteReader(const char *data, size_t size) noexcept : m_data(data), m_size(size), m_pos(0) {}
+
+            [[nodiscard]] size_t pos() const noexcept { return m_pos; }
+            [[nodiscard]] const char *data() const noexcept { return m_data; }
+
+            [[nodiscard]] bool read(void *data, size_t n) noexcept
+            {
+                if (n > m_size - m_pos)
+                    return false;
+                std::memcpy(data, m_data + m_pos, n);
+                m_pos += n;
+                return true;
+            }
+        };
+
+        // Handles whose bytes are addresses, meaningless once read back by another process or after a reload
+        template <typename T>
+        struct is_address : std::bool_constant<std::is_pointer_v<T> || std::is_member_pointer_v<T>>
+        {
+        };
+
+        template <typename C, typename Traits>
+        struct is_address<std::basic_string_view<C, Traits>> : std::true_type
+        {
+        };
+
+        // Binary encoding of keys & values, trivially copyable types as raw bytes & strings length prefixed
+        template <typename T, typename = void>
+        struct Codec;
+
+        template <typename T>
+        struct Codec<T, std::enable_if_t<std::is_trivially_copyable_v<T>>>
+        {
+            static_assert(!is_address<T>::value, "Pointers & views can not be encoded, store the data they refer to");
+
+            static void encode(std::string &out, const T &v) { out.append(reinterpret_cast<const char *>(&v), sizeof(T)); }
+
+            template <typename Reader>
+            [[nodiscard]] static bool decode(Reader &in, T &v) { return in.read(&v, sizeof(T)); }
+        };
+
+        template <>
+        struct Codec<std::string>
+        {
+            static void encode(std::string &out, const std::string &s)
+            {
+                const uint32_t n = static_cast<uint32_t>(s.size());
+                out.append(reinterpret_cast<const char *>(&n), sizeof(n));
+                out.append(s);
+            }
+
+            template <typename Reader>
+            [[nodiscard]] static bool decode(Reader &in, std::string &s)
+            {
+                uint32_t n;
+                if (!in.read(&n, sizeof(n)))
+                    return false;
+                // Grown as read, a corrupt length fails at the end of the input instead of allocating it
+                s.clear();
+                while (n > 0)
+                {
+                    const size_t c = std::min<size_t>(n, 1 << 20);
+                    const size_t old = s.size();
+                    s.resize(old + c);
+                    if (!in.read(s.data() + old, c))
+                        return false;
+                    n -= static_cast<uint32_t>(c);
+                }
+                return true;
+            }
+        };
+    }
+}
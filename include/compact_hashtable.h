@@ -0,0 +1,324 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace HashTable
+{
+    namespace detail
+    {
+        // Modular inverse of an odd multiplier, by Newton's iteration
+        template <typename K>
+        [[nodiscard]] constexpr K mul_inverse(K a) noexcept
+        {
+            K x = a;
+            for (int i = 0; i < 6; i++)
+                x *= K(2) - a * x;
+            return x;
+        }
+
+        // Inverse of x ^= x >> s
+        template <typename K>
+        [[nodiscard]] constexpr K unxorshift(K x, unsigned s) noexcept
+        {
+            K y = x;
+            for (unsigned i = s; i < sizeof(K) * 8; i += s)
+                y = x ^ (y >> s);
+            return y;
+        }
+
+        // Bijective murmur3 finalizer, a key is recovered from its hash by unmix()
+        template <typename K>
+        struct InvertibleMix;
+
+        template <>
+        struct InvertibleMix<uint64_t>
+        {
+            static constexpr uint64_t C1 = 0xff51afd7ed558ccdull;
+            static constexpr uint64_t C2 = 0xc4ceb9fe1a85ec53ull;
+
+            [[nodiscard]] static constexpr uint64_t mix(uint64_t k) noexcept
+            {
+                k ^= k >> 33;
+                k *= C1;
+                k ^= k >> 33;
+                k *= C2;
+                k ^= k >> 33;
+                return k;
+            }
+
+            [[nodiscard]] static constexpr uint64_t unmix(uint64_t h) noexcept
+            {
+                h = unxorshift(h, 33);
+                h *= mul_inverse(C2);
+                h = unxorshift(h, 33);
+                h *= mul_inverse(C1);
+                h = unxorshift(h, 33);
+                return h;
+            }
+        };
+
+        template <>
+        struct InvertibleMix<uint32_t>
+        {
+            static constexpr uint32_t C1 = 0x85ebca6bu;
+            static constexpr uint32_t C2 = 0xc2b2ae35u;
+
+            [[nodiscard]] static constexpr uint32_t mix(uint32_t k) noexcept
+            {
+                k ^= k >> 16;
+                k *= C1;
+                k ^= k >> 13;
+                k *= C2;
+                k ^= k >> 16;
+                return k;
+            }
+
+            [[nodiscard]] static constexpr uint32_t unmix(uint32_t h) noexcept
+            {
+                h = unxorshift(h, 16);
+                h *= mul_inverse(C2);
+                h = unxorshift(h, 13);
+                h *= mul_inverse(C1);
+                h = unxorshift(h, 16);
+                return h;
+            }
+        };
+    }
+
+    // Set of fixed-width unsigned integers stored in a few bits per entry.
+    // Keys are hashed by a bijection, the high bits of the hash pick the home bucket & only the remaining low bits are stored.
+    // A slot is [remainder | alt | used], where alt marks an entry living in its second cuckoo bucket, so every key can be decoded back from its slot.
+    // Buckets of BUCKET_SIZE slots & two choices per key keep inserts succeeding above 0.95 load
+    template <typename K, size_t BUCKET_SIZE = 8>
+    class CompactIntSet
+    {
+        static_assert(std::is_same_v<K, uint32_t> || std::is_same_v<K, uint64_t>, "CompactIntSet supports uint32_t & uint64_t keys");
+        static_assert(BUCKET_SIZE > 0);
+
+    public:
+        static constexpr float MAX_LOAD_FACTOR = 0.97;
+        static constexpr size_t MIN_BUCKET_BITS = 4;
+        static constexpr size_t MAX_KICKS = 500;
+
+    private:
+        using Mix = detail::InvertibleMix<K>;
+        static constexpr size_t KEY_BITS = sizeof(K) * 8;
+
+        std::vector<uint64_t> m_words; // Packed slots, with a padding word so reads may span two words
+        size_t m_bucket_bits;
+        size_t m_rem_bits;
+        size_t m_width; // Bits per slot
+        size_t m_size;
+        uint64_t m_rng;
+
+        [[nodiscard]] constexpr size_t n_buckets() const noexcept { return size_t(1) << m_bucket_bits; }
+
+        [[nodiscard]] uint64_t code_at(size_t bucket, size_t slot) const noexcept
+        {
+            const size_t pos = (bucket * BUCKET_SIZE + slot) * m_width;
+            const size_t idx = pos / 64;
+            const size_t off = pos % 64;
+            uint64_t bits = m_words[idx] >> off;
+            if (off + m_width > 64)
+                bits |= m_words[idx + 1] << (64 - off);
+            return bits & ((uint64_t(1) << m_width) - 1);
+        }
+
+        void set_code(size_t bucket, size_t slot, uint64_t code) noexcept
+        {
+            const size_t pos = (bucket * BUCKET_SIZE + slot) * m_width;
+            const size_t idx = pos / 64;
+            const size_t off = pos % 64;
+            const uint64_t mask = (uint64_t(1) << m_width) - 1;
+            m_words[idx] = (m_words[idx] & ~(mask << off)) | (code << off);
+            if (off + m_width > 64)
+                m_words[idx + 1] = (m_words[idx + 1] & ~(mask >> (64 - off))) | (code >> (64 - off));
+        }
+
+        void prefetch_bucket([[maybe_unused]] size_t bucket) const noexcept
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(&m_words[bucket * BUCKET_SIZE * m_width / 64]);
+#endif
+        }
+
+        // The second bucket is derived from the remainder alone, so it can be found from either bucket
+        [[nodiscard]] size_t alt_bucket(size_t bucket, uint64_t rem) const noexcept
+        {
+            return bucket ^ static_cast<size_t>(((rem + 1) * 0x9E3779B97F4A7C15ull) >> (64 - m_bucket_bits));
+        }
+
+        [[nodiscard]] K decode(size_t bucket, uint64_t code) const noexcept
+        {
+            const uint64_t rem = code >> 2;
+            const size_t home = (code & 2) ? alt_bucket(bucket, rem) : bucket;
+            return Mix::unmix(static_cast<K>((uint64_t(home) << m_rem_bits) | rem));
+        }
+
+        // Returns the bucket & slot holding the key, or n_buckets() if absent
+        [[nodiscard]] std::pair<size_t, size_t> find_slot(K key) const noexcept
+        {
+            const uint64_t h = Mix::mix(key);
+            const uint64_t rem = h & ((uint64_t(1) << m_rem_bits) - 1);
+            const size_t b1 = static_cast<size_t>(h >> m_rem_bits);
+            const size_t b2 = alt_bucket(b1, rem);
+            prefetch_bucket(b2); // Misses read both buckets, so overlap the second cache miss with the first
+
+            const uint64_t code1 = (rem << 2) | 1;
+            for (size_t s = 0; s < BUCKET_SIZE; s++)
+                if (code_at(b1, s) == code1)
+                    return {b1, s};
+
+            const uint64_t code2 = (rem << 2) | 3;
+            for (size_t s = 0; s < BUCKET_SIZE; s++)
+                if (code_at(b2, s) == code2)
+                    return {b2, s};
+            return {n_buckets(), 0};
+        }
+
+        [[nodiscard]] bool try_place(size_t bucket, uint64_t code) noexcept
+        {
+            for (size_t s = 0; s < BUCKET_SIZE; s++)
+            {
+                if (code_at(bucket, s) == 0)
+                {
+                    set_code(bucket, s, code);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        [[nodiscard]] uint64_t next_rand() noexcept
+        {
+            m_rng ^= m_rng << 13;
+            m_rng ^= m_rng >> 7;
+            m_rng ^= m_rng << 17;
+            return m_rng;
+        }
+
+        // Insert a key known to be absent
+        void insert_new(K key)
+        {
+            const uint64_t h = Mix::mix(key);
+            const uint64_t rem = h & ((uint64_t(1) << m_rem_bits) - 1);
+            const size_t b1 = static_cast<size_t>(h >> m_rem_bits);
+            const size_t b2 = alt_bucket(b1, rem);
+            if (try_place(b1, (rem << 2) | 1) || try_place(b2, (rem << 2) | 3))
+                return;
+
+            // Both buckets are full, evict random entries to their other bucket
+            const bool use_b1 = next_rand() & 1;
+            size_t bucket = use_b1 ? b1 : b2;
+            uint64_t code = (rem << 2) | (use_b1 ? 1 : 3);
+            for (size_t i = 0; i < MAX_KICKS; i++)
+            {
+                const size_t s = next_rand() % BUCKET_SIZE;
+                const uint64_t victim = code_at(bucket, s);
+                set_code(bucket, s, code);
+                bucket = alt_bucket(bucket, victim >> 2);
+                code = victim ^ 2;
+                if (try_place(bucket, code))
+                    return;
+            }
+
+            // The entry left in hand is decoded before the layout changes
+            const K homeless = decode(bucket, code);
+            rehash(m_bucket_bits + 1);
+            insert_new(homeless);
+        }
+
+        void rehash(size_t bucket_bits)
+        {
+            assert(bucket_bits <= KEY_BITS);
+            CompactIntSet other;
+            other.init(bucket_bits);
+            other.m_rng = m_rng;
+            for_each([&](K key)
+                     { other.insert_new(key); });
+            other.m_size = m_size;
+            *this = std::move(other);
+        }
+
+        void init(size_t bucket_bits)
+        {
+            m_bucket_bits = bucket_bits;
+            m_rem_bits = KEY_BITS - bucket_bits;
+            m_width = m_rem_bits + 2;
+            m_words.assign((n_buckets() * BUCKET_SIZE * m_width + 63) / 64 + 1, 0);
+        }
+
+        [[nodiscard]] static constexpr size_t bucket_bits_for(size_t n) noexcept
+        {
+            size_t bits = MIN_BUCKET_BITS;
+            while (bits < KEY_BITS && static_cast<float>(n) > MAX_LOAD_FACTOR * static_cast<float>((size_t(1) << bits) * BUCKET_SIZE))
+                bits++;
+            return bits;
+        }
+
+    public:
+        // ctors
+        CompactIntSet() : m_size(0), m_rng(0x2545F4914F6CDD1Dull) { init(MIN_BUCKET_BITS); }
+        explicit CompactIntSet(size_t n) : m_size(0), m_rng(0x2545F4914F6CDD1Dull) { init(bucket_bits_for(n)); }
+
+        // getters
+        [[nodiscard]] constexpr size_t size() const noexcept { return m_size; }
+        [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+        [[nodiscard]] constexpr size_t capacity() const noexcept { return n_buckets() * BUCKET_SIZE; }
+        [[nodiscard]] constexpr float load_factor() const noexcept { return static_cast<float>(m_size) / static_cast<float>(capacity()); }
+        [[nodiscard]] constexpr size_t bits_per_slot() const noexcept { return m_width; }
+        [[nodiscard]] size_t memory_usage() const noexcept { return m_words.capacity() * sizeof(uint64_t); }
+
+        // functions
+        // Returns true if the key was inserted, false if it was already present
+        bool insert(K key)
+        {
+            if (contains(key))
+                return false;
+            if (static_cast<float>(m_size + 1) > MAX_LOAD_FACTOR * static_cast<float>(capacity()) && m_bucket_bits < KEY_BITS)
+                rehash(m_bucket_bits + 1);
+            insert_new(key);
+            m_size += 1;
+            return true;
+        }
+
+        [[nodiscard]] bool contains(K key) const noexcept { return find_slot(key).first != n_buckets(); }
+
+        // Returns true if the key was removed
+        bool remove(K key) noexcept
+        {
+            const auto [bucket, slot] = find_slot(key);
+            if (bucket == n_buckets())
+                return false;
+            set_code(bucket, slot, 0);
+            m_size -= 1;
+            return true;
+        }
+
+        void reserve(size_t n)
+        {
+            const size_t bits = bucket_bits_for(n);
+            if (bits > m_bucket_bits)
+                rehash(bits);
+        }
+
+        // Calls fn on every key, in slot order
+        template <typename Fn>
+        void for_each(Fn &&fn) const
+        {
+            for (size_t b = 0; b < n_buckets(); b++)
+                for (size_t s = 0; s < BUCKET_SIZE; s++)
+                {
+                    const uint64_t code = code_at(b, s);
+                    if (code != 0)
+                        fn(decode(b, code));
+                }
+        }
+    };
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#if __cplusplus < 202002L || !__has_include(<coroutine>)
+#error "coro_find.h needs C++20 coroutines, configure with -DENABLE_CXX20=on"
+#endif
+
+#include "hashtable.h"
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace HashTable
+{
+    // Coroutine Lookups
+    // A lookup that misses the cache stalls for a few hundred cycles. A coroutine lookup prefetches the home slot of its key
+    // & suspends, the scheduler runs other lookups meanwhile & resumes it once the line has had time to arrive. Unlike a
+    // batch of prefetches, each lookup keeps its own control flow, e.g. a chain of dependent lookups in one coroutine
+
+    namespace detail
+    {
+        // Recycles coroutine frames on each thread, so a warm scheduler allocates nothing per lookup. Frames are reused oldest
+        // first once MIN_FREE newer ones are queued. Reusing the frame freed last makes a new coroutine's accesses alias those
+        // of the previous one still in flight, & the CPU then runs the lookups one after the other.
+        // Frames of one size are kept, which covers a scheduler running one kind of coroutine
+        class FramePool
+        {
+        private:
+            static constexpr size_t CAPACITY = 256;
+            static constexpr size_t MIN_FREE = 64;
+
+            struct Queue
+            {
+                void *frames[CAPACITY];
+                size_t head = 0;
+                size_t count = 0;
+                size_t frame_size = 0;
+
+                ~Queue()
+                {
+                    for (size_t i = 0; i < count; i++)
+                        ::operator delete(frames[(head + i) % CAPACITY]);
+                }
+            };
+
+            [[nodiscard]] static Queue &queue() noexcept
+            {
+                thread_local Queue q;
+                return q;
+            }
+
+        public:
+            [[nodiscard]] static void *allocate(size_t n)
+            {
+                Queue &q = queue();
+                if (q.frame_size != n || q.count <= MIN_FREE)
+                    return ::operator new(n);
+                void *p = q.frames[q.head];
+                q.head = (q.head + 1) % CAPACITY;
+                q.count -= 1;
+                return p;
+            }
+
+            static void deallocate(void *p, size_t n) noexcept
+            {
+                Queue &q = queue();
+                if (q.count == 0)
+                    q.frame_size = n;
+                if (q.frame_size != n || q.count == CAPACITY)
+                {
+                    ::operator delete(p);
+                    return;
+                }
+                q.frames[(q.head + q.count) % CAPACITY] = p;
+                q.count += 1;
+            }
+        };
+    }
+
+    // Coroutine returning a T. It runs from its call to its first suspension, then whoever holds the task resumes it until
+    // done() & takes result(). The caller owns the frame, it is destroyed with the task
+    template <typename T>
+    class LookupTask
+    {
+    public:
+        struct promise_type
+        {
+            std::optional<T> m_result;
+
+            LookupTask get_return_object() noexcept { return LookupTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            template <typename U>
+            void return_value(U &&val) noexcept(std::is_nothrow_constructible_v<T, U &&>) { m_result.emplace(std::forward<U>(val)); }
+            void unhandled_exception() noexcept { std::terminate(); }
+
+            static void *operator new(size_t n) { return detail::FramePool::allocate(n); }
+            static void operator delete(void *p, size_t n) noexcept { detail::FramePool::deallocate(p, n); }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> m_handle;
+
+        explicit LookupTask(std::coroutine_handle<promise_type> h) noexcept : m_handle(h) {}
+
+    public:
+        // ctors
+        constexpr LookupTask() noexcept : m_handle(nullptr) {}
+        ~LookupTask()
+        {
+            if (m_handle)
+                m_handle.destroy();
+        }
+
+        // move operations
+        LookupTask(LookupTask &&other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        LookupTask &operator=(LookupTask &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (m_handle)
+                    m_handle.destroy();
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+        LookupTask(const LookupTask &) = delete;
+        LookupTask &operator=(const LookupTask &) = delete;
+
+        [[nodiscard]] explicit operator bool() const noexcept { return static_cast<bool>(m_handle); }
+        [[nodiscard]] bool done() const noexcept { return m_handle.done(); }
+        void resume() const { m_handle.resume(); }
+
+        // Moves the result out, only once done
+        [[nodiscard]] T result() { return std::move(*m_handle.promise().m_result); }
+    };
+
+    // co_await async_find(m, key) prefetches the home slot of key, suspends & finds the key once resumed.
+    // The table must not change & key must stay alive until the lookup resumes
+    template <typename Table, typename K>
+    class FindAwaiter
+    {
+    private:
+        const Table &m_table;
+        const K &m_key;
+        size_t m_hash;
+
+    public:
+        FindAwaiter(const Table &table, const K &key) noexcept : m_table(table), m_key(key), m_hash(table.hash(key)) {}
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) const noexcept { m_table.prefetch(m_hash); }
+        [[nodiscard]] auto await_resume() const noexcept { return m_table.find(m_key, m_hash); }
+    };
+
+    template <typename K, typename V, typename Policy, typename Alloc>
+    [[nodiscard]] FindAwaiter<HashTable<K, V, Policy, Alloc>, K> async_find(const HashTable<K, V, Policy, Alloc> &m, const K &key) noexcept
+    {
+        return FindAwaiter<HashTable<K, V, Policy, Alloc>, K>(m, key);
+    }
+
+    // One lookup as a coroutine, for a scheduler to interleave. key is taken by reference, it must outlive the task
+    template <typename K, typename V, typename Policy, typename Alloc>
+    LookupTask<std::optional<const V *>> co_find(const HashTable<K, V, Policy, Alloc> &m, const K &key)
+    {
+        const size_t hash = m.hash(key);
+        m.prefetch(hash);
+        co_await std::suspend_always{};
+        co_return m.find(key, hash);
+    }
+
+    // Runs count coroutines with at most N in flight. spawn(i) starts coroutine i, which runs to its first prefetch &
+    // suspends. In-flight coroutines are resumed round-robin, so a prefetch has N - 1 other resumptions to land before its
+    // coroutine continues. done(i, result) is called as coroutine i finishes, which is not necessarily in order
+    template <size_t N = 16, typename Spawn, typename Done>
+    void interleave(size_t count, Spawn &&spawn, Done &&done)
+    {
+        static_assert(N > 0, "At least one coroutine must be in flight");
+        using Task = std::invoke_result_t<Spawn &, size_t>;
+
+        std::array<Task, N> ring;
+        std::array<size_t, N> ids{};
+        size_t next = 0;
+        size_t in_flight = 0;
+
+        // Fill ring slot s with the next coroutine that suspends, finishing the ones that complete right away
+        const auto start = [&](size_t s)
+        {
+            while (next < count)
+            {
+                const size_t id = next++;
+                Task task = spawn(id);
+                if (!task.done())
+                {
+                    ring[s] = std::move(task);
+                    ids[s] = id;
+                    in_flight += 1;
+                    return;
+                }
+                done(id, task.result());
+            }
+        };
+
+        for (size_t s = 0; s < N; s++)
+            start(s);
+        while (in_flight > 0)
+            for (size_t s = 0; s < N; s++)
+            {
+                if (!ring[s])
+                    continue;
+                ring[s].resume();
+                if (!ring[s].done())
+                    continue;
+                done(ids[s], ring[s].result());
+                ring[s] = Task();
+                in_flight -= 1;
+                start(s);
+            }
+    }
+}
@@ -0,0 +1,404 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace HashTable
+{
+    namespace detail
+    {
+        // Most slots a bucket holds with its control bytes in one cache line, between 1 & 8
+        template <typename K, typename V>
+        [[nodiscard]] constexpr size_t cuckoo_bucket_size() noexcept
+        {
+            constexpr size_t per_line = 64 / (sizeof(std::pair<K, V>) + sizeof(Ctrl));
+            return std::clamp<size_t>(per_line, 1, 8);
+        }
+    }
+
+    // Bucketized cuckoo hash table, a key lives in one of two buckets or in a small stash.
+    // A lookup reads at most two buckets, each a cache line when BUCKET_SIZE is the default, so its cost is bounded whatever the load.
+    // Inserts into two full buckets search for the shortest chain of displacements breadth first, the stash takes the key if none is found
+    template <typename K, typename V, size_t BUCKET_SIZE = detail::cuckoo_bucket_size<K, V>()>
+    class CuckooHashTable
+    {
+        static_assert(BUCKET_SIZE > 0 && BUCKET_SIZE <= 8);
+
+    public:
+        static constexpr size_t STASH_SIZE = 4;
+        static constexpr size_t MAX_BFS_NODES = 256;
+        static constexpr size_t INIT_BUCKETS = 4;
+
+        // Load reserve() sizes for, inserts keep succeeding past it & only a failed insert grows the table
+        static constexpr float TARGET_LOAD_FACTOR = BUCKET_SIZE >= 4 ? 0.95f : BUCKET_SIZE == 3 ? 0.9f
+                                                                           : BUCKET_SIZE == 2   ? 0.85f
+                                                                                                : 0.45f;
+
+    private:
+        struct Slot
+        {
+            K key;
+            V val;
+        };
+
+        struct alignas(64) Bucket
+        {
+            detail::Ctrl ctrl[BUCKET_SIZE];
+            Slot slots[BUCKET_SIZE];
+        };
+
+        // BFS node, the key at slot of the parent's bucket moves into bucket
+        struct Node
+        {
+            size_t bucket;
+            int32_t parent;
+            uint8_t slot;
+        };
+
+        std::unique_ptr<Bucket[]> m_buckets;
+        size_t m_mask;
+        size_t m_size;
+        std::vector<std::pair<K, V>> m_stash;
+        std::vector<Node> m_bfs;
+        std::hash<K> m_hasher;
+
+        [[nodiscard]] constexpr size_t n_buckets() const noexcept { return m_buckets ? m_mask + 1 : 0; }
+
+        struct Position
+        {
+            size_t b1;
+            size_t b2;
+            detail::Ctrl tag;
+        };
+
+        // Both buckets & the tag come from one mixed hash, the second bucket never equals the first
+        [[nodiscard]] Position position(const K &key) const noexcept
+        {
+            const uint64_t h = detail::mix_hash(m_hasher(key));
+
+            const size_t b1 = static_cast<size_t>(h) & m_mask;
+            size_t b2 = static_cast<size_t>((h >> 32) | (h << 32)) & m_mask;
+            if (b2 == b1)
+                b2 = b1 ^ 1;
+            return {b1, b2, static_cast<detail::Ctrl>((h >> 25) & 0x7F)};
+        }
+
+        [[nodiscard]] size_t find_in_bucket(size_t b, detail::Ctrl tag, const K &key) const noexcept
+        {
+            const Bucket &bucket = m_buckets[b];
+            for (size_t s = 0; s < BUCKET_SIZE; s++)
+                if (bucket.ctrl[s] == tag && bucket.slots[s].key == key)
+                    return s;
+            return BUCKET_SIZE;
+        }
+
+        [[nodiscard]] size_t empty_slot(size_t b) const noexcept
+        {
+            const Bucket &bucket = m_buckets[b];
+            for (size_t s = 0; s < BUCKET_SIZE; s++)
+                if (bucket.ctrl[s] == detail::CTRL_EMPTY)
+                    return s;
+            return BUCKET_SIZE;
+        }
+
+        [[nodiscard]] size_t stash_index(const K &key) const noexcept
+        {
+            for (size_t i = 0; i < m_stash.size(); i++)
+                if (m_stash[i].first == key)
+                    return i;
+            return m_stash.size();
+        }
+
+        void move_slot(size_t from_b, size_t from_s, size_t to_b, size_t to_s) noexcept
+        {
+            m_buckets[to_b].slots[to_s] = std::move(m_buckets[from_b].slots[from_s]);
+            m_buckets[to_b].ctrl[to_s] = m_buckets[from_b].ctrl[from_s];
+            m_buckets[from_b].ctrl[from_s] = detail::CTRL_EMPTY;
+        }
+
+        [[nodiscard]] bool on_path(int32_t node, size_t bucket) const noexcept
+        {
+            for (; node != -1; node = m_bfs[node].parent)
+                if (m_bfs[node].bucket == bucket)
+                    return true;
+            return false;
+        }
+
+        // Free a slot in b1 or b2 by moving keys along the shortest displacement chain. Returns the freed bucket & slot
+        [[nodiscard]] std::optional<std::pair<size_t, size_t>> make_room(size_t b1, size_t b2) noexcept
+        {
+            m_bfs.clear();
+            m_bfs.push_back({b1, -1, 0});
+            m_bfs.push_back({b2, -1, 0});
+            for (size_t head = 0; head < m_bfs.size(); head++)
+            {
+                const size_t b = m_bfs[head].bucket;
+                for (size_t s = 0; s < BUCKET_SIZE; s++)
+                {
+                    const auto pos = position(m_buckets[b].slots[s].key);
+                    const size_t alt = pos.b1 == b ? pos.b2 : pos.b1;
+                    const size_t e = empty_slot(alt);
+                    if (e != BUCKET_SIZE)
+                    {
+                        // Shift keys back along the chain, from the free slot to the root
+                        move_slot(b, s, alt, e);
+                        size_t free_b = b;
+                        size_t free_s = s;
+                        for (int32_t i = static_cast<int32_t>(head); m_bfs[i].parent != -1; i = m_bfs[i].parent)
+                        {
+                            const Node &n = m_bfs[i];
+                            move_slot(m_bfs[n.parent].bucket, n.slot, free_b, free_s);
+                            free_b = m_bfs[n.parent].bucket;
+                            free_s = n.slot;
+                        }
+                        return std::pair(free_b, free_s);
+                    }
+
+                    // A bucket appearing twice on one chain would move the same key twice
+                    if (m_bfs.size() < MAX_BFS_NODES && !on_path(static_cast<int32_t>(head), alt))
+                        m_bfs.push_back({alt, static_cast<int32_t>(head), static_cast<uint8_t>(s)});
+                }
+            }
+            return std::nullopt;
+        }
+
+        // Insert a key known to be absent
+        template <typename KK, typename VV>
+        void insert_new(KK &&key, VV &&val) noexcept
+        {
+            const auto pos = position(key);
+            size_t b = pos.b1;
+            size_t s = empty_slot(b);
+            if (s == BUCKET_SIZE)
+            {
+                b = pos.b2;
+                s = empty_slot(b);
+            }
+            if (s == BUCKET_SIZE)
+            {
+                const auto room = make_room(pos.b1, pos.b2);
+                if (!room)
+                {
+                    if (m_stash.size() < STASH_SIZE)
+                    {
+                        m_stash.emplace_back(std::forward<KK>(key), std::forward<VV>(val));
+                        return;
+                    }
+
+                    // No chain & a full stash, the key goes into a table twice as large
+                    rehash(2 * n_buckets());
+                    insert_new(std::forward<KK>(key), std::forward<VV>(val));
+                    return;
+                }
+                b = room->first;
+                s = room->second;
+            }
+
+            m_buckets[b].ctrl[s] = pos.tag;
+            m_buckets[b].slots[s].key = std::forward<KK>(key);
+            m_buckets[b].slots[s].val = std::forward<VV>(val);
+        }
+
+        void init(size_t buckets) noexcept
+        {
+            m_buckets = std::make_unique<Bucket[]>(buckets);
+            m_mask = buckets - 1;
+            for (size_t b = 0; b < buckets; b++)
+                std::fill(m_buckets[b].ctrl, m_buckets[b].ctrl + BUCKET_SIZE, detail::CTRL_EMPTY);
+        }
+
+        void rehash(size_t buckets) noexcept
+        {
+            CuckooHashTable other;
+            other.init(buckets);
+            for (size_t b = 0; b < n_buckets(); b++)
+                for (size_t s = 0; s < BUCKET_SIZE; s++)
+                    if (detail::is_used(m_buckets[b].ctrl[s]))
+                        other.insert_new(std::move(m_buckets[b].slots[s].key), std::move(m_buckets[b].slots[s].val));
+            for (auto &kv : m_stash)
+                other.insert_new(std::move(kv.first), std::move(kv.second));
+            other.m_size = m_size;
+            *this = std::move(other);
+        }
+
+        // Move stashed keys back into the buckets once a removal frees a slot
+        void drain_stash() noexcept
+        {
+            for (size_t i = 0; i < m_stash.size();)
+            {
+                const auto pos = position(m_stash[i].first);
+                size_t b = pos.b1;
+                size_t s = empty_slot(b);
+                if (s == BUCKET_SIZE)
+                {
+                    b = pos.b2;
+                    s = empty_slot(b);
+                }
+                if (s == BUCKET_SIZE)
+                {
+                    i++;
+                    continue;
+                }
+                m_buckets[b].ctrl[s] = pos.tag;
+                m_buckets[b].slots[s].key = std::move(m_stash[i].first);
+                m_buckets[b].slots[s].val = std::move(m_stash[i].second);
+                m_stash.erase(m_stash.begin() + i);
+            }
+        }
+
+    public:
+        // ctors
+        CuckooHashTable() noexcept : m_mask(0), m_size(0) {}
+
+        // copy operations
+        CuckooHashTable(const CuckooHashTable &other) noexcept : m_mask(other.m_mask), m_size(other.m_size), m_stash(other.m_stash)
+        {
+            if (other.m_buckets)
+            {
+                m_buckets = std::make_unique<Bucket[]>(other.n_buckets());
+                std::copy(other.m_buckets.get(), other.m_buckets.get() + other.n_buckets(), m_buckets.get());
+            }
+        }
+        CuckooHashTable &operator=(const CuckooHashTable &other) noexcept
+        {
+            if (this != &other)
+                *this = CuckooHashTable(other);
+            return *this;
+        }
+
+        // move operations
+        CuckooHashTable(CuckooHashTable &&other) noexcept
+            : m_buckets(std::move(other.m_buckets)), m_mask(other.m_mask), m_size(other.m_size), m_stash(std::move(other.m_stash))
+        {
+            other.m_mask = 0;
+            other.m_size = 0;
+        }
+        CuckooHashTable &operator=(CuckooHashTable &&other) noexcept
+        {
+            m_buckets = std::move(other.m_buckets);
+            m_mask = other.m_mask;
+            m_size = other.m_size;
+            m_stash = std::move(other.m_stash);
+            other.m_mask = 0;
+            other.m_size = 0;
+            other.m_stash.clear();
+            return *this;
+        }
+
+        // getters
+        [[nodiscard]] constexpr size_t capacity() const noexcept { return n_buckets() * BUCKET_SIZE; }
+        [[nodiscard]] constexpr size_t size() const noexcept { return m_size; }
+        [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+        [[nodiscard]] size_t stash_size() const noexcept { return m_stash.size(); }
+        [[nodiscard]] float load_factor() const noexcept { return capacity() == 0 ? 0 : static_cast<float>(m_size) / static_cast<float>(capacity()); }
+
+        // functions
+        template <typename KK, typename VV>
+        std::optional<V> emplace(KK &&key, VV &&val) noexcept
+        {
+            auto v = find(key);
+            if (v)
+            {
+                V old = std::move(*v.value());
+                *v.value() = std::forward<VV>(val);
+                return old;
+            }
+
+            if (!m_buckets)
+                init(INIT_BUCKETS);
+            insert_new(std::forward<KK>(key), std::forward<VV>(val));
+            m_size += 1;
+            return std::nullopt;
+        }
+
+        std::optional<V *> find(const K &key) noexcept
+        {
+            const auto v = static_cast<const CuckooHashTable *>(this)->find(key);
+            if (!v)
+                return std::nullopt;
+            return const_cast<V *>(v.value());
+        }
+
+        std::optional<const V *> find(const K &key) const noexcept
+        {
+            if (!m_buckets)
+                return std::nullopt;
+
+            const auto pos = position(key);
+            size_t s = find_in_bucket(pos.b1, pos.tag, key);
+            if (s != BUCKET_SIZE)
+                return &m_buckets[pos.b1].slots[s].val;
+            s = find_in_bucket(pos.b2, pos.tag, key);
+            if (s != BUCKET_SIZE)
+                return &m_buckets[pos.b2].slots[s].val;
+
+            // The stash is empty unless the table is near its limit
+            if (!m_stash.empty())
+            {
+                const size_t i = stash_index(key);
+                if (i != m_stash.size())
+                    return &m_stash[i].second;
+            }
+            return std::nullopt;
+        }
+
+        std::optional<std::pair<K, V>> remove(const K &key) noexcept
+        {
+            if (!m_buckets)
+                return std::nullopt;
+
+            const auto pos = position(key);
+            for (const size_t b : {pos.b1, pos.b2})
+            {
+                const size_t s = find_in_bucket(b, pos.tag, key);
+                if (s != BUCKET_SIZE)
+                {
+                    m_buckets[b].ctrl[s] = detail::CTRL_EMPTY;
+                    m_size -= 1;
+                    std::pair<K, V> kv(std::move(m_buckets[b].slots[s].key), std::move(m_buckets[b].slots[s].val));
+                    if (!m_stash.empty())
+                        drain_stash();
+                    return kv;
+                }
+            }
+
+            const size_t i = stash_index(key);
+            if (i == m_stash.size())
+                return std::nullopt;
+            std::pair<K, V> kv = std::move(m_stash[i]);
+            m_stash.erase(m_stash.begin() + i);
+            m_size -= 1;
+            return kv;
+        }
+
+        // Calls fn(key, val) on every element
+        template <typename Fn>
+        void for_each(Fn &&fn)
+        {
+            for (size_t b = 0; b < n_buckets(); b++)
+                for (size_t s = 0; s < BUCKET_SIZE; s++)
+                    if (detail::is_used(m_buckets[b].ctrl[s]))
+                        fn(static_cast<const K &>(m_buckets[b].slots[s].key), m_buckets[b].slots[s].val);
+            for (auto &kv : m_stash)
+                fn(static_cast<const K &>(kv.first), kv.second);
+        }
+
+        void reserve(size_t n) noexcept
+        {
+            size_t buckets = std::max(n_buckets(), INIT_BUCKETS);
+            while (static_cast<float>(n) > TARGET_LOAD_FACTOR * static_cast<float>(buckets * BUCKET_SIZE))
+                buckets *= 2;
+            if (buckets > n_buckets())
+                rehash(buckets);
+        }
+    };
+}
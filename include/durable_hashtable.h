@@ -0,0 +1,498 @@
+#pragma once
+
+#include "codec.h"
+#include "hashtable.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace HashTable
+{
+    namespace detail
+    {
+        [[noreturn]] inline void throw_errno(const std::string &what)
+        {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        // Owning POSIX file descriptor
+        class File
+        {
+        private:
+            int m_fd;
+
+        public:
+            // ctors
+            File() noexcept : m_fd(-1) {}
+            File(const std::string &path, int flags)
+                : m_fd(::open(path.c_str(), flags | O_CLOEXEC, 0644))
+            {
+                if (m_fd < 0)
+                    throw_errno("open " + path);
+            }
+            ~File() noexcept
+            {
+                if (m_fd >= 0)
+                    ::close(m_fd);
+            }
+
+            // move operations
+            File(File &&other) noexcept : m_fd(std::exchange(other.m_fd, -1)) {}
+            File &operator=(File &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    if (m_fd >= 0)
+                        ::close(m_fd);
+                    m_fd = std::exchange(other.m_fd, -1);
+                }
+                return *this;
+            }
+
+            void write_all(const void *data, size_t n)
+            {
+                const auto *p = static_cast<const char *>(data);
+                while (n > 0)
+                {
+                    const ssize_t w = ::write(m_fd, p, n);
+                    if (w < 0 && errno == EINTR)
+                        continue;
+                    if (w < 0)
+                        throw_errno("write");
+                    p += w;
+                    n -= static_cast<size_t>(w);
+                }
+            }
+
+            void write_at(size_t offset, const void *data, size_t n)
+            {
+                const auto *p = static_cast<const char *>(data);
+                while (n > 0)
+                {
+                    const ssize_t w = ::pwrite(m_fd, p, n, static_cast<off_t>(offset));
+                    if (w < 0 && errno == EINTR)
+                        continue;
+                    if (w < 0)
+                        throw_errno("pwrite");
+                    p += w;
+                    offset += static_cast<size_t>(w);
+                    n -= static_cast<size_t>(w);
+                }
+            }
+
+            // Returns the bytes read, smaller than n only at the end of the file
+            size_t read_some(void *data, size_t n)
+            {
+                auto *p = static_cast<char *>(data);
+                size_t total = 0;
+                while (total < n)
+                {
+                    const ssize_t r = ::read(m_fd, p + total, n - total);
+                    if (r < 0 && errno == EINTR)
+                        continue;
+                    if (r < 0)
+                        throw_errno("read");
+                    if (r == 0)
+                        break;
+                    total += static_cast<size_t>(r);
+                }
+                return total;
+            }
+
+            void sync()
+            {
+                if (::fdatasync(m_fd) != 0)
+                    throw_errno("fdatasync");
+            }
+
+            void truncate(size_t n)
+            {
+                if (::ftruncate(m_fd, static_cast<off_t>(n)) != 0 || ::lseek(m_fd, static_cast<off_t>(n), SEEK_SET) < 0)
+                    throw_errno("truncate");
+            }
+
+            // Make a rename or create in the directory durable
+            static void sync_dir(const std::string &dir)
+            {
+                File d(dir, O_RDONLY | O_DIRECTORY);
+                if (::fsync(d.m_fd) != 0)
+                    throw_errno("fsync " + dir);
+            }
+        };
+
+        // Buffered sequential reader, the checkpoint & the log are streamed through it instead of loaded whole
+        class FileReader
+        {
+        private:
+            static constexpr size_t BUF_SIZE = 1 << 20;
+
+            File m_file;
+            std::vector<char> m_buf;
+            size_t m_base; // File offset of the buffer
+            size_t m_pos;
+            size_t m_end;
+
+        public:
+            explicit FileReader(File file) : m_file(std::move(file)), m_buf(BUF_SIZE), m_base(0), m_pos(0), m_end(0) {}
+
+            // File offset of the next byte
+            [[nodiscard]] size_t pos() const noexcept { return m_base + m_pos; }
+
+            // Returns false if the file ends first
+            [[nodiscard]] bool read(void *data, size_t n)
+            {
+                auto *p = static_cast<char *>(data);
+                while (n > 0)
+                {
+                    if (m_pos == m_end)
+                    {
+                        m_base += m_end;
+                        m_pos = 0;
+                        m_end = m_file.read_some(m_buf.data(), m_buf.size());
+                        if (m_end == 0)
+                            return false;
+                    }
+                    const size_t c = std::min(n, m_end - m_pos);
+                    std::memcpy(p, m_buf.data() + m_pos, c);
+                    m_pos += c;
+                    p += c;
+                    n -= c;
+                }
+                return true;
+            }
+        };
+    }
+
+    struct DurableOptions
+    {
+        size_t group_commit = 64;                   // Log records per write & fdatasync, 1 makes every operation durable on return
+        size_t checkpoint_bytes = size_t(64) << 20; // Log size that triggers a checkpoint, 0 never checkpoints on its own
+    };
+
+    // HashTable persisted in a directory as a checkpoint of its contents plus a write-ahead log of the operations after it.
+    // Records are buffered & written with one fdatasync per group_commit records, a crash loses at most the records of the open group.
+    // A checkpoint is written to a temporary file & renamed over the old one, then the log restarts under a new generation, so a
+    // crash at any point leaves either the old checkpoint & its log or the new checkpoint.
+    // I/O errors throw std::system_error
+    template <typename K, typename V, typename Policy = DefaultPolicy>
+    class DurableHashTable
+    {
+    private:
+        using KCodec = detail::Codec<K>;
+        using VCodec = detail::Codec<V>;
+
+        enum Op : uint8_t
+        {
+            OP_EMPLACE = 1,
+            OP_REMOVE = 2
+        };
+
+        static constexpr uint32_t CHECKPOINT_MAGIC = 0x50434854; // "THCP"
+        static constexpr uint32_t LOG_MAGIC = 0x4C574854;        // "THWL"
+
+        // Both files start with a header, the checkpoint's count lets recovery reserve before streaming it
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t crc; // Of the checkpoint entries, unused in the log
+            uint64_t generation;
+            uint64_t count;      // Entries of a checkpoint, unused in the log
+            uint32_t header_crc; // Of the fields above, checked before any of them is used
+            uint32_t reserved;
+        };
+
+        [[nodiscard]] static uint32_t header_crc(const Header &h) noexcept { return detail::crc32c(&h, offsetof(Header, header_crc)); }
+
+        // Bytes of the smallest encoded entry, bounds the count a checkpoint of a given size can hold
+        [[nodiscard]] static size_t min_entry_bytes()
+        {
+            std::string enc;
+            KCodec::encode(enc, K());
+            VCodec::encode(enc, V());
+            return std::max<size_t>(enc.size(), 1);
+        }
+
+        [[noreturn]] static void throw_corrupt(const char *what)
+        {
+            throw std::system_error(std::make_error_code(std::errc::illegal_byte_sequence), what);
+        }
+
+        HashTable<K, V, Policy> m_table;
+        DurableOptions m_options;
+        std::string m_dir;
+        detail::File m_log;
+        std::string m_pending; // Encoded records not yet written
+        size_t m_pending_records;
+        size_t m_log_bytes;
+        uint64_t m_generation;
+
+        [[nodiscard]] std::string path(const char *name) const { return m_dir + "/" + name; }
+
+        // [op][key][val][crc of the preceding bytes], a torn or corrupt record ends the replay
+        template <typename VV>
+        void append(Op op, const K &key, const VV *val)
+        {
+            const size_t begin = m_pending.size();
+            m_pending.push_back(static_cast<char>(op));
+            KCodec::encode(m_pending, key);
+            if (val != nullptr)
+                VCodec::encode(m_pending, *val);
+            const uint32_t crc = detail::crc32c(m_pending.data() + begin, m_pending.size() - begin);
+            m_pending.append(reinterpret_cast<const char *>(&crc), sizeof(crc));
+
+            m_pending_records += 1;
+            if (m_pending_records >= m_options.group_commit)
+                sync();
+        }
+
+        void maybe_checkpoint()
+        {
+            if (m_options.checkpoint_bytes != 0 && log_bytes() >= m_options.checkpoint_bytes)
+                checkpoint();
+        }
+
+        void open_log(uint64_t generation)
+        {
+            const std::string tmp = path("wal.tmp");
+            detail::File f(tmp, O_WRONLY | O_CREAT | O_TRUNC);
+            Header h{LOG_MAGIC, 0, generation, 0, 0, 0};
+            h.header_crc = header_crc(h);
+            f.write_all(&h, sizeof(h));
+            f.sync();
+            if (::rename(tmp.c_str(), path("wal").c_str()) != 0)
+                detail::throw_errno("rename " + tmp);
+            detail::File::sync_dir(m_dir);
+
+            m_log = detail::File(path("wal"), O_WRONLY | O_APPEND);
+            m_log_bytes = sizeof(Header);
+        }
+
+        [[nodiscard]] uint64_t load_checkpoint()
+        {
+            if (!std::filesystem::exists(path("checkpoint")))
+                return 0;
+
+            const size_t file_size = std::filesystem::file_size(path("checkpoint"));
+            detail::FileReader in(detail::File(path("checkpoint"), O_RDONLY));
+            Header h;
+            if (!in.read(&h, sizeof(h)) || h.magic != CHECKPOINT_MAGIC || h.header_crc != header_crc(h))
+                throw_corrupt("bad checkpoint header");
+            if (h.count > (file_size - sizeof(h)) / min_entry_bytes())
+                throw_corrupt("bad checkpoint count");
+
+            m_table.reserve(h.count);
+            std::string enc;
+            uint32_t crc = 0;
+            K key;
+            V val;
+            for (uint64_t i = 0; i < h.count; i++)
+            {
+                if (!KCodec::decode(in, key) || !VCodec::decode(in, val))
+                    throw_corrupt("truncated checkpoint");
+                enc.clear();
+                KCodec::encode(enc, key);
+                VCodec::encode(enc, val);
+                crc = detail::crc32c(enc.data(), enc.size(), crc);
+                m_table.emplace(std::move(key), std::move(val));
+            }
+            if (crc != h.crc)
+                throw_corrupt("corrupt checkpoint");
+            return h.generation;
+        }
+
+        // Decodes one record, returns false at a torn or corrupt tail. The crc is checked over the record encoded again in enc
+        [[nodiscard]] static bool read_record(detail::FileReader &in, std::string &enc, Op &op, K &key, V &val)
+        {
+            uint8_t raw_op;
+            if (!in.read(&raw_op, 1) || (raw_op != OP_EMPLACE && raw_op != OP_REMOVE))
+                return false;
+            op = static_cast<Op>(raw_op);
+            if (!KCodec::decode(in, key) || (op == OP_EMPLACE && !VCodec::decode(in, val)))
+                return false;
+            enc.assign(1, static_cast<char>(raw_op));
+            KCodec::encode(enc, key);
+            if (op == OP_EMPLACE)
+                VCodec::encode(enc, val);
+            uint32_t crc;
+            return in.read(&crc, sizeof(crc)) && crc == detail::crc32c(enc.data(), enc.size());
+        }
+
+        // Opens the log & reads its header, returns nothing if it does not follow the checkpoint
+        [[nodiscard]] std::optional<detail::FileReader> open_log_reader(uint64_t generation) const
+        {
+            detail::FileReader in(detail::File(path("wal"), O_RDONLY));
+            Header h;
+            if (!in.read(&h, sizeof(h)) || h.magic != LOG_MAGIC || h.header_crc != header_crc(h) || h.generation != generation)
+                return std::nullopt; // A stale log left by a crash right after a checkpoint
+            return in;
+        }
+
+        // Replay the log if it follows the checkpoint, returns the bytes of its valid prefix or 0 if it does not apply.
+        // The log is streamed a record at a time, it may be far larger than memory when checkpoints are off
+        [[nodiscard]] size_t replay_log(uint64_t generation)
+        {
+            if (!std::filesystem::exists(path("wal")))
+                return 0;
+            auto in = open_log_reader(generation);
+            if (!in)
+                return 0;
+
+            // First pass counts the inserts, so the table grows once
+            std::string enc;
+            Op op;
+            K key;
+            V val;
+            size_t n_emplace = 0;
+            while (read_record(*in, enc, op, key, val))
+                n_emplace += op == OP_EMPLACE;
+            m_table.reserve(m_table.size() + n_emplace);
+
+            auto replay = open_log_reader(generation);
+            size_t valid = replay->pos();
+            while (read_record(*replay, enc, op, key, val))
+            {
+                if (op == OP_EMPLACE)
+                    m_table.emplace(std::move(key), std::move(val));
+                else
+                    m_table.remove(key);
+                valid = replay->pos();
+            }
+            return valid;
+        }
+
+    public:
+        // ctors
+        // Opens or creates the table in dir, recovering the checkpoint & replaying the log after it
+        explicit DurableHashTable(const std::string &dir, DurableOptions options = {})
+            : m_options(options), m_dir(dir), m_pending_records(0), m_log_bytes(0), m_generation(0)
+        {
+            if (m_options.group_commit == 0)
+                m_options.group_commit = 1;
+            std::filesystem::create_directories(m_dir);
+            m_generation = load_checkpoint();
+            const size_t valid = replay_log(m_generation);
+            if (valid == 0)
+                open_log(m_generation);
+            else
+            {
+                // Drop the torn tail so new records follow the last valid one
+                m_log = detail::File(path("wal"), O_WRONLY | O_APPEND);
+                m_log.truncate(valid);
+                m_log_bytes = valid;
+            }
+        }
+        ~DurableHashTable() noexcept
+        {
+            try
+            {
+                sync();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        DurableHashTable(const DurableHashTable &) = delete;
+        DurableHashTable &operator=(const DurableHashTable &) = delete;
+
+        // getters
+        [[nodiscard]] size_t size() const noexcept { return m_table.size(); }
+        [[nodiscard]] bool empty() const noexcept { return m_table.empty(); }
+        [[nodiscard]] size_t capacity() const noexcept { return m_table.capacity(); }
+        [[nodiscard]] const HashTable<K, V, Policy> &table() const noexcept { return m_table; }
+        [[nodiscard]] auto key_values() const noexcept { return m_table.key_values(); }
+        [[nodiscard]] size_t log_bytes() const noexcept { return m_log_bytes + m_pending.size(); }
+        [[nodiscard]] uint64_t generation() const noexcept { return m_generation; }
+
+        // functions
+        // Values are read only, a write through a pointer would bypass the log
+        [[nodiscard]] std::optional<const V *> find(const K &key) const noexcept
+        {
+            return m_table.find(key);
+        }
+
+        template <typename KK, typename VV>
+        std::optional<V> emplace(KK &&key, VV &&val)
+        {
+            append(OP_EMPLACE, key, &val);
+            auto old = m_table.emplace(std::forward<KK>(key), std::forward<VV>(val));
+            maybe_checkpoint();
+            return old;
+        }
+
+        std::optional<std::pair<K, V>> remove(const K &key)
+        {
+            if (!m_table.find(key))
+                return std::nullopt;
+            append<V>(OP_REMOVE, key, nullptr);
+            auto kv = m_table.remove(key);
+            maybe_checkpoint();
+            return kv;
+        }
+
+        // Write & fdatasync the open group, every operation before it is durable on return
+        void sync()
+        {
+            if (m_pending.empty())
+                return;
+            m_log.write_all(m_pending.data(), m_pending.size());
+            m_log.sync();
+            m_log_bytes += m_pending.size();
+            m_pending.clear();
+            m_pending_records = 0;
+        }
+
+        // Write the contents to a new checkpoint & start an empty log
+        void checkpoint()
+        {
+            sync();
+            const std::string tmp = path("checkpoint.tmp");
+            {
+                detail::File f(tmp, O_WRONLY | O_CREAT | O_TRUNC);
+                Header h{CHECKPOINT_MAGIC, 0, m_generation + 1, m_table.size(), 0, 0};
+                f.write_all(&h, sizeof(h));
+
+                constexpr size_t FLUSH_BYTES = 1 << 20;
+                std::string buf;
+                for (const auto [k, v] : m_table.key_values())
+                {
+                    const size_t begin = buf.size();
+                    KCodec::encode(buf, k);
+                    VCodec::encode(buf, v);
+                    h.crc = detail::crc32c(buf.data() + begin, buf.size() - begin, h.crc);
+                    if (buf.size() >= FLUSH_BYTES)
+                    {
+                        f.write_all(buf.data(), buf.size());
+                        buf.clear();
+                    }
+                }
+                f.write_all(buf.data(), buf.size());
+
+                // The header is rewritten with the crc of the entries & then its own
+                h.header_crc = header_crc(h);
+                f.write_at(0, &h, sizeof(h));
+                f.sync();
+            }
+            if (::rename(tmp.c_str(), path("checkpoint").c_str()) != 0)
+                detail::throw_errno("rename " + tmp);
+            detail::File::sync_dir(m_dir);
+
+            m_generation += 1;
+            open_log(m_generation);
+        }
+    };
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace HashTable
+{
+    // Hash table where every entry carries a deadline
+    // Expired entries are absent to find(), reclaimed when found and reclaimed a few at a time on every emplace().
+    // A min-heap of deadlines points the sweep at the entries to expire, so it never scans the table
+    template <typename K, typename V, typename Clock = std::chrono::steady_clock, typename Policy = DefaultPolicy>
+    class ExpiringHashTable
+    {
+    public:
+        using time_point = typename Clock::time_point;
+        using duration = typename Clock::duration;
+        static constexpr size_t DEFAULT_SWEEP_BUDGET = 8;
+
+    private:
+        struct Entry
+        {
+            V val;
+            time_point deadline;
+        };
+
+        // Heap entries are not removed on update or removal, they are skipped when their deadline no longer matches
+        using Deadline = std::pair<time_point, K>;
+        struct Later
+        {
+            bool operator()(const Deadline &a, const Deadline &b) const noexcept { return a.first > b.first; }
+        };
+
+        HashTable<K, Entry, Policy> m_table;
+        std::vector<Deadline> m_deadlines;
+        size_t m_sweep_budget;
+
+        void push_deadline(const K &key, time_point deadline) noexcept
+        {
+            // Rebuild the heap from the table when stale entries outnumber live ones. Done before the push, as the key may
+            // not be in the table yet
+            if (m_deadlines.size() >= 2 * m_table.size() + 64)
+            {
+                m_deadlines.clear();
+                for (const auto [k, e] : m_table.key_values())
+                    m_deadlines.emplace_back(e.deadline, k);
+                std::make_heap(m_deadlines.begin(), m_deadlines.end(), Later());
+            }
+
+            m_deadlines.emplace_back(deadline, key);
+            std::push_heap(m_deadlines.begin(), m_deadlines.end(), Later());
+        }
+
+    public:
+        // ctors
+        ExpiringHashTable() noexcept : m_sweep_budget(DEFAULT_SWEEP_BUDGET) {}
+
+        // getters
+        // size() counts expired entries that are not reclaimed yet
+        [[nodiscard]] constexpr size_t size() const noexcept { return m_table.size(); }
+        [[nodiscard]] constexpr size_t capacity() const noexcept { return m_table.capacity(); }
+        [[nodiscard]] constexpr bool empty() const noexcept { return m_table.empty(); }
+        [[nodiscard]] constexpr size_t sweep_budget() const noexcept { return m_sweep_budget; }
+
+        // setters
+        // Max number of deadlines checked by the sweep on every emplace()
+        void sweep_budget(size_t budget) noexcept { m_sweep_budget = budget; }
+
+        // functions
+        // Insert or update a key that expires at the deadline. Returns the old value if it was not expired
+        template <typename KK, typename VV>
+        std::optional<V> emplace_until(KK &&key, VV &&val, time_point deadline) noexcept
+        {
+            const time_point now = Clock::now();
+            expire(m_sweep_budget, now);
+
+            push_deadline(key, deadline);
+            auto old = m_table.emplace(std::forward<KK>(key), Entry{V(std::forward<VV>(val)), deadline});
+            if (!old || old->deadline <= now)
+                return std::nullopt;
+            return std::move(old->val);
+        }
+
+        // Insert or update a key that expires after ttl
+        template <typename KK, typename VV>
+        std::optional<V> emplace(KK &&key, VV &&val, duration ttl) noexcept
+        {
+            return emplace_until(std::forward<KK>(key), std::forward<VV>(val), Clock::now() + ttl);
+        }
+
+        // Find a live entry, an expired entry is removed & reported as absent
+        std::optional<V *> find(const K &key) noexcept
+        {
+            const auto e = m_table.find(key);
+            if (!e)
+                return std::nullopt;
+            if (e.value()->deadline <= Clock::now())
+            {
+                m_table.remove(key);
+                return std::nullopt;
+            }
+            return &e.value()->val;
+        }
+
+        // Deadline of a live entry
+        [[nodiscard]] std::optional<time_point> deadline(const K &key) const noexcept
+        {
+            const auto e = m_table.find(key);
+            if (!e || e.value()->deadline <= Clock::now())
+                return std::nullopt;
+            return e.value()->deadline;
+        }
+
+        // Remove a key, returns the key & value if it was not expired
+        std::optional<std::pair<K, V>> remove(const K &key) noexcept
+        {
+            auto kv = m_table.remove(key);
+            if (!kv || kv->second.deadline <= Clock::now())
+                return std::nullopt;
+            return std::pair<K, V>(std::move(kv->first), std::move(kv->second.val));
+        }
+
+        // Reclaim entries expired by now, checking at most budget deadlines. Returns the number of reclaimed entries
+        size_t expire(size_t budget, time_point now = Clock::now()) noexcept
+        {
+            size_t reclaimed = 0;
+            for (size_t i = 0; i < budget && !m_deadlines.empty() && m_deadlines.front().first <= now; i++)
+            {
+                std::pop_heap(m_deadlines.begin(), m_deadlines.end(), Later());
+                Deadline d = std::move(m_deadlines.back());
+                m_deadlines.pop_back();
+
+                // Skip if the key was removed or got a new deadline
+                const auto e = m_table.find(d.second);
+                if (e && e.value()->deadline == d.first)
+                {
+                    m_table.remove(d.second);
+                    reclaimed += 1;
+                }
+            }
+            return reclaimed;
+        }
+
+        // Reclaim every entry expired by now
+        size_t expire_all(time_point now = Clock::now()) noexcept
+        {
+            return expire(m_deadlines.size(), now);
+        }
+    };
+}
@@ -0,0 +1,357 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace HashTable
+{
+    // Hash Aggregation
+    // GROUP BY over column batches of keys & values. A batch is hashed in bulk, then each row is resolved to a group id with
+    // a single probe, then each aggregate runs as its own loop over the batch into a column of per-group state
+
+    // Aggregates kept per group, or-ed together
+    enum Aggregates : unsigned
+    {
+        AGG_SUM = 1,
+        AGG_COUNT = 2,
+        AGG_MIN = 4,
+        AGG_MAX = 8,
+        AGG_ALL = AGG_SUM | AGG_COUNT | AGG_MIN | AGG_MAX,
+    };
+
+    template <typename K, typename V, unsigned Aggs, typename Policy>
+    class PartitionedAggregate;
+
+    namespace detail
+    {
+        // Per-group state, one column per aggregate in Aggs & the group keys. Columns of dropped aggregates stay empty
+        template <typename K, typename V, unsigned Aggs>
+        struct AggColumns
+        {
+            std::vector<K> keys;
+            std::vector<V> sum;
+            std::vector<uint64_t> count;
+            std::vector<V> min;
+            std::vector<V> max;
+
+            [[nodiscard]] size_t size() const noexcept { return keys.size(); }
+
+            // New groups start from the identity of each aggregate
+            void resize(size_t n)
+            {
+                if constexpr ((Aggs & AGG_SUM) != 0)
+                    sum.resize(n, V{});
+                if constexpr ((Aggs & AGG_COUNT) != 0)
+                    count.resize(n, 0);
+                if constexpr ((Aggs & AGG_MIN) != 0)
+                    min.resize(n, std::numeric_limits<V>::max());
+                if constexpr ((Aggs & AGG_MAX) != 0)
+                    max.resize(n, std::numeric_limits<V>::lowest());
+            }
+
+            // Append group g of other
+            void push_back(const AggColumns &other, size_t g)
+            {
+                keys.push_back(other.keys[g]);
+                if constexpr ((Aggs & AGG_SUM) != 0)
+                    sum.push_back(other.sum[g]);
+                if constexpr ((Aggs & AGG_COUNT) != 0)
+                    count.push_back(other.count[g]);
+                if constexpr ((Aggs & AGG_MIN) != 0)
+                    min.push_back(other.min[g]);
+                if constexpr ((Aggs & AGG_MAX) != 0)
+                    max.push_back(other.max[g]);
+            }
+
+            void clear() noexcept
+            {
+                keys.clear();
+                sum.clear();
+                count.clear();
+                min.clear();
+                max.clear();
+            }
+        };
+    }
+
+    // Groups in the order their keys were first seen, group g has key keys()[g], sum sums()[g] & so on. Values must be
+    // arithmetic, sums are kept in V
+    template <typename K, typename V, unsigned Aggs = AGG_ALL, typename Policy = DefaultPolicy>
+    class HashAggregate
+    {
+        static_assert(std::is_arithmetic_v<V>, "Aggregated values must be arithmetic");
+        static_assert(Aggs != 0 && (Aggs & ~unsigned(AGG_ALL)) == 0, "Aggs must be a non-empty set of Aggregates");
+
+        template <typename, typename, unsigned, typename>
+        friend class PartitionedAggregate;
+
+    public:
+        static constexpr size_t BATCH = 1024;                    // Rows per pass, their hashes & group ids stay in L1
+        static constexpr size_t PREFETCH_DISTANCE = 16;          // Rows between the prefetch of a home slot & its probe
+        static constexpr size_t PREFETCH_MIN_CAPACITY = 1 << 16; // Smaller indexes stay in cache & skip the prefetches
+
+    private:
+        using Columns = detail::AggColumns<K, V, Aggs>;
+
+        HashTable<K, uint32_t, Policy> m_index; // Key to group id
+        Columns m_cols;
+
+        // Group ids of n rows with precomputed hashes, unseen keys open new groups
+        void resolve(const K *keys, const size_t *hashes, uint32_t *groups, size_t n)
+        {
+            const size_t old_size = size();
+            const bool far = m_index.capacity() > PREFETCH_MIN_CAPACITY;
+            for (size_t i = 0; i < n; i++)
+            {
+                if (far && i + PREFETCH_DISTANCE < n)
+                    m_index.prefetch(hashes[i + PREFETCH_DISTANCE]);
+                const auto [g, added] = m_index.find_or_emplace(keys[i], hashes[i], static_cast<uint32_t>(m_cols.keys.size()));
+                if (added)
+                    m_cols.keys.push_back(keys[i]);
+                groups[i] = *g;
+            }
+            assert(size() <= std::numeric_limits<uint32_t>::max());
+            if (size() != old_size)
+                m_cols.resize(size());
+        }
+
+        // Fold n rows into their groups, one loop per aggregate
+        void update(const uint32_t *groups, const V *vals, size_t n) noexcept
+        {
+            if constexpr ((Aggs & AGG_SUM) != 0)
+            {
+                V *sum = m_cols.sum.data();
+                for (size_t i = 0; i < n; i++)
+                    sum[groups[i]] += vals[i];
+            }
+            if constexpr ((Aggs & AGG_COUNT) != 0)
+            {
+                uint64_t *count = m_cols.count.data();
+                for (size_t i = 0; i < n; i++)
+                    count[groups[i]] += 1;
+            }
+            if constexpr ((Aggs & AGG_MIN) != 0)
+            {
+                V *min = m_cols.min.data();
+                for (size_t i = 0; i < n; i++)
+                    min[groups[i]] = std::min(min[groups[i]], vals[i]);
+            }
+            if constexpr ((Aggs & AGG_MAX) != 0)
+            {
+                V *max = m_cols.max.data();
+                for (size_t i = 0; i < n; i++)
+                    max[groups[i]] = std::max(max[groups[i]], vals[i]);
+            }
+        }
+
+        // Fold n partial groups from b of other into their groups
+        void update(const uint32_t *groups, const Columns &other, size_t b, size_t n) noexcept
+        {
+            if constexpr ((Aggs & AGG_SUM) != 0)
+                for (size_t i = 0; i < n; i++)
+                    m_cols.sum[groups[i]] += other.sum[b + i];
+            if constexpr ((Aggs & AGG_COUNT) != 0)
+                for (size_t i = 0; i < n; i++)
+                    m_cols.count[groups[i]] += other.count[b + i];
+            if constexpr ((Aggs & AGG_MIN) != 0)
+                for (size_t i = 0; i < n; i++)
+                    m_cols.min[groups[i]] = std::min(m_cols.min[groups[i]], other.min[b + i]);
+            if constexpr ((Aggs & AGG_MAX) != 0)
+                for (size_t i = 0; i < n; i++)
+                    m_cols.max[groups[i]] = std::max(m_cols.max[groups[i]], other.max[b + i]);
+        }
+
+        void merge(const Columns &other)
+        {
+            size_t hashes[BATCH];
+            uint32_t groups[BATCH];
+            for (size_t b = 0; b < other.size(); b += BATCH)
+            {
+                const size_t n = std::min(BATCH, other.size() - b);
+                for (size_t i = 0; i < n; i++)
+                    hashes[i] = m_index.hash(other.keys[b + i]);
+                resolve(other.keys.data() + b, hashes, groups, n);
+                update(groups, other, b, n);
+            }
+        }
+
+    public:
+        // getters
+        [[nodiscard]] size_t size() const noexcept { return m_cols.size(); }
+        [[nodiscard]] bool empty() const noexcept { return m_cols.size() == 0; }
+        [[nodiscard]] const std::vector<K> &keys() const noexcept { return m_cols.keys; }
+        [[nodiscard]] const std::vector<V> &sums() const noexcept { return m_cols.sum; }
+        [[nodiscard]] const std::vector<uint64_t> &counts() const noexcept { return m_cols.count; }
+        [[nodiscard]] const std::vector<V> &mins() const noexcept { return m_cols.min; }
+        [[nodiscard]] const std::vector<V> &maxs() const noexcept { return m_cols.max; }
+
+        // functions
+        // Aggregate n rows, vals[i] into the group of keys[i]
+        void consume(const K *keys, const V *vals, size_t n)
+        {
+            // Tables of a few slots probe slot by slot near their end, start with room for a batch of groups
+            if (m_index.capacity() == 0)
+                reserve(std::min(n, BATCH));
+
+            size_t hashes[BATCH];
+            uint32_t groups[BATCH];
+            for (size_t b = 0; b < n; b += BATCH)
+            {
+                const size_t m = std::min(BATCH, n - b);
+                for (size_t i = 0; i < m; i++)
+                    hashes[i] = m_index.hash(keys[b + i]);
+                resolve(keys + b, hashes, groups, m);
+                update(groups, vals + b, m);
+            }
+        }
+
+        // Fold the groups of other in, e.g. partial aggregates of other threads
+        void merge(const HashAggregate &other) { merge(other.m_cols); }
+
+        // Group id of key
+        [[nodiscard]] std::optional<size_t> group(const K &key) const noexcept
+        {
+            const auto g = m_index.find(key);
+            if (!g)
+                return std::nullopt;
+            return *g.value();
+        }
+
+        void reserve(size_t groups)
+        {
+            m_index.reserve(groups);
+            m_cols.keys.reserve(groups);
+        }
+
+        // Drop every group, keeping the capacity
+        void clear() noexcept
+        {
+            m_index.clear();
+            m_cols.clear();
+        }
+    };
+
+    // Aggregation into more groups than the caches hold. Rows are aggregated into a local table of about local_groups groups
+    // first. Once it is full, its partial groups are spilled by the top radix_bits of their mixed hash into 2^radix_bits
+    // partitions & the local table starts over. flush() aggregates each partition on its own, into a table 2^radix_bits
+    // times smaller than a single one would be.
+    // Keys repeated within the reach of the local table are folded before they are spilled. If the local table folds fewer
+    // than MIN_REDUCTION rows per group, the rows up to the next flush() skip it & go straight to their partition
+    template <typename K, typename V, unsigned Aggs = AGG_ALL, typename Policy = DefaultPolicy>
+    class PartitionedAggregate
+    {
+    public:
+        using Aggregate = HashAggregate<K, V, Aggs, Policy>;
+        static constexpr size_t DEFAULT_RADIX_BITS = 8;
+        static constexpr size_t DEFAULT_LOCAL_GROUPS = 1 << 14; // About 1 MB of index & state for 8-byte keys & values
+        static constexpr size_t MIN_REDUCTION = 2;
+
+    private:
+        // Rows & partial groups waiting for flush()
+        struct Spill
+        {
+            detail::AggColumns<K, V, Aggs> groups;
+            std::vector<K> keys;
+            std::vector<V> vals;
+        };
+
+        size_t m_radix_bits;
+        size_t m_local_groups;
+        Aggregate m_local;
+        size_t m_local_rows;
+        bool m_bypass;
+        std::vector<Spill> m_spills;
+        std::vector<Aggregate> m_parts;
+
+        [[nodiscard]] size_t partition_of(const K &key) const noexcept
+        {
+            return m_radix_bits == 0 ? 0 : static_cast<size_t>(detail::mix_hash(m_local.m_index.hash(key)) >> (64 - m_radix_bits));
+        }
+
+        void spill()
+        {
+            const auto &local = m_local.m_cols;
+            for (size_t g = 0; g < local.size(); g++)
+                m_spills[partition_of(local.keys[g])].groups.push_back(local, g);
+            m_local.clear();
+            m_local_rows = 0;
+        }
+
+    public:
+        // ctors
+        explicit PartitionedAggregate(size_t radix_bits = DEFAULT_RADIX_BITS, size_t local_groups = DEFAULT_LOCAL_GROUPS)
+            : m_radix_bits(radix_bits), m_local_groups(std::max<size_t>(local_groups, 1)), m_local_rows(0), m_bypass(false),
+              m_spills(size_t(1) << radix_bits), m_parts(size_t(1) << radix_bits)
+        {
+            assert(radix_bits < 32);
+            m_local.reserve(m_local_groups + Aggregate::BATCH);
+        }
+
+        // getters
+        [[nodiscard]] size_t partitions() const noexcept { return m_parts.size(); }
+
+        // Groups of partition p as of the last flush(). Partitions hold disjoint keys
+        [[nodiscard]] const Aggregate &partition(size_t p) const noexcept { return m_parts[p]; }
+
+        // Groups as of the last flush()
+        [[nodiscard]] size_t size() const noexcept
+        {
+            size_t n = 0;
+            for (const auto &p : m_parts)
+                n += p.size();
+            return n;
+        }
+
+        // functions
+        // Aggregate n rows, vals[i] into the group of keys[i]. Visible once flushed
+        void consume(const K *keys, const V *vals, size_t n)
+        {
+            if (m_bypass)
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    Spill &s = m_spills[partition_of(keys[i])];
+                    s.keys.push_back(keys[i]);
+                    s.vals.push_back(vals[i]);
+                }
+                return;
+            }
+
+            for (size_t b = 0; b < n; b += Aggregate::BATCH)
+            {
+                const size_t m = std::min(Aggregate::BATCH, n - b);
+                m_local.consume(keys + b, vals + b, m);
+                m_local_rows += m;
+                if (m_local.size() >= m_local_groups)
+                {
+                    m_bypass = m_local_rows < MIN_REDUCTION * m_local.size();
+                    spill();
+                    if (m_bypass)
+                        return consume(keys + b + m, vals + b + m, n - b - m);
+                }
+            }
+        }
+
+        // Aggregate everything consumed so far into the partitions, one partition at a time
+        void flush()
+        {
+            spill();
+            for (size_t p = 0; p < partitions(); p++)
+            {
+                Spill &s = m_spills[p];
+                m_parts[p].merge(s.groups);
+                m_parts[p].consume(s.keys.data(), s.vals.data(), s.keys.size());
+                s = Spill();
+            }
+            m_bypass = false;
+        }
+    };
+}
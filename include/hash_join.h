@@ -0,0 +1,314 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace HashTable
+{
+    // Hash Join
+    // Equi-join of two key columns. The build side goes into a HashTable from each key to its last row & rows of equal keys
+    // are chained through a next array, which a key without duplicates never touches. The probe side is hashed a batch at a
+    // time & emits the row pair of every match
+
+    // Matching row pairs, build row build[i] joins probe row probe[i]
+    struct JoinMatches
+    {
+        std::vector<uint32_t> build;
+        std::vector<uint32_t> probe;
+
+        [[nodiscard]] size_t size() const noexcept { return build.size(); }
+        [[nodiscard]] bool empty() const noexcept { return build.empty(); }
+
+        void clear() noexcept
+        {
+            build.clear();
+            probe.clear();
+        }
+
+        void append(const JoinMatches &other)
+        {
+            build.insert(build.end(), other.build.begin(), other.build.end());
+            probe.insert(probe.end(), other.probe.begin(), other.probe.end());
+        }
+    };
+
+    template <typename K, typename Policy = DefaultPolicy>
+    class HashJoin
+    {
+    public:
+        static constexpr size_t BATCH = 1024;                    // Rows hashed per pass
+        static constexpr size_t PREFETCH_DISTANCE = 16;          // Rows between the prefetch of a home slot & its probe
+        static constexpr size_t PREFETCH_MIN_CAPACITY = 1 << 14; // Smaller tables stay in L2 & skip the prefetches
+        static constexpr uint32_t MAX_ROWS = uint32_t(1) << 31; // Rows on either side
+        static constexpr float BUILD_LOAD_FACTOR = 0.5;          // Shorter probes for misses, the table is only read after build
+
+    private:
+        static constexpr uint32_t CHAINED = MAX_ROWS; // Set on the head row of a key with duplicates
+
+        HashTable<K, uint32_t, Policy> m_heads; // Key to its last build row
+        std::vector<uint32_t> m_next;            // Build row to the previous row of its key, the first row links to itself
+
+    public:
+        // getters
+        [[nodiscard]] size_t size() const noexcept { return m_next.size(); }
+        [[nodiscard]] size_t distinct_keys() const noexcept { return m_heads.size(); }
+
+        // functions
+        // Build from n rows, row i having key keys[i]. Replaces the previous build
+        void build(const K *keys, size_t n)
+        {
+            assert(n <= MAX_ROWS);
+            m_heads = HashTable<K, uint32_t, Policy>();
+            m_heads.max_load_factor(BUILD_LOAD_FACTOR);
+            m_heads.reserve(n);
+            m_next.resize(n);
+
+            const bool far = m_heads.capacity() > PREFETCH_MIN_CAPACITY;
+            size_t hashes[BATCH];
+            for (size_t b = 0; b < n; b += BATCH)
+            {
+                const size_t m = std::min(BATCH, n - b);
+                for (size_t i = 0; i < m; i++)
+                    hashes[i] = m_heads.hash(keys[b + i]);
+                for (size_t i = 0; i < m; i++)
+                {
+                    if (far && i + PREFETCH_DISTANCE < m)
+                        m_heads.prefetch(hashes[i + PREFETCH_DISTANCE]);
+                    const uint32_t row = static_cast<uint32_t>(b + i);
+                    const auto [head, added] = m_heads.find_or_emplace(keys[b + i], hashes[i], row);
+                    if (added)
+                        m_next[row] = row;
+                    else
+                        m_next[row] = std::exchange(*head, row | CHAINED) & ~CHAINED;
+                }
+            }
+        }
+
+        // Probe n rows, row i having key keys[i], & append every match to out. Probe rows are numbered from first
+        void probe(const K *keys, size_t n, JoinMatches &out, size_t first = 0) const
+        {
+            assert(first + n <= MAX_ROWS);
+            if (m_heads.empty())
+                return;
+
+            const bool far = m_heads.capacity() > PREFETCH_MIN_CAPACITY;
+            size_t hashes[BATCH];
+            for (size_t b = 0; b < n; b += BATCH)
+            {
+                const size_t m = std::min(BATCH, n - b);
+                for (size_t i = 0; i < m; i++)
+                    hashes[i] = m_heads.hash(keys[b + i]);
+                for (size_t i = 0; i < m; i++)
+                {
+                    if (far && i + PREFETCH_DISTANCE < m)
+                        m_heads.prefetch(hashes[i + PREFETCH_DISTANCE]);
+                    const auto head = m_heads.find(keys[b + i], hashes[i]);
+                    if (!head)
+                        continue;
+                    const uint32_t row = static_cast<uint32_t>(first + b + i);
+                    uint32_t r = *head.value();
+                    out.build.push_back(r & ~CHAINED);
+                    out.probe.push_back(row);
+                    if ((r & CHAINED) == 0)
+                        continue;
+                    for (r &= ~CHAINED; m_next[r] != r; r = m_next[r])
+                    {
+                        out.build.push_back(m_next[r]);
+                        out.probe.push_back(row);
+                    }
+                }
+            }
+        }
+
+        // Probe with n_threads threads, each taking a contiguous range of rows. Matches are in the order of probe()
+        [[nodiscard]] JoinMatches parallel_probe(const K *keys, size_t n, size_t n_threads = detail::default_threads()) const
+        {
+            n_threads = std::max<size_t>(std::min(n_threads, n / BATCH), 1);
+            std::vector<JoinMatches> outs(n_threads);
+            detail::run_parallel(n_threads, [&](size_t t) {
+                const size_t b = n * t / n_threads;
+                const size_t e = n * (t + 1) / n_threads;
+                probe(keys + b, e - b, outs[t], b);
+            });
+
+            JoinMatches out = std::move(outs[0]);
+            for (size_t t = 1; t < n_threads; t++)
+                out.append(outs[t]);
+            return out;
+        }
+    };
+
+    // Hash join that splits both sides by the top radix_bits of their mixed hash first. Each partition joins on its own, with
+    // a table small enough to stay in cache, & partitions are built & probed by n_threads threads at once.
+    // With AUTO_RADIX_BITS, build() picks the bits that leave about PARTITION_ROWS build rows per partition
+    template <typename K, typename Policy = DefaultPolicy>
+    class RadixHashJoin
+    {
+    public:
+        using Join = HashJoin<K, Policy>;
+        static constexpr size_t AUTO_RADIX_BITS = SIZE_MAX;
+        static constexpr size_t PARTITION_ROWS = 1 << 15;
+        static constexpr size_t MAX_RADIX_BITS = 12; // Past a few thousand partitions, scattering rows thrashes the TLB
+
+    private:
+        // Rows grouped by partition, partition p holding [bounds[p], bounds[p + 1]). rows[i] is the input row of keys[i]
+        struct Partitioned
+        {
+            std::vector<K> keys;
+            std::vector<uint32_t> rows;
+            std::vector<size_t> bounds;
+        };
+
+        size_t m_radix_bits;
+        size_t m_build_bits;
+        std::vector<Join> m_parts;
+        std::vector<uint32_t> m_build_rows; // Input row of each partitioned build row
+        std::vector<size_t> m_build_bounds;
+
+        // Takes the table hash & mixes it again, so the partition bits are independent of the bits the tables index & tag by
+        [[nodiscard]] size_t partition_of(size_t hash) const noexcept
+        {
+            return m_build_bits == 0 ? 0 : static_cast<size_t>(detail::mix_hash(hash) >> (64 - m_build_bits));
+        }
+
+        // Two passes over n rows split into n_threads contiguous ranges. Each thread counts the rows of its range per
+        // partition, then writes its rows after those of earlier threads, so each partition keeps the input order
+        [[nodiscard]] Partitioned partition(const K *keys, size_t n, size_t n_threads) const
+        {
+            const size_t n_parts = size_t(1) << m_build_bits;
+            n_threads = std::max<size_t>(std::min(n_threads, n / Join::BATCH), 1);
+            std::vector<uint16_t> part(n);
+            std::vector<size_t> offsets(n_threads * n_parts, 0);
+            const std::hash<K> hasher;
+            detail::run_parallel(n_threads, [&](size_t t) {
+                size_t *count = offsets.data() + t * n_parts;
+                for (size_t i = n * t / n_threads; i < n * (t + 1) / n_threads; i++)
+                {
+                    part[i] = static_cast<uint16_t>(partition_of(detail::mix_hash(hasher(keys[i]))));
+                    count[part[i]] += 1;
+                }
+            });
+
+            Partitioned out;
+            out.keys.resize(n);
+            out.rows.resize(n);
+            out.bounds.resize(n_parts + 1);
+            size_t sum = 0;
+            for (size_t p = 0; p < n_parts; p++)
+            {
+                out.bounds[p] = sum;
+                for (size_t t = 0; t < n_threads; t++)
+                    sum += std::exchange(offsets[t * n_parts + p], sum);
+            }
+            out.bounds[n_parts] = sum;
+
+            detail::run_parallel(n_threads, [&](size_t t) {
+                size_t *next = offsets.data() + t * n_parts;
+                for (size_t i = n * t / n_threads; i < n * (t + 1) / n_threads; i++)
+                {
+                    const size_t j = next[part[i]]++;
+                    out.keys[j] = keys[i];
+                    out.rows[j] = static_cast<uint32_t>(i);
+                }
+            });
+            return out;
+        }
+
+        // Run task(p) for every partition, n_threads threads taking the next partition as they finish one
+        template <typename Task>
+        void for_each_partition(size_t n_threads, const Task &task) const
+        {
+            std::atomic<size_t> next{0};
+            detail::run_parallel(std::max<size_t>(std::min(n_threads, m_parts.size()), 1), [&](size_t t) {
+                for (size_t p = next++; p < m_parts.size(); p = next++)
+                    task(t, p);
+            });
+        }
+
+    public:
+        // ctors
+        explicit RadixHashJoin(size_t radix_bits = AUTO_RADIX_BITS) noexcept : m_radix_bits(radix_bits), m_build_bits(0)
+        {
+            assert(radix_bits == AUTO_RADIX_BITS || radix_bits <= 16);
+        }
+
+        // getters
+        [[nodiscard]] size_t partitions() const noexcept { return m_parts.size(); }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            size_t n = 0;
+            for (const auto &p : m_parts)
+                n += p.size();
+            return n;
+        }
+
+        // functions
+        // Build from n rows, row i having key keys[i]. Replaces the previous build
+        void build(const K *keys, size_t n, size_t n_threads = 1)
+        {
+            assert(n <= Join::MAX_ROWS);
+            m_build_bits = m_radix_bits;
+            if (m_radix_bits == AUTO_RADIX_BITS)
+            {
+                m_build_bits = 0;
+                while (m_build_bits < MAX_RADIX_BITS && (n >> m_build_bits) > PARTITION_ROWS)
+                    m_build_bits += 1;
+            }
+
+            // A single partition joins the input rows as they are
+            m_parts.assign(size_t(1) << m_build_bits, Join());
+            if (m_build_bits == 0)
+            {
+                m_parts[0].build(keys, n);
+                m_build_rows.clear();
+                m_build_bounds.clear();
+                return;
+            }
+
+            Partitioned in = partition(keys, n, n_threads);
+            for_each_partition(n_threads, [&](size_t, size_t p) {
+                m_parts[p].build(in.keys.data() + in.bounds[p], in.bounds[p + 1] - in.bounds[p]);
+            });
+            m_build_rows = std::move(in.rows);
+            m_build_bounds = std::move(in.bounds);
+        }
+
+        // Probe n rows, row i having key keys[i]. Matches come grouped by partition, in no particular order across them
+        [[nodiscard]] JoinMatches probe(const K *keys, size_t n, size_t n_threads = 1) const
+        {
+            assert(n <= Join::MAX_ROWS);
+            if (m_parts.empty())
+                return JoinMatches();
+            if (m_build_bits == 0)
+                return m_parts[0].parallel_probe(keys, n, n_threads);
+
+            const Partitioned in = partition(keys, n, n_threads);
+            std::vector<JoinMatches> outs(std::max<size_t>(std::min(n_threads, m_parts.size()), 1));
+            for_each_partition(n_threads, [&](size_t t, size_t p) {
+                JoinMatches &out = outs[t];
+                const size_t old = out.size();
+                m_parts[p].probe(in.keys.data() + in.bounds[p], in.bounds[p + 1] - in.bounds[p], out);
+
+                // Back to input rows
+                for (size_t j = old; j < out.size(); j++)
+                {
+                    out.build[j] = m_build_rows[m_build_bounds[p] + out.build[j]];
+                    out.probe[j] = in.rows[in.bounds[p] + out.probe[j]];
+                }
+            });
+
+            JoinMatches out = std::move(outs[0]);
+            for (size_t t = 1; t < outs.size(); t++)
+                out.append(outs[t]);
+            return out;
+        }
+    };
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace HashTable
+{
+    // Fixed capacity cache with CLOCK eviction
+    // The reference bit lives in the control byte, so a hit only sets a bit and eviction never allocates.
+    // Removal shifts the following entries back instead of leaving tombstones, so the table never needs a rehash
+    template <typename K, typename V>
+    class HashCache
+    {
+    private:
+        using Ctrl = detail::Ctrl;
+
+        // A used control byte holds the reference bit & the top 6 bits of the hash
+        static constexpr Ctrl CTRL_REF = 0x40;
+        static constexpr float MAX_LOAD_FACTOR = 0.8;
+
+        [[nodiscard]] static constexpr Ctrl h2(size_t h) noexcept { return static_cast<Ctrl>(h >> (sizeof(size_t) * 8 - 6)); }
+
+        struct Slot
+        {
+            K key;
+            V val;
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        std::unique_ptr<Ctrl[]> m_ctrl;
+        size_t m_mask;
+        size_t m_capacity;
+        size_t m_size;
+        size_t m_hand;
+        size_t m_hits;
+        size_t m_misses;
+        size_t m_evictions;
+        std::hash<K> m_hasher;
+
+        [[nodiscard]] constexpr size_t slots() const noexcept { return m_mask + 1; }
+
+        // Returns the index of the slot holding the key, or the empty slot ending its probe chain
+        [[nodiscard]] size_t find_slot(const size_t h, const K &key) const noexcept
+        {
+            const Ctrl tag = h2(h);
+            size_t ipos = h & m_mask;
+
+            // Linear Probe
+            while (true)
+            {
+                if (ipos + detail::GROUP_WIDTH <= slots())
+                {
+                    const detail::Group g(m_ctrl.get() + ipos);
+                    const uint32_t empty = g.match_empty();
+                    const uint32_t in_chain = empty ? (empty & -empty) - 1 : 0xFFFF;
+
+                    // Return if key is the same, with or without the reference bit
+                    for (uint32_t match = (g.match(tag) | g.match(tag | CTRL_REF)) & in_chain; match; match &= match - 1)
+                    {
+                        const size_t i = ipos + detail::lowest_bit(match);
+                        if (m_slots[i].key == key)
+                            return i;
+                    }
+
+                    // Return if slot is empty
+                    if (empty)
+                        return ipos + detail::lowest_bit(empty);
+                    ipos = (ipos + detail::GROUP_WIDTH) & m_mask;
+                }
+                else
+                {
+                    const Ctrl c = m_ctrl[ipos];
+                    if (c == detail::CTRL_EMPTY)
+                        return ipos;
+                    if ((c & ~CTRL_REF) == tag && m_slots[ipos].key == key)
+                        return ipos;
+                    ipos = (ipos + 1) & m_mask;
+                }
+            }
+        }
+
+        // Empty the slot and shift the following entries of the probe chain back into the hole
+        std::pair<K, V> erase_slot(size_t i) noexcept
+        {
+            assert(detail::is_used(m_ctrl[i]));
+            std::pair<K, V> kv(std::move(m_slots[i].key), std::move(m_slots[i].val));
+            for (size_t j = (i + 1) & m_mask; m_ctrl[j] != detail::CTRL_EMPTY; j = (j + 1) & m_mask)
+            {
+                // Entry at j can move to the hole only if the hole is between its home slot and j
+                const size_t home = hash(m_slots[j].key) & m_mask;
+                if (((j - home) & m_mask) >= ((j - i) & m_mask))
+                {
+                    m_slots[i] = std::move(m_slots[j]);
+                    m_ctrl[i] = m_ctrl[j];
+                    i = j;
+                }
+            }
+            m_ctrl[i] = detail::CTRL_EMPTY;
+            m_size -= 1;
+            return kv;
+        }
+
+        // Advance the clock hand, clearing reference bits until an unreferenced entry is found
+        [[nodiscard]] size_t clock_victim() noexcept
+        {
+            while (true)
+            {
+                const size_t i = m_hand;
+                m_hand = (m_hand + 1) & m_mask;
+                const Ctrl c = m_ctrl[i];
+                if (!detail::is_used(c))
+                    continue;
+                if (c & CTRL_REF)
+                    m_ctrl[i] = static_cast<Ctrl>(c & ~CTRL_REF);
+                else
+                    return i;
+            }
+        }
+
+    public:
+        // ctors
+        explicit HashCache(size_t capacity) noexcept
+            : m_mask(PowerOfTwoPolicy::fit(std::max(static_cast<size_t>(static_cast<float>(capacity) / MAX_LOAD_FACTOR) + 1, detail::GROUP_WIDTH)) - 1),
+              m_capacity(capacity), m_size(0), m_hand(0), m_hits(0), m_misses(0), m_evictions(0)
+        {
+            assert(capacity > 0);
+            m_slots = std::make_unique<Slot[]>(slots());
+            m_ctrl = std::make_unique<Ctrl[]>(slots());
+            std::fill(m_ctrl.get(), m_ctrl.get() + slots(), detail::CTRL_EMPTY);
+        }
+
+        // getters
+        [[nodiscard]] constexpr size_t capacity() const noexcept { return m_capacity; }
+        [[nodiscard]] constexpr size_t size() const noexcept { return m_size; }
+        [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+        [[nodiscard]] constexpr size_t hits() const noexcept { return m_hits; }
+        [[nodiscard]] constexpr size_t misses() const noexcept { return m_misses; }
+        [[nodiscard]] constexpr size_t evictions() const noexcept { return m_evictions; }
+        [[nodiscard]] constexpr float hit_rate() const noexcept
+        {
+            const size_t total = m_hits + m_misses;
+            return total == 0 ? 0 : static_cast<float>(m_hits) / static_cast<float>(total);
+        }
+
+        // functions
+        // std::hash spread by mix_hash, the slot index comes from its low bits & the tag from its top 6
+        [[nodiscard]] size_t hash(const K &key) const noexcept { return static_cast<size_t>(detail::mix_hash(m_hasher(key))); }
+
+        void reset_stats() noexcept
+        {
+            m_hits = 0;
+            m_misses = 0;
+            m_evictions = 0;
+        }
+
+        // Look up a key, a hit marks the entry as recently used
+        std::optional<V *> find(const K &key) noexcept
+        {
+            const size_t i = find_slot(hash(key), key);
+            if (!detail::is_used(m_ctrl[i]))
+            {
+                m_misses += 1;
+                return std::nullopt;
+            }
+            m_hits += 1;
+            m_ctrl[i] |= CTRL_REF;
+            return &m_slots[i].val;
+        }
+
+        // Look up a key without touching the reference bit or the counters
+        [[nodiscard]] bool contains(const K &key) const noexcept
+        {
+            return detail::is_used(m_ctrl[find_slot(hash(key), key)]);
+        }
+
+        // Insert or update a key. Returns the evicted key & value if the cache was full
+        template <typename KK, typename VV>
+        std::optional<std::pair<K, V>> emplace(KK &&key, VV &&val) noexcept
+        {
+            const size_t h = hash(key);
+            size_t i = find_slot(h, key);
+
+            // Update in place if key exists
+            if (detail::is_used(m_ctrl[i]))
+            {
+                m_slots[i].val = std::forward<VV>(val);
+                m_ctrl[i] |= CTRL_REF;
+                return std::nullopt;
+            }
+
+            // Evict if full, the eviction may shift the probe chain so find the slot again
+            std::optional<std::pair<K, V>> evicted = std::nullopt;
+            if (m_size == m_capacity)
+            {
+                evicted.emplace(erase_slot(clock_victim()));
+                m_evictions += 1;
+                i = find_slot(h, key);
+            }
+
+            // Insert
+            m_slots[i].key = std::forward<KK>(key);
+            m_slots[i].val = std::forward<VV>(val);
+            m_ctrl[i] = h2(h);
+            m_size += 1;
+            return evicted;
+        }
+
+        std::optional<std::pair<K, V>> remove(const K &key) noexcept
+        {
+            const size_t i = find_slot(hash(key), key);
+            if (!detail::is_used(m_ctrl[i]))
+                return std::nullopt;
+            return erase_slot(i);
+        }
+    };
+}
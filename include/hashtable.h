@@ -1,10 +1,24 @@
+#pragma once
+
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <optional>
 #include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "slot_alloc.h"
 
 namespace HashTable
 {
@@ -12,56 +26,329 @@ namespace HashTable
     constexpr size_t HASH_TABLE_INIT_SIZE = 2;
     constexpr float HASH_TABLE_GROW_FACTOR = 2;
     constexpr float HASH_TABLE_MAX_LOAD_FACTOR = 0.7;
-    template <typename K, typename V>
-    class HashTable
+
+    // Growth Policies
+    // A policy decides the default max load factor, the initial capacity, how the capacity grows,
+    // how a requested capacity is rounded to a valid one and how a hash maps to its home slot
+    struct DefaultPolicy
     {
-    private:
-        static_assert(HASH_TABLE_MAX_LOAD_FACTOR < 1, "Max load factor must be smaller than 1");
+        static constexpr float MAX_LOAD_FACTOR = HASH_TABLE_MAX_LOAD_FACTOR;
+        static constexpr size_t INIT_SIZE = HASH_TABLE_INIT_SIZE;
+        [[nodiscard]] static constexpr size_t grow(size_t cap) noexcept { return static_cast<size_t>(static_cast<float>(cap) * HASH_TABLE_GROW_FACTOR); }
+        [[nodiscard]] static constexpr size_t fit(size_t cap) noexcept { return cap; }
+        [[nodiscard]] static constexpr size_t index(size_t hash, size_t cap) noexcept { return hash % cap; }
+    };
 
-        class Slot
+    // Capacity is always a power of two so the home slot is a mask instead of a division
+    struct PowerOfTwoPolicy
+    {
+        static constexpr float MAX_LOAD_FACTOR = 0.7;
+        static constexpr size_t INIT_SIZE = 2;
+        [[nodiscard]] static constexpr size_t grow(size_t cap) noexcept { return fit(cap * 2); }
+        [[nodiscard]] static constexpr size_t fit(size_t cap) noexcept
+        {
+            size_t p = 1;
+            while (p < cap)
+                p <<= 1;
+            return p;
+        }
+        [[nodiscard]] static constexpr size_t index(size_t hash, size_t cap) noexcept { return hash & (cap - 1); }
+    };
+
+    // Capacity is always a prime, which spreads poor hashes (e.g. identity hash of aligned ints) evenly
+    struct PrimePolicy
+    {
+        static constexpr float MAX_LOAD_FACTOR = 0.7;
+        static constexpr size_t INIT_SIZE = 2;
+        [[nodiscard]] static constexpr size_t grow(size_t cap) noexcept { return fit(cap * 2); }
+        [[nodiscard]] static constexpr size_t fit(size_t cap) noexcept
+        {
+            // Smallest prime greater or equal to 2^n
+            constexpr uint64_t primes[] = {
+                2ull, 5ull, 11ull, 17ull, 37ull, 67ull, 131ull, 257ull, 521ull, 1031ull, 2053ull, 4099ull, 8209ull, 16411ull,
+                32771ull, 65537ull, 131101ull, 262147ull, 524309ull, 1048583ull, 2097169ull, 4194319ull, 8388617ull,
+                16777259ull, 33554467ull, 67108879ull, 134217757ull, 268435459ull, 536870923ull, 1073741827ull,
+                2147483659ull, 4294967311ull, 8589934609ull, 17179869209ull, 34359738421ull, 68719476767ull,
+                137438953481ull, 274877906951ull, 549755813911ull, 1099511627791ull, 2199023255579ull, 4398046511119ull,
+                8796093022237ull, 17592186044423ull, 35184372088891ull, 70368744177679ull, 140737488355333ull,
+                281474976710677ull, 562949953421381ull, 1125899906842679ull, 2251799813685269ull, 4503599627370517ull,
+                9007199254740997ull, 18014398509482143ull, 36028797018963971ull, 72057594037928017ull,
+                144115188075855881ull, 288230376151711813ull, 576460752303423619ull, 1152921504606847009ull,
+                2305843009213693967ull, 4611686018427388039ull, 9223372036854775837ull};
+            for (const uint64_t p : primes)
+                if (p >= cap)
+                    return static_cast<size_t>(p);
+            return cap;
+        }
+        [[nodiscard]] static constexpr size_t index(size_t hash, size_t cap) noexcept { return hash % cap; }
+    };
+
+    // Grows by 1.5x instead of 2x, trading more frequent rehashes for less over-allocation
+    struct FrugalPolicy
+    {
+        static constexpr float MAX_LOAD_FACTOR = 0.75;
+        static constexpr size_t INIT_SIZE = 2;
+        [[nodiscard]] static constexpr size_t grow(size_t cap) noexcept { return std::max(cap + cap / 2, cap + 1); }
+        [[nodiscard]] static constexpr size_t fit(size_t cap) noexcept { return cap; }
+        [[nodiscard]] static constexpr size_t index(size_t hash, size_t cap) noexcept { return hash % cap; }
+    };
+
+    // Packs the table to 7/8 full. Long probe chains stay cheap as the control bytes are scanned a group at a time
+    struct HighLoadPolicy
+    {
+        static constexpr float MAX_LOAD_FACTOR = 0.875;
+        static constexpr size_t INIT_SIZE = 16;
+        [[nodiscard]] static constexpr size_t grow(size_t cap) noexcept { return PowerOfTwoPolicy::grow(cap); }
+        [[nodiscard]] static constexpr size_t fit(size_t cap) noexcept { return PowerOfTwoPolicy::fit(cap); }
+        [[nodiscard]] static constexpr size_t index(size_t hash, size_t cap) noexcept { return PowerOfTwoPolicy::index(hash, cap); }
+    };
+
+    // Owned Heap Memory
+    // Heap bytes a key or value owns outside its slot, counted by memory_usage(true). Specialize it for other owning types
+    template <typename T>
+    struct HeapBytes
+    {
+        [[nodiscard]] size_t operator()(const T &) const noexcept { return 0; }
+    };
+
+    // Nothing while the characters fit in the small string buffer inside the object
+    template <typename C, typename Tr, typename A>
+    struct HeapBytes<std::basic_string<C, Tr, A>>
+    {
+        [[nodiscard]] size_t operator()(const std::basic_string<C, Tr, A> &s) const noexcept
         {
+            const char *obj = reinterpret_cast<const char *>(&s);
+            const char *data = reinterpret_cast<const char *>(s.data());
+            if (data >= obj && data < obj + sizeof(s))
+                return 0;
+            return (s.capacity() + 1) * sizeof(C);
+        }
+    };
+
+    template <typename T, typename A>
+    struct HeapBytes<std::vector<T, A>>
+    {
+        [[nodiscard]] size_t operator()(const std::vector<T, A> &v) const noexcept
+        {
+            size_t bytes = v.capacity() * sizeof(T);
+            for (const T &x : v)
+                bytes += HeapBytes<T>{}(x);
+            return bytes;
+        }
+    };
+
+    namespace detail
+    {
+        // Control bytes, one per slot and stored apart from the slots.
+        // Empty & Deleted have the sign bit set, a used slot holds the top 7 bits of its hash
+        using Ctrl = int8_t;
+        constexpr Ctrl CTRL_EMPTY = -128;
+        constexpr Ctrl CTRL_DELETED = -2;
+        constexpr size_t GROUP_WIDTH = 16;
+
+        [[nodiscard]] constexpr Ctrl h2(size_t hash) noexcept { return static_cast<Ctrl>(hash >> (sizeof(size_t) * 8 - 7)); }
+        [[nodiscard]] constexpr bool is_used(Ctrl c) noexcept { return c >= 0; }
+
+        // A window of GROUP_WIDTH control bytes, each query returns a bitmask with bit i set for byte i
+        class Group
+        {
+        private:
+#if defined(__SSE2__)
+            __m128i m_ctrl;
+
+            [[nodiscard]] uint32_t match_byte(Ctrl c) const noexcept
+            {
+                return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(c), m_ctrl)));
+            }
+
         public:
-            enum Type : uint8_t
+            explicit Group(const Ctrl *p) noexcept : m_ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))) {}
+            [[nodiscard]] uint32_t match_used() const noexcept { return static_cast<uint32_t>(~_mm_movemask_epi8(m_ctrl)) & 0xFFFF; }
+#else
+            const Ctrl *m_ctrl;
+
+            [[nodiscard]] uint32_t match_byte(Ctrl c) const noexcept
             {
-                Deleted,
-                Empty,
-                Used
-            };
+                uint32_t mask = 0;
+                for (size_t i = 0; i < GROUP_WIDTH; i++)
+                    mask |= static_cast<uint32_t>(m_ctrl[i] == c) << i;
+                return mask;
+            }
 
-            // ctors
-            constexpr Slot() noexcept : m_type(Type::Empty) {}
+        public:
+            explicit Group(const Ctrl *p) noexcept : m_ctrl(p) {}
+            [[nodiscard]] uint32_t match_used() const noexcept
+            {
+                uint32_t mask = 0;
+                for (size_t i = 0; i < GROUP_WIDTH; i++)
+                    mask |= static_cast<uint32_t>(is_used(m_ctrl[i])) << i;
+                return mask;
+            }
+#endif
+            [[nodiscard]] uint32_t match(Ctrl h) const noexcept { return match_byte(h); }
+            [[nodiscard]] uint32_t match_empty() const noexcept { return match_byte(CTRL_EMPTY); }
+            [[nodiscard]] uint32_t match_deleted() const noexcept { return match_byte(CTRL_DELETED); }
+        };
 
-            // member functions
-            [[nodiscard]] constexpr Type type() const noexcept { return m_type; }
-            [[nodiscard]] constexpr bool used() const noexcept { return m_type == Type::Used; }
-            [[nodiscard]] constexpr bool empty() const noexcept { return m_type == Type::Empty; }
-            [[nodiscard]] constexpr bool deleted() const noexcept { return m_type == Type::Deleted; }
-            [[nodiscard]] constexpr const K &ckey() const noexcept
+        [[nodiscard]] inline uint32_t lowest_bit(uint32_t mask) noexcept { return static_cast<uint32_t>(__builtin_ctz(mask)); }
+
+        // Prefetch a line for reading into all cache levels. GCC's mod-ref analysis takes a function that only prefetches for
+        // one without side effects & deletes calls to it, the empty volatile asm keeps them
+        inline void prefetch_read(const void *p) noexcept
+        {
+            __builtin_prefetch(p, 0, 3);
+            asm volatile("" : : "r"(p));
+        }
+
+        // Spread a hash from std::hash, which is the identity for integers, so its low bits can index & its top bits can tag
+        [[nodiscard]] constexpr uint64_t mix_hash(uint64_t h) noexcept
+        {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 33;
+            return h;
+        }
+
+        // Run task(i) for i in [0, n), on n - 1 new threads and the calling thread
+        template <typename Task>
+        void run_parallel(size_t n, const Task &task) noexcept
+        {
+            std::vector<std::thread> threads;
+            threads.reserve(n - 1);
+            for (size_t i = 1; i < n; i++)
+                threads.emplace_back(task, i);
+            task(0);
+            for (auto &t : threads)
+                t.join();
+        }
+
+        [[nodiscard]] inline size_t default_threads() noexcept { return std::max(std::thread::hardware_concurrency(), 1u); }
+
+        // Radix Sort
+        // Keys that map to a uint64_t in the same order are sorted a byte at a time, least significant first
+        template <typename T, typename = void>
+        struct RadixKey
+        {
+            static constexpr bool ENABLED = false;
+        };
+
+        // Flipping the sign bit orders negative integers before positive ones
+        template <typename T>
+        struct RadixKey<T, std::enable_if_t<std::is_integral_v<T>>>
+        {
+            static constexpr bool ENABLED = true;
+            [[nodiscard]] static constexpr uint64_t get(T k) noexcept
             {
-                assert(used());
-                return m_key;
+                if constexpr (std::is_signed_v<T>)
+                    return static_cast<uint64_t>(static_cast<int64_t>(k)) ^ (uint64_t(1) << 63);
+                else
+                    return static_cast<uint64_t>(k);
             }
-            [[nodiscard]] constexpr const V &cval() const noexcept
+        };
+
+        // Negative floats have every bit flipped & positive ones the sign bit, NaNs go to the ends
+        template <typename T>
+        struct RadixKey<T, std::enable_if_t<std::is_same_v<T, float> || std::is_same_v<T, double>>>
+        {
+            static constexpr bool ENABLED = true;
+            [[nodiscard]] static uint64_t get(T k) noexcept
             {
-                assert(used());
-                return m_val;
+                const double d = k;
+                uint64_t bits;
+                std::memcpy(&bits, &d, sizeof(bits));
+                return bits >> 63 ? ~bits : bits | (uint64_t(1) << 63);
             }
-            [[nodiscard]] constexpr K &key() noexcept
+        };
+
+        constexpr size_t RADIX_DIGITS = 8; // Bytes of a radix key
+        using RadixCounts = std::array<std::array<size_t, 256>, RADIX_DIGITS>;
+
+        inline void radix_count(RadixCounts &counts, uint64_t key) noexcept
+        {
+            for (size_t d = 0; d < RADIX_DIGITS; d++)
+                counts[d][(key >> (d * 8)) & 0xFF] += 1;
+        }
+
+        // Digits that differ between the n counted keys. A digit every key shares keeps the order & its pass is skipped
+        [[nodiscard]] inline std::vector<size_t> radix_passes(const RadixCounts &counts, size_t n)
+        {
+            std::vector<size_t> digits;
+            for (size_t d = 0; d < RADIX_DIGITS; d++)
+                if (std::find(counts[d].begin(), counts[d].end(), n) == counts[d].end())
+                    digits.push_back(d);
+            return digits;
+        }
+
+        // Stable scatter of n elements from src to dst by digit d of key_of(element), move(dst_element, src_element) moves one
+        template <typename Src, typename Dst, typename KeyOf, typename Move>
+        void radix_scatter(Src *src, Dst *dst, size_t n, size_t d, const std::array<size_t, 256> &count, const KeyOf &key_of, const Move &move)
+        {
+            size_t offsets[256];
+            size_t sum = 0;
+            for (size_t b = 0; b < 256; b++)
             {
-                assert(used());
-                return m_key;
+                offsets[b] = sum;
+                sum += count[b];
             }
-            [[nodiscard]] constexpr V &val() noexcept
+            for (size_t i = 0; i < n; i++)
+                move(dst[offsets[(key_of(src[i]) >> (d * 8)) & 0xFF]++], src[i]);
+        }
+
+        // Sort the n elements of a with b as scratch of n elements, a & b may hold different types. Passes go back & forth
+        // between them, so the result is in a after an even number of digits & in b after an odd one
+        template <typename A, typename B, typename KeyOf, typename Move>
+        void radix_sort(A *a, B *b, size_t n, const RadixCounts &counts, const std::vector<size_t> &digits, const KeyOf &key_of, const Move &move)
+        {
+            for (size_t p = 0; p < digits.size(); p++)
             {
-                assert(used());
-                return m_val;
+                if (p % 2 == 0)
+                    radix_scatter(a, b, n, digits[p], counts[digits[p]], key_of, move);
+                else
+                    radix_scatter(b, a, n, digits[p], counts[digits[p]], key_of, move);
             }
+        }
+    }
+
+    // Order of a sorted export
+    enum class SortBy
+    {
+        KEY,  // Ascending keys by operator<
+        HASH, // Ascending hash() of the keys
+    };
+
+    template <typename K, typename V, typename Policy, typename Alloc>
+    class SortedIndex;
+
+    template <typename K, typename V, typename Policy = DefaultPolicy, typename Alloc = HeapAlloc>
+    class HashTable
+    {
+    private:
+        static_assert(Policy::MAX_LOAD_FACTOR < 1, "Max load factor must be smaller than 1");
+
+        using Ctrl = detail::Ctrl;
+
+        template <typename, typename, typename, typename>
+        friend class SortedIndex;
+
+        class Slot
+        {
+        public:
+            // ctors
+            constexpr Slot() noexcept = default;
+
+            // member functions
+            [[nodiscard]] constexpr const K &ckey() const noexcept { return m_key; }
+            [[nodiscard]] constexpr const V &cval() const noexcept { return m_val; }
+            [[nodiscard]] constexpr K &key() noexcept { return m_key; }
+            [[nodiscard]] constexpr V &val() noexcept { return m_val; }
+            [[nodiscard]] constexpr const K &key() const noexcept { return m_key; }
+            [[nodiscard]] constexpr const V &val() const noexcept { return m_val; }
 
             template <typename KK, typename VV>
             constexpr void emplace(KK &&k, VV &&v) noexcept
             {
-                assert(!used());
-                m_type = Type::Used;
                 m_key = std::forward<KK>(k);
                 m_val = std::forward<VV>(v);
             }
@@ -69,7 +356,6 @@ namespace HashTable
             template <typename VV>
             constexpr V replace(VV &&new_val) noexcept
             {
-                assert(used());
                 V old_val = std::move(m_val);
                 m_val = std::forward<VV>(new_val);
                 return old_val;
@@ -77,105 +363,135 @@ namespace HashTable
 
             constexpr std::pair<K, V> extract() noexcept
             {
-                assert(used());
-                m_type = Type::Deleted;
                 return std::pair(std::move(m_key), std::move(m_val));
             }
 
         private:
-            Type m_type;
             K m_key;
             V m_val;
         };
 
-        class KVIter
+        // Iterator over used slots. Erasing never moves slots, so iterators stay valid while erasing
+        template <bool Const>
+        class Iter
         {
         private:
-            class Inner
-            {
-            private:
-                Slot *m_cur;
-                Slot *m_end;
+            friend class HashTable;
+            template <bool>
+            friend class Iter;
+            using SlotPtr = std::conditional_t<Const, const Slot *, Slot *>;
+            using KRef = std::conditional_t<Const, const K &, K &>;
+            using VRef = std::conditional_t<Const, const V &, V &>;
+
+            const Ctrl *m_ctrl;
+            SlotPtr m_slots;
+            size_t m_cur;
+            size_t m_end;
 
-                constexpr void next() noexcept
+            // Skip to the next used slot, whole groups without a used slot are skipped with one bitmask test
+            constexpr void next() noexcept
+            {
+                m_cur += 1;
+                while (m_cur < m_end)
                 {
-                    do
+                    if (m_cur + detail::GROUP_WIDTH <= m_end)
+                    {
+                        const uint32_t used = detail::Group(m_ctrl + m_cur).match_used();
+                        if (used)
+                        {
+                            m_cur += detail::lowest_bit(used);
+                            return;
+                        }
+                        m_cur += detail::GROUP_WIDTH;
+                    }
+                    else
                     {
+                        if (detail::is_used(m_ctrl[m_cur]))
+                            return;
                         m_cur += 1;
-                    } while (m_cur < m_end && !m_cur->used());
+                    }
                 }
+            }
 
-            public:
-                constexpr Inner(Slot *c, Slot *e) noexcept : m_cur(c - 1), m_end(e) // -1 from ptr because next() increments it by 1
-                {
-                    next();
-                }
-                constexpr std::pair<K &, V &> operator*() const noexcept
-                {
-                    assert(m_cur->used());
-                    return {m_cur->key(), m_cur->val()};
-                }
-                constexpr bool operator==(const Inner &rhs) const noexcept { return m_cur == rhs.m_cur; }
-                constexpr bool operator!=(const Inner &rhs) const noexcept { return !(m_cur == rhs.m_cur); }
-                constexpr Inner &operator++() noexcept
-                {
-                    next();
-                    return *this;
-                }
-                constexpr Inner operator++(int) noexcept
-                {
-                    auto retval = Inner(m_cur, m_end);
-                    next();
-                    return retval;
-                }
-            };
+        public:
+            constexpr Iter(const Ctrl *ctrl, SlotPtr slots, size_t c, size_t e) noexcept : m_ctrl(ctrl), m_slots(slots), m_cur(c - 1), m_end(e) // -1 from index because next() increments it by 1
+            {
+                next();
+            }
+            template <bool C = Const, typename = std::enable_if_t<C>>
+            constexpr Iter(const Iter<false> &other) noexcept : m_ctrl(other.m_ctrl), m_slots(other.m_slots), m_cur(other.m_cur), m_end(other.m_end) {}
+            constexpr std::pair<KRef, VRef> operator*() const noexcept
+            {
+                assert(detail::is_used(m_ctrl[m_cur]));
+                return {m_slots[m_cur].key(), m_slots[m_cur].val()};
+            }
+            constexpr bool operator==(const Iter &rhs) const noexcept { return m_cur == rhs.m_cur; }
+            constexpr bool operator!=(const Iter &rhs) const noexcept { return !(m_cur == rhs.m_cur); }
+            constexpr Iter &operator++() noexcept
+            {
+                next();
+                return *this;
+            }
+            constexpr Iter operator++(int) noexcept
+            {
+                auto retval = *this;
+                next();
+                return retval;
+            }
+        };
 
-            Slot *m_ptr;
-            size_t m_size;
+        template <bool Const>
+        class KVIter
+        {
+        private:
+            using SlotPtr = std::conditional_t<Const, const Slot *, Slot *>;
+
+            const Ctrl *m_ctrl;
+            SlotPtr m_ptr;
+            size_t m_begin;
+            size_t m_end;
 
         public:
-            constexpr KVIter(Slot *p, size_t s) noexcept : m_ptr(p), m_size(s) {}
-            [[nodiscard]] constexpr Inner begin() const noexcept { return Inner(m_ptr, m_ptr + m_size); }
-            [[nodiscard]] constexpr Inner end() const noexcept { return Inner(m_ptr + m_size, m_ptr + m_size); }
+            constexpr KVIter(const Ctrl *c, SlotPtr p, size_t b, size_t e) noexcept : m_ctrl(c), m_ptr(p), m_begin(b), m_end(e) {}
+            [[nodiscard]] constexpr Iter<Const> begin() const noexcept { return Iter<Const>(m_ctrl, m_ptr, m_begin, m_end); }
+            [[nodiscard]] constexpr Iter<Const> end() const noexcept { return Iter<Const>(m_ctrl, m_ptr, m_end, m_end); }
         };
 
         // InnerTable
         class InnerTable
         {
         private:
-            std::unique_ptr<Slot[]> m_table;
+            detail::Buffer<Slot, Alloc> m_table;
+            detail::Buffer<Ctrl, Alloc> m_ctrl;
             size_t m_size;
 
         public:
             // ctors
-            constexpr InnerTable() noexcept : m_table(nullptr), m_size(0) {}
-            constexpr InnerTable(size_t s) noexcept : m_table(std::make_unique<Slot[]>(s)), m_size(s)
+            constexpr InnerTable() noexcept : m_size(0) {}
+            InnerTable(size_t s) noexcept : m_table(s), m_ctrl(s), m_size(s)
             {
-                std::fill(m_table.get(), m_table.get() + m_size, Slot());
+                std::fill(m_ctrl.get(), m_ctrl.get() + m_size, detail::CTRL_EMPTY);
             }
 
             // copy operations
-            constexpr InnerTable(const InnerTable &other) noexcept : m_size(other.m_size)
-            {
-                m_table = std::make_unique<Slot[]>(m_size);
-                std::copy(other.m_table.get(), other.m_table.get() + m_size, m_table.get());
-            }
-            constexpr InnerTable &operator=(const InnerTable &other) noexcept
+            InnerTable(const InnerTable &other) noexcept : m_table(other.m_table), m_ctrl(other.m_ctrl), m_size(other.m_size) {}
+            InnerTable &operator=(const InnerTable &other) noexcept
             {
+                m_table = other.m_table;
+                m_ctrl = other.m_ctrl;
                 m_size = other.m_size;
-                m_table = std::make_unique<Slot[]>(m_size);
-                std::copy(other.m_table.get(), other.m_table.get() + m_size, m_table.get());
                 return *this;
             }
 
             // move operations
-            InnerTable(InnerTable &&other) noexcept : m_table(std::move(other.m_table)), m_size(other.m_size)
+            InnerTable(InnerTable &&other) noexcept : m_table(std::move(other.m_table)), m_ctrl(std::move(other.m_ctrl)), m_size(other.m_size)
             {
                 other.m_size = 0;
             }
             InnerTable &operator=(InnerTable &&other) noexcept
             {
                 m_table = std::move(other.m_table);
+                m_ctrl = std::move(other.m_ctrl);
                 m_size = other.m_size;
                 other.m_size = 0;
                 return *this;
@@ -198,69 +514,156 @@ namespace HashTable
                 return m_table[i];
             }
 
-            [[nodiscard]] constexpr KVIter key_values() noexcept
+            [[nodiscard]] constexpr Ctrl ctrl(size_t i) const noexcept
+            {
+                assert(i < m_size);
+                return m_ctrl[i];
+            }
+
+            constexpr void set_ctrl(size_t i, Ctrl c) noexcept
             {
-                return KVIter(m_table.get(), m_size);
+                assert(i < m_size);
+                m_ctrl[i] = c;
             }
 
+            [[nodiscard]] constexpr KVIter<false> key_values(size_t b, size_t e) noexcept
+            {
+                assert(b <= e && e <= m_size);
+                return KVIter<false>(m_ctrl.get(), m_table.get(), b, e);
+            }
+
+            [[nodiscard]] constexpr KVIter<true> key_values(size_t b, size_t e) const noexcept
+            {
+                assert(b <= e && e <= m_size);
+                return KVIter<true>(m_ctrl.get(), m_table.get(), b, e);
+            }
+
+            [[nodiscard]] constexpr KVIter<false> key_values() noexcept { return key_values(0, m_size); }
+            [[nodiscard]] constexpr KVIter<true> key_values() const noexcept { return key_values(0, m_size); }
+
             [[nodiscard]] constexpr Slot *data() noexcept
             {
                 return m_table.get();
             }
+
+            [[nodiscard]] constexpr const Slot *data() const noexcept
+            {
+                return m_table.get();
+            }
+
+            [[nodiscard]] constexpr const Ctrl *ctrl_data() const noexcept
+            {
+                return m_ctrl.get();
+            }
         };
 
         // Member variables
         InnerTable m_table;
         size_t m_size;
         size_t m_occupancy;
+        float m_max_load_factor;
+        uint64_t m_version; // Bumped whenever a key is added or removed or the slots move
         std::hash<K> m_hasher;
 
         [[nodiscard]] static constexpr float load_factor(size_t size, size_t cap) noexcept { return static_cast<float>(size) / static_cast<float>(cap); }
 
-        // Returns a position of a slot that either matches the key or a usable slot
-        [[nodiscard]] inline Slot &find_slot(const size_t hash, const K &key) noexcept
+        // Smallest valid capacity that holds n elements under the max load factor
+        [[nodiscard]] constexpr size_t min_capacity(size_t n) const noexcept
         {
-            size_t ipos = hash % capacity();
+            size_t cap = static_cast<size_t>(static_cast<float>(n) / m_max_load_factor) + 1; // Strictly under the max load factor
+
+            // Past 2^24 the float load factor rounds, grow until the check emplace makes passes for n elements
+            while (load_factor(n, cap) >= m_max_load_factor)
+                cap += cap / 1024 + 1;
+            return Policy::fit(std::max(cap, Policy::INIT_SIZE)); // Greater than the minimum size
+        }
+
+        // Returns the index of a slot that either matches the key or a usable slot
+        [[nodiscard]] inline size_t find_slot(const size_t hash, const K &key) const noexcept
+        {
+            const size_t cap = capacity();
+            const Ctrl *ctrl = m_table.ctrl_data();
+            const Ctrl h2 = detail::h2(hash);
+            size_t ipos = Policy::index(hash, cap);
 
 #ifndef NDEBUG
-            const size_t org_ipos = ipos;
+            size_t probed = 0;
 #endif
 
             // Optional Deleted Slot
-            std::optional<Slot *> first_del_slot = std::nullopt;
+            std::optional<size_t> first_del_slot = std::nullopt;
 
             // Linear Probe
             while (true)
             {
-                // Define slot
-                Slot &s = m_table[ipos];
+                if (ipos + detail::GROUP_WIDTH <= cap)
+                {
+                    // Probe a whole group, only the slots before the first empty one are part of the chain
+                    const detail::Group g(ctrl + ipos);
+                    const uint32_t empty = g.match_empty();
+                    const uint32_t in_chain = empty ? (empty & -empty) - 1 : 0xFFFF;
 
-                switch (s.type())
+                    // Return if key is the same
+                    for (uint32_t match = g.match(h2) & in_chain; match; match &= match - 1)
+                    {
+                        const size_t i = ipos + detail::lowest_bit(match);
+                        if (m_table[i].ckey() == key)
+                            return i;
+                    }
+
+                    // Set first deleted slot if it is null
+                    const uint32_t deleted = g.match_deleted() & in_chain;
+                    if (!first_del_slot && deleted)
+                        first_del_slot.emplace(ipos + detail::lowest_bit(deleted));
+
+                    // Return if slot is empty, reuse deleted slot if found
+                    if (empty)
+                        return first_del_slot ? first_del_slot.value() : ipos + detail::lowest_bit(empty);
+
+                    ipos += detail::GROUP_WIDTH;
+#ifndef NDEBUG
+                    probed += detail::GROUP_WIDTH;
+#endif
+                }
+                else
                 {
-                case Slot::Type::Empty:                                  // Return if slot is empty
-                    return first_del_slot ? *first_del_slot.value() : s; // Reuse deleted slot if found
-                case Slot::Type::Deleted:                                // Set first deleted slot if it is null
-                    if (!first_del_slot)
-                        first_del_slot.emplace(&s);
-                    break;
-                case Slot::Type::Used: // Return if key is the same
-                    if (s.ckey() == key)
-                        return s;
-                    break;
-                default:
-                    __builtin_unreachable();
+                    // Probe slot by slot near the end of the table
+                    const Ctrl c = ctrl[ipos];
+                    if (c == detail::CTRL_EMPTY) // Return if slot is empty
+                        return first_del_slot ? first_del_slot.value() : ipos; // Reuse deleted slot if found
+                    else if (c == detail::CTRL_DELETED) // Set first deleted slot if it is null
+                    {
+                        if (!first_del_slot)
+                            first_del_slot.emplace(ipos);
+                    }
+                    else if (c == h2 && m_table[ipos].ckey() == key) // Return if key is the same
+                        return ipos;
+
+                    ipos += 1;
+#ifndef NDEBUG
+                    probed += 1;
+#endif
                 }
 
-                // Increment cursor
-                ipos = (ipos + 1) % capacity();
+                // Wrap cursor
+                if (ipos >= cap)
+                    ipos -= cap;
 
 #ifndef NDEBUG
                 // Safety net, this never happens due to load factor constraint
-                assert(ipos != org_ipos);
+                assert(probed < cap + detail::GROUP_WIDTH);
 #endif
             }
         }
 
+        // Bounds of the i-th of n disjoint slot ranges. Ranges are aligned to control byte groups
+        [[nodiscard]] constexpr std::pair<size_t, size_t> partition_bounds(size_t i, size_t n) const noexcept
+        {
+            const size_t chunk = ((capacity() + n - 1) / n + detail::GROUP_WIDTH - 1) / detail::GROUP_WIDTH * detail::GROUP_WIDTH;
+            const size_t b = std::min(i * chunk, capacity());
+            return {b, std::min(b + chunk, capacity())};
+        }
+
         void rehash(size_t new_cap) noexcept
         {
             // Make new table
@@ -273,41 +676,136 @@ namespace HashTable
             size_t new_size = 0;
             for (auto [key, val] : other_table.key_values())
             {
-                Slot &new_s = find_slot(m_hasher(key), key);
-                new_s.emplace(std::move(key), std::move(val));
+                const size_t h = hash(key);
+                const size_t i = find_slot(h, key);
+                m_table.set_ctrl(i, detail::h2(h));
+                m_table[i].emplace(std::move(key), std::move(val));
                 new_size += 1;
             }
             m_size = new_size;
             m_occupancy = m_size;
+            m_version += 1;
+        }
+
+        // Element accessors shared by the slot array & exported pairs, so a radix pass can move between the two
+        [[nodiscard]] static constexpr const K &key_of_element(const Slot &s) noexcept { return s.ckey(); }
+        [[nodiscard]] static constexpr const K &key_of_element(const std::pair<K, V> &kv) noexcept { return kv.first; }
+        static constexpr void put(Slot &dst, std::pair<K, V> &src) noexcept { dst.emplace(std::move(src.first), std::move(src.second)); }
+        static constexpr void put(std::pair<K, V> &dst, Slot &src) noexcept
+        {
+            dst.first = std::move(src.key());
+            dst.second = std::move(src.val());
+        }
+
+        // Radix key of key in the order by
+        [[nodiscard]] uint64_t radix_key(const K &key, SortBy by) const noexcept
+        {
+            if constexpr (detail::RadixKey<K>::ENABLED)
+                if (by == SortBy::KEY)
+                    return detail::RadixKey<K>::get(key);
+            return static_cast<uint64_t>(hash(key));
+        }
+
+        // Used slots in the order by, radix sorted as (radix key, slot) pairs. Keys without a radix key only sort by hash
+        [[nodiscard]] std::vector<size_t> sorted_slots(SortBy by) const
+        {
+            assert(by == SortBy::HASH || detail::RadixKey<K>::ENABLED);
+            std::vector<size_t> slots;
+            slots.reserve(m_size);
+            std::vector<std::pair<uint64_t, size_t>> a;
+            a.reserve(m_size);
+            detail::RadixCounts counts{};
+            for (auto it = begin(); it != end(); ++it)
+            {
+                a.emplace_back(radix_key(m_table[it.m_cur].ckey(), by), it.m_cur);
+                detail::radix_count(counts, a.back().first);
+            }
+            const auto digits = detail::radix_passes(counts, m_size);
+            std::vector<std::pair<uint64_t, size_t>> b(digits.empty() ? 0 : m_size);
+            detail::radix_sort(a.data(), b.data(), m_size, counts, digits, [](const auto &e) { return e.first; }, [](auto &dst, auto &src) { dst = src; });
+            const auto &sorted = digits.size() % 2 == 0 ? a : b;
+            for (const auto &e : sorted)
+                slots.push_back(e.second);
+            return slots;
+        }
+
+        // Every key with its slot in ascending key order. Keys without a radix key are copied out & sorted with operator<,
+        // which reads them sequentially instead of through their slots
+        [[nodiscard]] std::vector<std::pair<K, size_t>> sorted_key_slots() const
+        {
+            std::vector<std::pair<K, size_t>> ks;
+            ks.reserve(m_size);
+            if constexpr (detail::RadixKey<K>::ENABLED)
+            {
+                for (const size_t i : sorted_slots(SortBy::KEY))
+                    ks.emplace_back(m_table[i].ckey(), i);
+            }
+            else
+            {
+                for (auto it = begin(); it != end(); ++it)
+                    ks.emplace_back(m_table[it.m_cur].ckey(), it.m_cur);
+                std::sort(ks.begin(), ks.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            }
+            return ks;
+        }
+
+        // Move src into the table under a precomputed hash, combine(val, src_val) folds it into the value of an equal key.
+        // The caller has made room, so no rehash happens
+        template <typename Combine>
+        void merge_slot(size_t hash, Slot &src, Combine &combine) noexcept
+        {
+            const size_t i = find_slot(hash, src.ckey());
+            const Ctrl c = m_table.ctrl(i);
+            if (detail::is_used(c))
+            {
+                combine(m_table[i].val(), std::move(src.val()));
+                return;
+            }
+
+            m_size += 1;
+            m_version += 1;
+            if (c == detail::CTRL_EMPTY)
+                m_occupancy += 1;
+            m_table.set_ctrl(i, detail::h2(hash));
+            m_table[i].emplace(std::move(src.key()), std::move(src.val()));
         }
 
     public:
+        using iterator = Iter<false>;
+        using const_iterator = Iter<true>;
+
         // ctors
-        constexpr HashTable() noexcept : m_size(0), m_occupancy(0) {}
+        constexpr HashTable() noexcept : m_size(0), m_occupancy(0), m_max_load_factor(Policy::MAX_LOAD_FACTOR), m_version(0) {}
 
         // copy operations
-        HashTable(const HashTable &other) noexcept : m_size(other.m_size), m_occupancy(other.m_occupancy), m_table(other.m_table) {}
+        HashTable(const HashTable &other) noexcept : m_table(other.m_table), m_size(other.m_size), m_occupancy(other.m_occupancy), m_max_load_factor(other.m_max_load_factor), m_version(0) {}
         HashTable &operator=(const HashTable &other) noexcept
         {
             m_size = other.m_size;
             m_occupancy = other.m_occupancy;
+            m_max_load_factor = other.m_max_load_factor;
+            m_version += 1;
             m_table = other.m_table;
             return *this;
         }
 
         // move operations
-        HashTable(HashTable &&other) noexcept : m_table(std::move(other.m_table)), m_size(other.m_size), m_occupancy(other.m_occupancy)
+        HashTable(HashTable &&other) noexcept : m_table(std::move(other.m_table)), m_size(other.m_size), m_occupancy(other.m_occupancy), m_max_load_factor(other.m_max_load_factor), m_version(0)
         {
             other.m_size = 0;
             other.m_occupancy = 0;
+            other.m_version += 1;
         }
         HashTable &operator=(HashTable &&other) noexcept
         {
             m_table = std::move(other.m_table);
             m_size = other.m_size;
             m_occupancy = other.m_occupancy;
+            m_max_load_factor = other.m_max_load_factor;
+            m_version += 1;
             other.m_size = 0;
             other.m_occupancy = 0;
+            other.m_version += 1;
             return *this;
         }
 
@@ -315,25 +813,66 @@ namespace HashTable
         [[nodiscard]] constexpr size_t capacity() const noexcept { return m_table.size(); }
         [[nodiscard]] constexpr size_t size() const noexcept { return m_size; }
         [[nodiscard]] constexpr size_t occupancy() const noexcept { return m_occupancy; }
-        [[nodiscard]] constexpr KVIter key_values() noexcept { return m_table.key_values(); }
+        [[nodiscard]] constexpr float max_load_factor() const noexcept { return m_max_load_factor; }
+        [[nodiscard]] constexpr KVIter<false> key_values() noexcept { return m_table.key_values(); }
+        [[nodiscard]] constexpr KVIter<true> key_values() const noexcept { return m_table.key_values(); }
+        [[nodiscard]] constexpr iterator begin() noexcept { return key_values().begin(); }
+        [[nodiscard]] constexpr iterator end() noexcept { return key_values().end(); }
+        [[nodiscard]] constexpr const_iterator begin() const noexcept { return key_values().begin(); }
+        [[nodiscard]] constexpr const_iterator end() const noexcept { return key_values().end(); }
+        [[nodiscard]] constexpr const_iterator cbegin() const noexcept { return key_values().begin(); }
+        [[nodiscard]] constexpr const_iterator cend() const noexcept { return key_values().end(); }
         [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
 
+        // Changes whenever a key is added or removed or the slots move, replacing a value leaves it as is
+        [[nodiscard]] constexpr uint64_t version() const noexcept { return m_version; }
+
+        // Bytes of the slot & control arrays, plus the heap memory the keys & values own if owned is set
+        [[nodiscard]] size_t memory_usage(bool owned = false) const noexcept
+        {
+            size_t bytes = capacity() * (sizeof(Slot) + sizeof(Ctrl));
+            if (owned)
+                for (const auto &[key, val] : *this)
+                    bytes += HeapBytes<K>{}(key) + HeapBytes<V>{}(val);
+            return bytes;
+        }
+
+        // setters
+        // Set the max load factor, the table rehashes right away if it is already over the new limit
+        void max_load_factor(float lf) noexcept
+        {
+            assert(lf > 0 && lf < 1);
+            m_max_load_factor = lf;
+            if (capacity() != 0 && load_factor(m_occupancy, capacity()) >= m_max_load_factor)
+                rehash(min_capacity(m_size + 1));
+        }
+
         // functions
         template <typename KK, typename VV>
         std::optional<V> emplace(KK &&key, VV &&val) noexcept
+        {
+            const size_t h = hash(key);
+            return emplace(std::forward<KK>(key), std::forward<VV>(val), h);
+        }
+
+        // Emplace with the hash of the key computed before, see hash()
+        template <typename KK, typename VV>
+        std::optional<V> emplace(KK &&key, VV &&val, size_t hash) noexcept
         {
             // Rehash if over load factor limit
-            if (capacity() == 0 || load_factor(m_occupancy + 1, capacity()) >= HASH_TABLE_MAX_LOAD_FACTOR)
+            if (capacity() == 0 || load_factor(m_occupancy + 1, capacity()) >= m_max_load_factor)
             {
-                size_t new_cap = std::max(static_cast<size_t>(static_cast<float>(capacity()) * HASH_TABLE_GROW_FACTOR), HASH_TABLE_INIT_SIZE);
+                const size_t new_cap = std::max(Policy::grow(capacity()), min_capacity(m_size + 1));
                 rehash(new_cap);
             }
 
-            // Hash & find slot
-            Slot &s = find_slot(m_hasher(key), key);
+            // Find slot
+            const size_t i = find_slot(hash, key);
+            Slot &s = m_table[i];
+            const Ctrl c = m_table.ctrl(i);
 
             // Insert & update size
-            if (s.used())
+            if (detail::is_used(c))
             {
                 // Replace and return old value if slot is used
                 V old = s.replace(std::forward<VV>(val));
@@ -343,44 +882,433 @@ namespace HashTable
             {
                 // Only increase the occupancy if using an empty slot
                 m_size += 1;
-                if (s.empty())
+                m_version += 1;
+                if (c == detail::CTRL_EMPTY)
                     m_occupancy += 1;
 
                 // Emplace if slot is not used
+                m_table.set_ctrl(i, detail::h2(hash));
                 s.emplace(std::forward<KK>(key), std::forward<VV>(val));
                 return std::nullopt;
             }
         }
 
-        std::optional<V *> find(const K &key) noexcept
+        std::optional<V *> find(const K &key) noexcept { return find(key, hash(key)); }
+        std::optional<const V *> find(const K &key) const noexcept { return find(key, hash(key)); }
+
+        // Find with the hash of the key computed before, see hash() & prefetch()
+        std::optional<V *> find(const K &key, size_t hash) noexcept
         {
-            const size_t hash = m_hasher(key);
-            Slot &s = find_slot(hash, key);
-            if (s.empty() || s.deleted())
+            if (capacity() == 0)
+                return std::nullopt;
+
+            const size_t i = find_slot(hash, key);
+            if (!detail::is_used(m_table.ctrl(i)))
                 return std::nullopt;
             else
-                return static_cast<V *>(&s.val());
+                return static_cast<V *>(&m_table[i].val());
+        }
+
+        std::optional<const V *> find(const K &key, size_t hash) const noexcept
+        {
+            if (capacity() == 0)
+                return std::nullopt;
+
+            const size_t i = find_slot(hash, key);
+            if (!detail::is_used(m_table.ctrl(i)))
+                return std::nullopt;
+            else
+                return static_cast<const V *>(&m_table[i].cval());
+        }
+
+        // std::hash spread by mix_hash, the slot index comes from its low bits & the control byte from its top 7
+        [[nodiscard]] size_t hash(const K &key) const noexcept { return static_cast<size_t>(detail::mix_hash(m_hasher(key))); }
+
+        // Start loading the first control group & slot of the probe of a hash. Prefetching a batch of keys before finding them
+        // overlaps their cache misses
+        void prefetch(size_t hash) const noexcept
+        {
+            if (capacity() == 0)
+                return;
+            const size_t i = Policy::index(hash, capacity());
+            detail::prefetch_read(m_table.ctrl_data() + i);
+            detail::prefetch_read(m_table.data() + i);
+        }
+
+        // Value of key, emplacing val first if key is missing. Returns whether val was emplaced. A present key takes one probe
+        // & no load factor check, a missing one probes again only if the table grows
+        template <typename VV>
+        std::pair<V *, bool> find_or_emplace(const K &key, size_t hash, VV &&val) noexcept
+        {
+            size_t i = 0;
+            if (capacity() != 0)
+            {
+                i = find_slot(hash, key);
+                if (detail::is_used(m_table.ctrl(i)))
+                    return {&m_table[i].val(), false};
+            }
+            if (capacity() == 0 || load_factor(m_occupancy + 1, capacity()) >= m_max_load_factor)
+            {
+                rehash(std::max(Policy::grow(capacity()), min_capacity(m_size + 1)));
+                i = find_slot(hash, key);
+            }
+
+            Slot &s = m_table[i];
+            const Ctrl c = m_table.ctrl(i);
+
+            m_size += 1;
+            m_version += 1;
+            if (c == detail::CTRL_EMPTY)
+                m_occupancy += 1;
+            m_table.set_ctrl(i, detail::h2(hash));
+            s.emplace(key, std::forward<VV>(val));
+            return {&s.val(), true};
         }
 
-        std::optional<std::pair<K, V>> remove(const K &key) noexcept
+        std::optional<std::pair<K, V>> remove(const K &key) noexcept { return remove(key, hash(key)); }
+
+        // Remove with the hash of the key computed before, see hash()
+        std::optional<std::pair<K, V>> remove(const K &key, size_t hash) noexcept
         {
+            if (capacity() == 0)
+                return std::nullopt;
+
             // Find the slot
-            Slot &s = find_slot(m_hasher(key), key);
+            const size_t i = find_slot(hash, key);
 
             // If slot is empty, return null
-            if (!s.used())
+            if (!detail::is_used(m_table.ctrl(i)))
                 return std::nullopt;
 
             // Extract and return the key & value
             m_size -= 1;
-            return s.extract();
+            m_version += 1;
+            m_table.set_ctrl(i, detail::CTRL_DELETED);
+            return m_table[i].extract();
+        }
+
+        // Erase the element at the iterator and return the iterator to the next element
+        iterator erase(iterator it) noexcept
+        {
+            assert(detail::is_used(m_table.ctrl(it.m_cur)));
+            m_size -= 1;
+            m_version += 1;
+            m_table.set_ctrl(it.m_cur, detail::CTRL_DELETED);
+            m_table[it.m_cur].extract();
+            return ++it;
+        }
+
+        // Erase all elements where pred(key, val) is true, returns the number of erased elements
+        template <typename Pred>
+        size_t erase_if(Pred pred) noexcept
+        {
+            const size_t old_size = m_size;
+            for (auto it = begin(); it != end();)
+            {
+                const auto [key, val] = *it;
+                if (pred(static_cast<const K &>(key), val))
+                    it = erase(it);
+                else
+                    ++it;
+            }
+            return old_size - m_size;
+        }
+
+        // Split the table into n disjoint ranges of slots, each range can be scanned by a different thread
+        [[nodiscard]] std::vector<KVIter<false>> partition(size_t n) noexcept
+        {
+            assert(n > 0);
+            std::vector<KVIter<false>> ranges;
+            ranges.reserve(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                const auto [b, e] = partition_bounds(i, n);
+                ranges.push_back(m_table.key_values(b, e));
+            }
+            return ranges;
+        }
+
+        [[nodiscard]] std::vector<KVIter<true>> partition(size_t n) const noexcept
+        {
+            assert(n > 0);
+            std::vector<KVIter<true>> ranges;
+            ranges.reserve(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                const auto [b, e] = partition_bounds(i, n);
+                ranges.push_back(m_table.key_values(b, e));
+            }
+            return ranges;
+        }
+
+        // Call fn(key, val) on every element from n_threads threads. fn must be safe to call concurrently
+        template <typename Fn>
+        void parallel_for_each(const Fn &fn, size_t n_threads = detail::default_threads()) noexcept
+        {
+            const auto ranges = partition(n_threads);
+            detail::run_parallel(n_threads, [&](size_t i) {
+                for (auto [key, val] : ranges[i])
+                    fn(static_cast<const K &>(key), val);
+            });
+        }
+
+        template <typename Fn>
+        void parallel_for_each(const Fn &fn, size_t n_threads = detail::default_threads()) const noexcept
+        {
+            const auto ranges = partition(n_threads);
+            detail::run_parallel(n_threads, [&](size_t i) {
+                for (const auto [key, val] : ranges[i])
+                    fn(key, val);
+            });
+        }
+
+        // Erase all elements where pred(key, val) is true from n_threads threads, returns the number of erased elements
+        template <typename Pred>
+        size_t parallel_erase_if(const Pred &pred, size_t n_threads = detail::default_threads()) noexcept
+        {
+            const auto ranges = partition(n_threads);
+            std::vector<size_t> erased(n_threads, 0);
+            detail::run_parallel(n_threads, [&](size_t i) {
+                // Ranges are disjoint, each thread only writes the control bytes & slots of its own range
+                for (auto it = ranges[i].begin(); it != ranges[i].end(); ++it)
+                {
+                    const auto [key, val] = *it;
+                    if (pred(static_cast<const K &>(key), val))
+                    {
+                        m_table.set_ctrl(it.m_cur, detail::CTRL_DELETED);
+                        m_table[it.m_cur].extract();
+                        erased[i] += 1;
+                    }
+                }
+            });
+
+            size_t total = 0;
+            for (const size_t e : erased)
+                total += e;
+            m_size -= total;
+            m_version += 1;
+            return total;
+        }
+
+        // Move every element of other into this table & leave other empty, combine(val, other_val) folds the value of a key in both.
+        // The table grows at most once, each hash of other is computed once & the target slots of a batch are prefetched
+        template <typename Combine>
+        void merge(HashTable &&other, Combine combine) noexcept
+        {
+            if (this == &other || other.m_size == 0)
+                return;
+
+            // Take other's storage as is if it fits under this table's load factor
+            if (m_size == 0 && other.capacity() >= capacity() && load_factor(other.m_occupancy, other.capacity()) < m_max_load_factor)
+            {
+                m_table = std::move(other.m_table);
+                m_size = std::exchange(other.m_size, 0);
+                m_occupancy = std::exchange(other.m_occupancy, 0);
+                m_version += 1;
+                other.m_version += 1;
+                return;
+            }
+
+            // Grow geometrically, so merging many tables in turn rehashes O(log n) times. Growing to the exact fit on every merge
+            // also rehashes a near full table into one barely larger, where the keys pile into long clusters. Tombstones count
+            // against the load factor, as in emplace
+            if (capacity() == 0 || load_factor(m_occupancy + other.m_size, capacity()) >= m_max_load_factor)
+                rehash(std::max(min_capacity(m_size + other.m_size), Policy::grow(capacity())));
+
+            constexpr size_t BATCH = 16;
+            size_t idx[BATCH];
+            size_t hashes[BATCH];
+            size_t n = 0;
+            const auto flush = [&]
+            {
+                for (size_t j = 0; j < n; j++)
+                    merge_slot(hashes[j], other.m_table[idx[j]], combine);
+                n = 0;
+            };
+
+            for (auto it = other.begin(); it != other.end(); ++it)
+            {
+                const size_t i = it.m_cur;
+                idx[n] = i;
+                hashes[n] = hash(other.m_table[i].ckey());
+                prefetch(hashes[n]);
+                if (++n == BATCH)
+                    flush();
+            }
+            flush();
+
+            other.m_table = InnerTable();
+            other.m_size = 0;
+            other.m_occupancy = 0;
+            other.m_version += 1;
+        }
+
+        // Values of keys in both tables are taken from other, as emplace would
+        void merge(HashTable &&other) noexcept
+        {
+            merge(std::move(other), [](V &val, V &&other_val)
+                  { val = std::move(other_val); });
+        }
+
+        // Destroy every element, the table is left empty with its capacity & without tombstones
+        void clear() noexcept
+        {
+            for (auto it = begin(); it != end(); ++it)
+                (void)m_table[it.m_cur].extract();
+            for (size_t i = 0; i < capacity(); i++)
+                m_table.set_ctrl(i, detail::CTRL_EMPTY);
+            m_size = 0;
+            m_occupancy = 0;
+            m_version += 1;
+        }
+
+        // Move every element out, the table is left empty with its capacity & without tombstones
+        [[nodiscard]] std::vector<std::pair<K, V>> extract_all() noexcept
+        {
+            std::vector<std::pair<K, V>> kvs;
+            kvs.reserve(m_size);
+            for (auto it = begin(); it != end(); ++it)
+                kvs.push_back(m_table[it.m_cur].extract());
+            for (size_t i = 0; i < capacity(); i++)
+                m_table.set_ctrl(i, detail::CTRL_EMPTY);
+            m_size = 0;
+            m_occupancy = 0;
+            m_version += 1;
+            return kvs;
+        }
+
+        // Copy of every element in the order by
+        [[nodiscard]] std::vector<std::pair<K, V>> sorted(SortBy by = SortBy::KEY) const
+        {
+            std::vector<std::pair<K, V>> kvs;
+            if constexpr (detail::RadixKey<K>::ENABLED)
+            {
+                // Elements are copied out in slot order, then radix sorted with a scratch array
+                kvs.reserve(m_size);
+                detail::RadixCounts counts{};
+                for (auto it = begin(); it != end(); ++it)
+                {
+                    const Slot &s = m_table[it.m_cur];
+                    kvs.emplace_back(s.ckey(), s.cval());
+                    detail::radix_count(counts, radix_key(s.ckey(), by));
+                }
+                const auto digits = detail::radix_passes(counts, m_size);
+                if (digits.empty())
+                    return kvs;
+                std::vector<std::pair<K, V>> scratch(m_size);
+                detail::radix_sort(kvs.data(), scratch.data(), m_size, counts, digits, [&](const auto &e) { return radix_key(e.first, by); }, [](auto &dst, auto &src) { dst = std::move(src); });
+                if (digits.size() % 2 == 1)
+                    kvs.swap(scratch);
+            }
+            else if (by == SortBy::KEY)
+            {
+                kvs.reserve(m_size);
+                for (auto it = begin(); it != end(); ++it)
+                    kvs.emplace_back(m_table[it.m_cur].ckey(), m_table[it.m_cur].cval());
+                std::sort(kvs.begin(), kvs.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            }
+            else
+            {
+                kvs.reserve(m_size);
+                for (const size_t i : sorted_slots(by))
+                    kvs.emplace_back(m_table[i].ckey(), m_table[i].cval());
+            }
+            return kvs;
+        }
+
+        // Move every element out in the order by, the table is left empty with its capacity & without tombstones.
+        // Integer & float keys are radix sorted with the slot array as the scratch array, so only the result is allocated
+        [[nodiscard]] std::vector<std::pair<K, V>> extract_sorted(SortBy by = SortBy::KEY)
+        {
+            std::vector<std::pair<K, V>> kvs;
+            if constexpr (detail::RadixKey<K>::ENABLED)
+            {
+                detail::RadixCounts counts{};
+                for (auto it = begin(); it != end(); ++it)
+                    detail::radix_count(counts, radix_key(m_table[it.m_cur].ckey(), by));
+                const auto digits = detail::radix_passes(counts, m_size);
+
+                // The passes alternate between kvs & the front of the slot array & must end in kvs. After an even number
+                // the elements start in kvs, after an odd one they are first packed to the front of the slot array
+                kvs.resize(m_size);
+                Slot *slots = m_table.data();
+                size_t n = 0;
+                for (auto it = begin(); it != end(); ++it, n++)
+                {
+                    Slot &s = m_table[it.m_cur];
+                    if (digits.size() % 2 == 0)
+                        kvs[n] = std::pair(std::move(s.key()), std::move(s.val()));
+                    else if (it.m_cur != n)
+                        slots[n].emplace(std::move(s.key()), std::move(s.val()));
+                }
+
+                const auto move = [](auto &dst, auto &src) { put(dst, src); };
+                const auto key_of = [&](const auto &e) { return radix_key(key_of_element(e), by); };
+                if (digits.size() % 2 == 0)
+                    detail::radix_sort(kvs.data(), slots, m_size, counts, digits, key_of, move);
+                else
+                    detail::radix_sort(slots, kvs.data(), m_size, counts, digits, key_of, move);
+            }
+            else if (by == SortBy::KEY)
+            {
+                kvs.reserve(m_size);
+                for (auto it = begin(); it != end(); ++it)
+                    kvs.push_back(m_table[it.m_cur].extract());
+                std::sort(kvs.begin(), kvs.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            }
+            else
+            {
+                kvs.reserve(m_size);
+                for (const size_t i : sorted_slots(by))
+                    kvs.push_back(m_table[i].extract());
+            }
+
+            for (size_t i = 0; i < capacity(); i++)
+                m_table.set_ctrl(i, detail::CTRL_EMPTY);
+            m_size = 0;
+            m_occupancy = 0;
+            m_version += 1;
+            return kvs;
+        }
+
+        // Elements of this table whose key is missing from other or maps to a different value.
+        // Differing slots are collected with their hashes first, so the result is sized once & no hash is computed twice
+        [[nodiscard]] HashTable diff(const HashTable &other) const noexcept
+        {
+            std::vector<std::pair<size_t, size_t>> differing; // Slot & hash
+            for (auto it = begin(); it != end(); ++it)
+            {
+                const size_t i = it.m_cur;
+                const Slot &s = m_table[i];
+                const size_t h = hash(s.ckey());
+                if (other.capacity() != 0)
+                {
+                    const size_t j = other.find_slot(h, s.ckey());
+                    if (detail::is_used(other.m_table.ctrl(j)) && other.m_table[j].cval() == s.cval())
+                        continue;
+                }
+                differing.emplace_back(i, h);
+            }
+
+            HashTable result;
+            result.m_max_load_factor = m_max_load_factor;
+            if (differing.empty())
+                return result;
+            result.reserve(differing.size());
+            for (const auto &[i, h] : differing)
+            {
+                const size_t j = result.find_slot(h, m_table[i].ckey());
+                result.m_table.set_ctrl(j, detail::h2(h));
+                result.m_table[j].emplace(m_table[i].ckey(), m_table[i].cval());
+            }
+            result.m_size = differing.size();
+            result.m_occupancy = differing.size();
+            return result;
         }
 
         void reserve(size_t new_size) noexcept
         {
-            const size_t new_cap = std::max(
-                static_cast<size_t>(std::ceil(static_cast<float>(new_size) / HASH_TABLE_MAX_LOAD_FACTOR)), // Round up to the nearest integer
-                HASH_TABLE_INIT_SIZE);
+            const size_t new_cap = min_capacity(new_size);
 
             // Table can only grow
             if (new_cap > capacity())
@@ -392,13 +1320,11 @@ namespace HashTable
         {
             // Calculate new capacity
             const size_t old_cap = capacity();
-            const size_t new_cap = std::max(
-                static_cast<size_t>(std::ceil(static_cast<float>(m_size) / HASH_TABLE_MAX_LOAD_FACTOR)), // Round up to the nearest integer
-                HASH_TABLE_INIT_SIZE);                                                                   // Greater than the minimum size
+            const size_t new_cap = min_capacity(m_size);
 
             // rehash to new capacity
             if (new_cap != old_cap)
                 rehash(new_cap);
         }
     };
-}
\ No newline at end of file
+}
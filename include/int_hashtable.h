@@ -0,0 +1,432 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace HashTable
+{
+    // Murmur3 64-bit finalizer. std::hash is the identity for integers, which clusters dense keys under linear probing
+    struct IntHash
+    {
+        template <typename K>
+        [[nodiscard]] size_t operator()(K key) const noexcept
+        {
+            uint64_t x;
+            if constexpr (std::is_pointer_v<K>)
+                x = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key));
+            else
+                x = static_cast<uint64_t>(key);
+            return static_cast<size_t>(detail::mix_hash(x));
+        }
+    };
+
+    namespace detail
+    {
+        // Compares a window of contiguous keys against one key, returns a bitmask with bit i set for key i
+        template <size_t Size>
+        struct KeyLanes
+        {
+            static constexpr size_t WIDTH = 1;
+        };
+
+#if defined(__AVX2__)
+        template <>
+        struct KeyLanes<8>
+        {
+            static constexpr size_t WIDTH = 4;
+            [[nodiscard]] static uint32_t match(const void *p, uint64_t k) noexcept
+            {
+                const __m256i keys = _mm256_loadu_si256(static_cast<const __m256i *>(p));
+                const __m256i eq = _mm256_cmpeq_epi64(keys, _mm256_set1_epi64x(static_cast<long long>(k)));
+                return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(eq)));
+            }
+        };
+
+        template <>
+        struct KeyLanes<4>
+        {
+            static constexpr size_t WIDTH = 8;
+            [[nodiscard]] static uint32_t match(const void *p, uint64_t k) noexcept
+            {
+                const __m256i keys = _mm256_loadu_si256(static_cast<const __m256i *>(p));
+                const __m256i eq = _mm256_cmpeq_epi32(keys, _mm256_set1_epi32(static_cast<int>(k)));
+                return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+            }
+        };
+#endif
+
+        template <typename K>
+        [[nodiscard]] inline uint64_t key_bits(K key) noexcept
+        {
+            if constexpr (sizeof(K) == 8)
+            {
+                uint64_t x;
+                std::memcpy(&x, &key, sizeof(K));
+                return x;
+            }
+            else
+            {
+                uint32_t x = 0;
+                std::memcpy(&x, &key, std::min(sizeof(K), sizeof(uint32_t)));
+                return x;
+            }
+        }
+    }
+
+    // Open Address Hash Table for integer & pointer keys
+    // Two key values are reserved as empty & deleted markers, so there is no per slot type byte. They can not be stored,
+    // callers check keys that may collide with is_sentinel() before emplace.
+    // Keys & values are stored in separate arrays so a probe compares a window of keys at once (AVX2 when available)
+    template <typename K, typename V, typename Policy = PowerOfTwoPolicy>
+    class IntHashTable
+    {
+    private:
+        static_assert(std::is_integral_v<K> || std::is_pointer_v<K>, "Key must be an integer or a pointer");
+        static_assert(Policy::MAX_LOAD_FACTOR < 1, "Max load factor must be smaller than 1");
+
+        using Lanes = detail::KeyLanes<sizeof(K)>;
+
+        std::unique_ptr<K[]> m_keys;
+        std::unique_ptr<V[]> m_vals;
+        size_t m_capacity;
+        size_t m_size;
+        size_t m_occupancy;
+        float m_max_load_factor;
+        K m_empty_key;
+        K m_deleted_key;
+        IntHash m_hasher;
+
+        [[nodiscard]] static constexpr K default_empty_key() noexcept
+        {
+            if constexpr (std::is_pointer_v<K>)
+                return nullptr;
+            else
+                return std::numeric_limits<K>::max();
+        }
+        [[nodiscard]] static K default_deleted_key() noexcept
+        {
+            if constexpr (std::is_pointer_v<K>)
+                return reinterpret_cast<K>(uintptr_t(1));
+            else
+                return std::numeric_limits<K>::max() - 1;
+        }
+
+        [[nodiscard]] static constexpr float load_factor(size_t size, size_t cap) noexcept { return static_cast<float>(size) / static_cast<float>(cap); }
+
+        [[nodiscard]] constexpr bool used(size_t i) const noexcept { return !is_sentinel(m_keys[i]); }
+
+        // Smallest valid capacity that holds n elements under the max load factor
+        [[nodiscard]] constexpr size_t min_capacity(size_t n) const noexcept
+        {
+            size_t cap = static_cast<size_t>(static_cast<float>(n) / m_max_load_factor) + 1; // Strictly under the max load factor
+
+            // Past 2^24 the float load factor rounds, grow until the check emplace makes passes for n elements
+            while (load_factor(n, cap) >= m_max_load_factor)
+                cap += cap / 1024 + 1;
+            return Policy::fit(std::max(cap, Policy::INIT_SIZE)); // Greater than the minimum size
+        }
+
+        // Returns the index of a slot that either matches the key or a usable slot
+        [[nodiscard]] size_t find_slot(const size_t hash, const K key) const noexcept
+        {
+            const K *keys = m_keys.get();
+            size_t ipos = Policy::index(hash, m_capacity);
+
+            // Optional Deleted Slot
+            std::optional<size_t> first_del_slot = std::nullopt;
+
+            // Home slot first, most probes end there
+            if (keys[ipos] == key || keys[ipos] == m_empty_key)
+                return ipos;
+
+            // Linear Probe
+            while (true)
+            {
+                if constexpr (Lanes::WIDTH > 1)
+                {
+                    if (ipos + Lanes::WIDTH <= m_capacity)
+                    {
+                        // Probe a window of keys, only the keys before the first empty one are part of the chain
+                        const uint32_t empty = Lanes::match(keys + ipos, detail::key_bits(m_empty_key));
+                        const uint32_t in_chain = empty ? (empty & -empty) - 1 : (1u << Lanes::WIDTH) - 1;
+
+                        // Return if key is the same
+                        const uint32_t match = Lanes::match(keys + ipos, detail::key_bits(key)) & in_chain;
+                        if (match)
+                            return ipos + detail::lowest_bit(match);
+
+                        // Set first deleted slot if it is null
+                        const uint32_t deleted = Lanes::match(keys + ipos, detail::key_bits(m_deleted_key)) & in_chain;
+                        if (!first_del_slot && deleted)
+                            first_del_slot.emplace(ipos + detail::lowest_bit(deleted));
+
+                        // Return if slot is empty, reuse deleted slot if found
+                        if (empty)
+                            return first_del_slot ? first_del_slot.value() : ipos + detail::lowest_bit(empty);
+
+                        ipos += Lanes::WIDTH;
+                        if (ipos >= m_capacity)
+                            ipos -= m_capacity;
+                        continue;
+                    }
+                }
+
+                // Probe slot by slot
+                const K k = keys[ipos];
+                if (k == key)
+                    return ipos;
+                else if (k == m_empty_key)
+                    return first_del_slot ? first_del_slot.value() : ipos;
+                else if (k == m_deleted_key && !first_del_slot)
+                    first_del_slot.emplace(ipos);
+
+                ipos += 1;
+                if (ipos >= m_capacity)
+                    ipos -= m_capacity;
+            }
+        }
+
+        void rehash(size_t new_cap) noexcept
+        {
+            // Make new arrays
+            auto old_keys = std::move(m_keys);
+            auto old_vals = std::move(m_vals);
+            const size_t old_cap = m_capacity;
+            m_keys = std::make_unique<K[]>(new_cap);
+            m_vals = std::make_unique<V[]>(new_cap);
+            m_capacity = new_cap;
+            std::fill(m_keys.get(), m_keys.get() + new_cap, m_empty_key);
+
+            // Iterate old arrays and insert to new arrays
+            for (size_t i = 0; i < old_cap; i++)
+            {
+                const K k = old_keys[i];
+                if (is_sentinel(k))
+                    continue;
+                const size_t j = find_slot(m_hasher(k), k);
+                m_keys[j] = k;
+                m_vals[j] = std::move(old_vals[i]);
+            }
+            m_occupancy = m_size;
+        }
+
+        template <bool Const>
+        class Iter
+        {
+        private:
+            using Table = std::conditional_t<Const, const IntHashTable, IntHashTable>;
+            using VRef = std::conditional_t<Const, const V &, V &>;
+
+            Table *m_table;
+            size_t m_cur;
+
+            constexpr void next() noexcept
+            {
+                do
+                {
+                    m_cur += 1;
+                } while (m_cur < m_table->m_capacity && !m_table->used(m_cur));
+            }
+
+        public:
+            constexpr Iter(Table *t, size_t c) noexcept : m_table(t), m_cur(c - 1) // -1 from index because next() increments it by 1
+            {
+                next();
+            }
+            constexpr std::pair<K, VRef> operator*() const noexcept { return {m_table->m_keys[m_cur], m_table->m_vals[m_cur]}; }
+            constexpr bool operator==(const Iter &rhs) const noexcept { return m_cur == rhs.m_cur; }
+            constexpr bool operator!=(const Iter &rhs) const noexcept { return !(m_cur == rhs.m_cur); }
+            constexpr Iter &operator++() noexcept
+            {
+                next();
+                return *this;
+            }
+        };
+
+        template <bool Const>
+        class KVIter
+        {
+        private:
+            using Table = std::conditional_t<Const, const IntHashTable, IntHashTable>;
+            Table *m_table;
+
+        public:
+            constexpr KVIter(Table *t) noexcept : m_table(t) {}
+            [[nodiscard]] constexpr Iter<Const> begin() const noexcept { return Iter<Const>(m_table, 0); }
+            [[nodiscard]] constexpr Iter<Const> end() const noexcept { return Iter<Const>(m_table, m_table->m_capacity); }
+        };
+
+    public:
+        // ctors
+        explicit IntHashTable(K empty_key = default_empty_key(), K deleted_key = default_deleted_key()) noexcept
+            : m_keys(nullptr), m_vals(nullptr), m_capacity(0), m_size(0), m_occupancy(0), m_max_load_factor(Policy::MAX_LOAD_FACTOR),
+              m_empty_key(empty_key), m_deleted_key(deleted_key)
+        {
+            assert(empty_key != deleted_key);
+        }
+
+        // copy operations
+        IntHashTable(const IntHashTable &other) noexcept
+            : m_capacity(other.m_capacity), m_size(other.m_size), m_occupancy(other.m_occupancy), m_max_load_factor(other.m_max_load_factor),
+              m_empty_key(other.m_empty_key), m_deleted_key(other.m_deleted_key)
+        {
+            m_keys = std::make_unique<K[]>(m_capacity);
+            m_vals = std::make_unique<V[]>(m_capacity);
+            std::copy(other.m_keys.get(), other.m_keys.get() + m_capacity, m_keys.get());
+            std::copy(other.m_vals.get(), other.m_vals.get() + m_capacity, m_vals.get());
+        }
+        IntHashTable &operator=(const IntHashTable &other) noexcept
+        {
+            IntHashTable copy(other);
+            *this = std::move(copy);
+            return *this;
+        }
+
+        // move operations
+        IntHashTable(IntHashTable &&other) noexcept
+            : m_keys(std::move(other.m_keys)), m_vals(std::move(other.m_vals)), m_capacity(other.m_capacity), m_size(other.m_size),
+              m_occupancy(other.m_occupancy), m_max_load_factor(other.m_max_load_factor), m_empty_key(other.m_empty_key), m_deleted_key(other.m_deleted_key)
+        {
+            other.m_capacity = 0;
+            other.m_size = 0;
+            other.m_occupancy = 0;
+        }
+        IntHashTable &operator=(IntHashTable &&other) noexcept
+        {
+            m_keys = std::move(other.m_keys);
+            m_vals = std::move(other.m_vals);
+            m_capacity = other.m_capacity;
+            m_size = other.m_size;
+            m_occupancy = other.m_occupancy;
+            m_max_load_factor = other.m_max_load_factor;
+            m_empty_key = other.m_empty_key;
+            m_deleted_key = other.m_deleted_key;
+            other.m_capacity = 0;
+            other.m_size = 0;
+            other.m_occupancy = 0;
+            return *this;
+        }
+
+        // getters
+        [[nodiscard]] constexpr size_t capacity() const noexcept { return m_capacity; }
+        [[nodiscard]] constexpr size_t size() const noexcept { return m_size; }
+        [[nodiscard]] constexpr size_t occupancy() const noexcept { return m_occupancy; }
+        [[nodiscard]] constexpr float max_load_factor() const noexcept { return m_max_load_factor; }
+        [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+        [[nodiscard]] constexpr K empty_key() const noexcept { return m_empty_key; }
+        [[nodiscard]] constexpr K deleted_key() const noexcept { return m_deleted_key; }
+        [[nodiscard]] constexpr bool is_sentinel(K key) const noexcept { return key == m_empty_key || key == m_deleted_key; }
+        [[nodiscard]] constexpr KVIter<false> key_values() noexcept { return KVIter<false>(this); }
+        [[nodiscard]] constexpr KVIter<true> key_values() const noexcept { return KVIter<true>(this); }
+
+        // setters
+        // Set the max load factor, the table rehashes right away if it is already over the new limit
+        void max_load_factor(float lf) noexcept
+        {
+            assert(lf > 0 && lf < 1);
+            m_max_load_factor = lf;
+            if (m_capacity != 0 && load_factor(m_occupancy, m_capacity) >= m_max_load_factor)
+                rehash(min_capacity(m_size + 1));
+        }
+
+        // functions
+        // The key must not be a sentinel. Release builds skip a sentinel key rather than corrupt the table
+        template <typename VV>
+        std::optional<V> emplace(K key, VV &&val) noexcept
+        {
+            assert(!is_sentinel(key));
+            if (is_sentinel(key))
+                return std::nullopt;
+
+            // Rehash if over load factor limit
+            if (m_capacity == 0 || load_factor(m_occupancy + 1, m_capacity) >= m_max_load_factor)
+                rehash(std::max(Policy::grow(m_capacity), min_capacity(m_size + 1)));
+
+            // Hash & find slot
+            const size_t i = find_slot(m_hasher(key), key);
+
+            // Replace and return old value if slot is used
+            if (m_keys[i] == key)
+            {
+                V old = std::move(m_vals[i]);
+                m_vals[i] = std::forward<VV>(val);
+                return old;
+            }
+
+            // Only increase the occupancy if using an empty slot
+            m_size += 1;
+            if (m_keys[i] == m_empty_key)
+                m_occupancy += 1;
+            m_keys[i] = key;
+            m_vals[i] = std::forward<VV>(val);
+            return std::nullopt;
+        }
+
+        // Sentinel keys are never found
+        std::optional<V *> find(K key) noexcept
+        {
+            if (m_capacity == 0 || is_sentinel(key))
+                return std::nullopt;
+            const size_t i = find_slot(m_hasher(key), key);
+            if (m_keys[i] != key)
+                return std::nullopt;
+            return &m_vals[i];
+        }
+
+        std::optional<const V *> find(K key) const noexcept
+        {
+            if (m_capacity == 0 || is_sentinel(key))
+                return std::nullopt;
+            const size_t i = find_slot(m_hasher(key), key);
+            if (m_keys[i] != key)
+                return std::nullopt;
+            return static_cast<const V *>(&m_vals[i]);
+        }
+
+        std::optional<std::pair<K, V>> remove(K key) noexcept
+        {
+            if (m_capacity == 0 || is_sentinel(key))
+                return std::nullopt;
+
+            // If key is not found, return null
+            const size_t i = find_slot(m_hasher(key), key);
+            if (m_keys[i] != key)
+                return std::nullopt;
+
+            // Extract and return the key & value
+            m_size -= 1;
+            m_keys[i] = m_deleted_key;
+            return std::pair<K, V>(key, std::move(m_vals[i]));
+        }
+
+        void reserve(size_t new_size) noexcept
+        {
+            const size_t new_cap = min_capacity(new_size);
+
+            // Table can only grow
+            if (new_cap > m_capacity)
+                rehash(new_cap);
+        }
+
+        // Shrink the table to the size that exactly fits all keys & values. Table grows on next insertion
+        void shrink_to_fit() noexcept
+        {
+            const size_t new_cap = min_capacity(m_size);
+            if (new_cap != m_capacity)
+                rehash(new_cap);
+        }
+    };
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace HashTable
+{
+    // Multi-Version Hash Table
+    // One writer thread & any number of reader threads. Every mutation commits a new epoch. A slot holds one version of a key,
+    // with the epoch it was born at & the epoch it died at, & is never changed in place once published: an update is a new
+    // version & a remove sets the death epoch. pin() gives a reader a view of one epoch, which sees exactly the versions alive
+    // at it while the writer keeps going. Dead versions are dropped when the writer moves the live ones to a new generation of
+    // slots. An old generation is freed once no view can still be reading it
+    template <typename K, typename V>
+    class MvccHashTable
+    {
+    public:
+        static constexpr float MAX_LOAD_FACTOR = 0.7;   // Of live & dead versions
+        static constexpr size_t INIT_SIZE = 16;
+        static constexpr size_t MAX_READERS = 128;       // Views pinned at once, pin() waits for a free reader slot past it
+        static constexpr size_t RECLAIM_INTERVAL = 1024; // Commits between the writer's checks for generations to free
+
+    private:
+        using Ctrl = detail::Ctrl;
+        static constexpr uint64_t ALIVE = UINT64_MAX; // Death epoch of a live version
+        static constexpr uint64_t IDLE = UINT64_MAX;  // Epoch of a free reader slot
+
+        struct Slot
+        {
+            K key;
+            V val;
+            uint64_t born = 0;
+            std::atomic<uint64_t> died{ALIVE};
+        };
+
+        // Slots are written only while their control byte is empty, the store of the control byte publishes them
+        struct Generation
+        {
+            size_t capacity;
+            std::unique_ptr<std::atomic<Ctrl>[]> ctrl;
+            std::unique_ptr<Slot[]> slots;
+            std::atomic<uint64_t> epoch; // Last epoch committed to this generation, frozen once it is retired
+
+            Generation(size_t cap, uint64_t e) : capacity(cap), ctrl(new std::atomic<Ctrl>[cap]), slots(new Slot[cap]), epoch(e)
+            {
+                for (size_t i = 0; i < cap; i++)
+                    ctrl[i].store(detail::CTRL_EMPTY, std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] bool visible(size_t i, uint64_t e) const noexcept
+            {
+                return slots[i].born <= e && e < slots[i].died.load(std::memory_order_acquire);
+            }
+
+            // Slot of the version of key visible at epoch e. Slots are never emptied, so the chain a version was added to
+            // still leads to it
+            [[nodiscard]] Slot *find(const K &key, size_t hash, uint64_t e) const noexcept
+            {
+                const Ctrl h2 = detail::h2(hash);
+                for (size_t i = hash & (capacity - 1);; i = (i + 1) & (capacity - 1))
+                {
+                    const Ctrl c = ctrl[i].load(std::memory_order_acquire);
+                    if (c == detail::CTRL_EMPTY)
+                        return nullptr;
+                    if (c == h2 && visible(i, e) && slots[i].key == key)
+                        return &slots[i];
+                }
+            }
+
+            [[nodiscard]] size_t empty_slot(size_t hash) const noexcept
+            {
+                size_t i = hash & (capacity - 1);
+                while (ctrl[i].load(std::memory_order_relaxed) != detail::CTRL_EMPTY)
+                    i = (i + 1) & (capacity - 1);
+                return i;
+            }
+        };
+
+        // Epoch a reader announced before loading the current generation, on its own cache line
+        struct alignas(64) ReaderSlot
+        {
+            std::atomic<uint64_t> epoch{IDLE};
+        };
+
+        std::unique_ptr<Generation> m_gen;
+        std::atomic<const Generation *> m_current;
+        std::vector<std::pair<std::unique_ptr<Generation>, uint64_t>> m_retired; // With the last epoch they were current at
+        std::atomic<uint64_t> m_epoch;
+        mutable std::unique_ptr<ReaderSlot[]> m_readers;
+        size_t m_size;
+        size_t m_occupancy;
+        size_t m_commits;
+
+        [[nodiscard]] static size_t hash(const K &key) noexcept { return static_cast<size_t>(detail::mix_hash(std::hash<K>{}(key))); }
+
+        [[nodiscard]] static size_t min_capacity(size_t n) noexcept
+        {
+            size_t cap = INIT_SIZE;
+            while (static_cast<float>(n) >= MAX_LOAD_FACTOR * static_cast<float>(cap))
+                cap *= 2;
+            return cap;
+        }
+
+        // Copy the live versions into a new generation & retire the current one. The new one is at most half full, so churn
+        // that only adds dead versions rebuilds every O(size) commits
+        void rebuild()
+        {
+            const uint64_t e = m_epoch.load(std::memory_order_relaxed);
+            auto next = std::make_unique<Generation>(min_capacity(2 * (m_size + 1)), e + 1);
+            const Generation &g = *m_gen;
+            for (size_t i = 0; i < g.capacity; i++)
+            {
+                if (!detail::is_used(g.ctrl[i].load(std::memory_order_relaxed)) || g.slots[i].died.load(std::memory_order_relaxed) != ALIVE)
+                    continue;
+                const size_t h = hash(g.slots[i].key);
+                const size_t j = next->empty_slot(h);
+                next->slots[j].key = g.slots[i].key;
+                next->slots[j].val = g.slots[i].val;
+                next->slots[j].born = g.slots[i].born;
+                next->ctrl[j].store(detail::h2(h), std::memory_order_relaxed);
+            }
+            m_occupancy = m_size;
+
+            // A reader that announced e or earlier may have loaded the old generation, one announcing e + 1 loads the new one
+            m_current.store(next.get());
+            m_retired.emplace_back(std::move(m_gen), e);
+            m_gen = std::move(next);
+            m_epoch.store(e + 1);
+            reclaim();
+        }
+
+        void commit(uint64_t e)
+        {
+            m_gen->epoch.store(e, std::memory_order_release);
+            m_epoch.store(e);
+            m_commits += 1;
+            if (!m_retired.empty() && m_commits % RECLAIM_INTERVAL == 0)
+                reclaim();
+        }
+
+    public:
+        // Read-only view of the table at one epoch, pinned until it is destroyed. A view is used by one thread at a time
+        class View
+        {
+        private:
+            friend class MvccHashTable;
+
+            std::atomic<uint64_t> *m_reader;
+            const Generation *m_gen;
+            uint64_t m_epoch;
+
+            View(std::atomic<uint64_t> *reader, const Generation *gen, uint64_t epoch) noexcept : m_reader(reader), m_gen(gen), m_epoch(epoch) {}
+
+        public:
+            View(const View &) = delete;
+            View &operator=(const View &) = delete;
+            View(View &&other) noexcept : m_reader(std::exchange(other.m_reader, nullptr)), m_gen(other.m_gen), m_epoch(other.m_epoch) {}
+            View &operator=(View &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    unpin();
+                    m_reader = std::exchange(other.m_reader, nullptr);
+                    m_gen = other.m_gen;
+                    m_epoch = other.m_epoch;
+                }
+                return *this;
+            }
+            ~View() { unpin(); }
+
+            // getters
+            [[nodiscard]] uint64_t epoch() const noexcept { return m_epoch; }
+
+            // functions
+            // The pointer is valid while the view is pinned
+            [[nodiscard]] std::optional<const V *> find(const K &key) const noexcept
+            {
+                assert(m_reader != nullptr);
+                if (const Slot *s = m_gen->find(key, hash(key), m_epoch))
+                    return &s->val;
+                return std::nullopt;
+            }
+
+            // Calls fn(key, val) on every element alive at the epoch
+            template <typename Fn>
+            void for_each(Fn &&fn) const
+            {
+                assert(m_reader != nullptr);
+                for (size_t i = 0; i < m_gen->capacity; i++)
+                    if (detail::is_used(m_gen->ctrl[i].load(std::memory_order_acquire)) && m_gen->visible(i, m_epoch))
+                        fn(static_cast<const K &>(m_gen->slots[i].key), static_cast<const V &>(m_gen->slots[i].val));
+            }
+
+            // Release the epoch early, the view is unusable after
+            void unpin() noexcept
+            {
+                if (m_reader != nullptr)
+                    std::exchange(m_reader, nullptr)->store(IDLE, std::memory_order_release);
+            }
+        };
+
+        // ctors
+        MvccHashTable() : m_gen(std::make_unique<Generation>(INIT_SIZE, 0)), m_current(m_gen.get()), m_epoch(0), m_readers(new ReaderSlot[MAX_READERS]), m_size(0), m_occupancy(0), m_commits(0) {}
+        MvccHashTable(const MvccHashTable &) = delete;
+        MvccHashTable &operator=(const MvccHashTable &) = delete;
+
+        // Every view must be gone
+        ~MvccHashTable()
+        {
+#ifndef NDEBUG
+            for (size_t i = 0; i < MAX_READERS; i++)
+                assert(m_readers[i].epoch.load() == IDLE);
+#endif
+        }
+
+        // getters
+        // Writer side
+        [[nodiscard]] size_t size() const noexcept { return m_size; }
+        [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+        [[nodiscard]] size_t capacity() const noexcept { return m_gen->capacity; }
+        [[nodiscard]] size_t retired() const noexcept { return m_retired.size(); }
+
+        // Any thread
+        [[nodiscard]] uint64_t epoch() const noexcept { return m_epoch.load(std::memory_order_acquire); }
+
+        // functions
+        // Any thread. Announces the current epoch in a free reader slot, then takes the current generation & its epoch. The
+        // generation's own epoch is used, as a generation retired meanwhile lacks the commits made after it
+        [[nodiscard]] View pin() const
+        {
+            const size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id());
+            for (size_t k = 0;; k++)
+            {
+                std::atomic<uint64_t> &reader = m_readers[(start + k) % MAX_READERS].epoch;
+                uint64_t idle = IDLE;
+                if (reader.load(std::memory_order_relaxed) == IDLE && reader.compare_exchange_strong(idle, m_epoch.load()))
+                {
+                    const Generation *g = m_current.load();
+                    return View(&reader, g, g->epoch.load(std::memory_order_acquire));
+                }
+                if (k % MAX_READERS == MAX_READERS - 1)
+                    std::this_thread::yield();
+            }
+        }
+
+        // Writer thread only, from here on
+        template <typename KK, typename VV>
+        std::optional<V> emplace(KK &&key, VV &&val)
+        {
+            const size_t h = hash(key);
+            if (static_cast<float>(m_occupancy + 1) >= MAX_LOAD_FACTOR * static_cast<float>(capacity()))
+                rebuild();
+
+            // The old version stays readable, the new one goes to an empty slot
+            const uint64_t now = m_epoch.load(std::memory_order_relaxed);
+            Slot *old = m_gen->find(key, h, now);
+            std::optional<V> old_val;
+            if (old != nullptr)
+                old_val = old->val;
+
+            const size_t i = m_gen->empty_slot(h);
+            Slot &s = m_gen->slots[i];
+            s.key = std::forward<KK>(key);
+            s.val = std::forward<VV>(val);
+            s.born = now + 1;
+            s.died.store(ALIVE, std::memory_order_relaxed);
+            m_gen->ctrl[i].store(detail::h2(h), std::memory_order_release);
+            m_occupancy += 1;
+            if (old != nullptr)
+                old->died.store(now + 1, std::memory_order_release);
+            else
+                m_size += 1;
+            commit(now + 1);
+            return old_val;
+        }
+
+        std::optional<std::pair<K, V>> remove(const K &key)
+        {
+            const uint64_t now = m_epoch.load(std::memory_order_relaxed);
+            Slot *s = m_gen->find(key, hash(key), now);
+            if (s == nullptr)
+                return std::nullopt;
+            std::pair<K, V> kv(s->key, s->val);
+            s->died.store(now + 1, std::memory_order_release);
+            m_size -= 1;
+            commit(now + 1);
+            return kv;
+        }
+
+        // The pointer is valid until the next emplace or remove
+        [[nodiscard]] std::optional<const V *> find(const K &key) const noexcept
+        {
+            if (const Slot *s = m_gen->find(key, hash(key), m_epoch.load(std::memory_order_relaxed)))
+                return &s->val;
+            return std::nullopt;
+        }
+
+        // Free the retired generations no view can reach: those retired at an epoch before every announced one
+        void reclaim()
+        {
+            uint64_t oldest = IDLE;
+            for (size_t i = 0; i < MAX_READERS; i++)
+                oldest = std::min(oldest, m_readers[i].epoch.load());
+            m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), [&](const auto &r) { return r.second < oldest; }), m_retired.end());
+        }
+    };
+}
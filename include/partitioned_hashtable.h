@@ -0,0 +1,253 @@
+#pragma once
+
+#include "codec.h"
+#include "hashtable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace HashTable
+{
+    // Partitioned Hash Table
+    // One logical map split over partitions, each its own HashTable that can live in another process. A router maps the mixed
+    // hash of a key to one of n partitions such that going from n to m partitions moves only the keys whose partition changes,
+    // about |m - n| / max(m, n) of them. Moving keys leave their partition as encoded batches, so partitions in different
+    // processes migrate by exchanging the bytes of migrate_out & migrate_in
+
+    // Jump consistent hash (Lamping & Veach). O(log n) per key & no state, partitions are added & removed at the end
+    struct JumpRouter
+    {
+        [[nodiscard]] static constexpr uint32_t route(uint64_t hash, uint32_t n) noexcept
+        {
+            int64_t b = -1;
+            int64_t j = 0;
+            while (j < n)
+            {
+                b = j;
+                hash = hash * 2862933555777941757ull + 1;
+                j = static_cast<int64_t>(static_cast<double>(b + 1) * (static_cast<double>(int64_t(1) << 31) / static_cast<double>((hash >> 33) + 1)));
+            }
+            return static_cast<uint32_t>(b);
+        }
+    };
+
+    // Rendezvous (highest random weight) hashing. O(n) per key, each partition scores the key & the highest score wins
+    struct RendezvousRouter
+    {
+        [[nodiscard]] static constexpr uint32_t route(uint64_t hash, uint32_t n) noexcept
+        {
+            uint32_t best = 0;
+            uint64_t best_score = 0;
+            for (uint32_t p = 0; p < n; p++)
+            {
+                const uint64_t score = detail::mix_hash(hash ^ (0x9e3779b97f4a7c15ull * (p + 1)));
+                if (p == 0 || score > best_score)
+                {
+                    best = p;
+                    best_score = score;
+                }
+            }
+            return best;
+        }
+    };
+
+    // Migration Batches
+    // [header][key][val]... with the crc of the elements in the header. A batch holds the elements of one target partition
+    struct MigrationHeader
+    {
+        static constexpr uint32_t MAGIC = 0x424D4854; // "THMB"
+
+        uint32_t magic;
+        uint32_t target;
+        uint32_t count;
+        uint32_t crc;
+    };
+
+    constexpr size_t MIGRATION_BATCH_BYTES = size_t(64) << 10; // A batch is sent once it grows past this
+
+    struct MigrationStats
+    {
+        size_t keys_moved = 0;
+        size_t bytes = 0;
+        size_t batches = 0;
+
+        MigrationStats &operator+=(const MigrationStats &other) noexcept
+        {
+            keys_moved += other.keys_moved;
+            bytes += other.bytes;
+            batches += other.batches;
+            return *this;
+        }
+    };
+
+    // Partition of key out of n
+    template <typename Router, typename K>
+    [[nodiscard]] uint32_t key_partition(const K &key, uint32_t n) noexcept
+    {
+        return Router::route(detail::mix_hash(std::hash<K>{}(key)), n);
+    }
+
+    // Remove every element of shard, which is partition self, whose partition changes once there are n partitions.
+    // send(target, batch) is called with the encoded batches of each target partition & may be called before the scan ends
+    template <typename Router = JumpRouter, typename K, typename V, typename Policy, typename Alloc, typename Send>
+    MigrationStats migrate_out(HashTable<K, V, Policy, Alloc> &shard, uint32_t self, uint32_t n, const Send &send, size_t batch_bytes = MIGRATION_BATCH_BYTES)
+    {
+        using KCodec = detail::Codec<K>;
+        using VCodec = detail::Codec<V>;
+
+        MigrationStats stats;
+        std::vector<std::string> batches(n);
+        std::vector<uint32_t> counts(n, 0);
+        const auto flush = [&](uint32_t target)
+        {
+            std::string &b = batches[target];
+            const MigrationHeader h{MigrationHeader::MAGIC, target, counts[target], detail::crc32c(b.data() + sizeof(MigrationHeader), b.size() - sizeof(MigrationHeader))};
+            std::memcpy(b.data(), &h, sizeof(h));
+            stats.bytes += b.size();
+            stats.batches += 1;
+            send(target, std::as_const(b));
+            b.clear();
+            counts[target] = 0;
+        };
+
+        for (auto it = shard.begin(); it != shard.end();)
+        {
+            const auto [key, val] = *it;
+            const uint32_t target = key_partition<Router>(static_cast<const K &>(key), n);
+            if (target == self)
+            {
+                ++it;
+                continue;
+            }
+
+            std::string &b = batches[target];
+            if (b.empty())
+                b.resize(sizeof(MigrationHeader));
+            KCodec::encode(b, key);
+            VCodec::encode(b, val);
+            counts[target] += 1;
+            stats.keys_moved += 1;
+            it = shard.erase(it);
+            if (b.size() >= batch_bytes)
+                flush(target);
+        }
+
+        for (uint32_t t = 0; t < n; t++)
+            if (counts[t] != 0)
+                flush(t);
+        return stats;
+    }
+
+    // Insert the elements of a batch into shard, which is partition self. A batch for another partition, with a bad crc or
+    // whose count does not match its elements is rejected as a whole & returns false, leaving shard unchanged
+    template <typename K, typename V, typename Policy, typename Alloc>
+    bool migrate_in(HashTable<K, V, Policy, Alloc> &shard, uint32_t self, std::string_view batch)
+    {
+        MigrationHeader h;
+        if (batch.size() < sizeof(h))
+            return false;
+        std::memcpy(&h, batch.data(), sizeof(h));
+        const char *data = batch.data() + sizeof(h);
+        const size_t size = batch.size() - sizeof(h);
+        if (h.magic != MigrationHeader::MAGIC || h.target != self || h.crc != detail::crc32c(data, size))
+            return false;
+
+        // The header is not under the crc, so the elements are decoded before any is inserted & must end with the batch
+        detail::ByteReader in(data, size);
+        std::vector<std::pair<K, V>> staged;
+        K key;
+        V val;
+        for (uint32_t i = 0; i < h.count; i++)
+        {
+            if (!detail::Codec<K>::decode(in, key) || !detail::Codec<V>::decode(in, val))
+                return false;
+            staged.emplace_back(std::move(key), std::move(val));
+        }
+        if (in.pos() != size)
+            return false;
+
+        shard.reserve(shard.size() + staged.size());
+        for (auto &[k, v] : staged)
+            shard.emplace(std::move(k), std::move(v));
+        return true;
+    }
+
+    // All partitions in one process, e.g. to test a layout or as a local harness of many instances. Partitions only exchange
+    // elements through encoded batches, as they would across processes
+    template <typename K, typename V, typename Router = JumpRouter, typename Policy = DefaultPolicy>
+    class PartitionedHashTable
+    {
+    public:
+        using Table = HashTable<K, V, Policy>;
+
+    private:
+        std::vector<Table> m_parts;
+
+    public:
+        // ctors
+        explicit PartitionedHashTable(uint32_t n_parts = 1) : m_parts(n_parts) { assert(n_parts > 0); }
+
+        // getters
+        [[nodiscard]] uint32_t partitions() const noexcept { return static_cast<uint32_t>(m_parts.size()); }
+        [[nodiscard]] const Table &partition(uint32_t p) const noexcept { return m_parts[p]; }
+        [[nodiscard]] Table &partition(uint32_t p) noexcept { return m_parts[p]; }
+        [[nodiscard]] uint32_t partition_of(const K &key) const noexcept { return key_partition<Router>(key, partitions()); }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            size_t n = 0;
+            for (const auto &p : m_parts)
+                n += p.size();
+            return n;
+        }
+
+        // functions
+        template <typename KK, typename VV>
+        std::optional<V> emplace(KK &&key, VV &&val) noexcept
+        {
+            const uint32_t p = partition_of(key);
+            return m_parts[p].emplace(std::forward<KK>(key), std::forward<VV>(val));
+        }
+
+        std::optional<V *> find(const K &key) noexcept { return m_parts[partition_of(key)].find(key); }
+        std::optional<const V *> find(const K &key) const noexcept { return m_parts[partition_of(key)].find(key); }
+        std::optional<std::pair<K, V>> remove(const K &key) noexcept { return m_parts[partition_of(key)].remove(key); }
+
+        // Go to n partitions, moving only the elements whose partition changes. deliver(target, batch) carries each batch
+        // from its partition to the target, which must end in migrate_in(partition(target), target, batch)
+        template <typename Deliver>
+        MigrationStats resize(uint32_t n, const Deliver &deliver, size_t batch_bytes = MIGRATION_BATCH_BYTES)
+        {
+            assert(n > 0);
+            const uint32_t old_n = partitions();
+            if (n > old_n)
+                m_parts.resize(n);
+
+            MigrationStats stats;
+            for (uint32_t p = 0; p < old_n; p++)
+                stats += migrate_out<Router>(m_parts[p], p, n, deliver, batch_bytes);
+
+            if (n < old_n)
+                m_parts.resize(n);
+            return stats;
+        }
+
+        // Batches are applied as they are sent
+        MigrationStats resize(uint32_t n)
+        {
+            return resize(n, [&](uint32_t target, const std::string &batch) {
+                [[maybe_unused]] const bool ok = migrate_in(m_parts[target], target, batch);
+                assert(ok);
+            });
+        }
+    };
+}
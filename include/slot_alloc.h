@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace HashTable
+{
+    // Slot Array Allocation Backends
+    // A backend hands out raw memory for the slot & control arrays. PARALLEL_TOUCH spreads their construction over all hardware
+    // threads, so under the kernel's first-touch policy each thread's share of the pages lands on that thread's NUMA node
+
+    // Global operator new, the default
+    struct HeapAlloc
+    {
+        static constexpr bool PARALLEL_TOUCH = false;
+
+        [[nodiscard]] static void *allocate(size_t bytes, size_t align) noexcept
+        {
+            return ::operator new(bytes, std::align_val_t(align));
+        }
+
+        static void deallocate(void *p, size_t, size_t align) noexcept
+        {
+            ::operator delete(p, std::align_val_t(align));
+        }
+    };
+
+    enum class HugePages
+    {
+        None,        // 4 KB pages
+        Transparent, // madvise(MADV_HUGEPAGE), the kernel backs the range with 2 MB pages when it can
+        Explicit     // MAP_HUGETLB from the reserved pool, falls back to Transparent if the pool is empty
+    };
+
+    enum class Numa
+    {
+        None,       // Pages land on the node of the thread that first touches them
+        Interleave, // Pages round-robin over all nodes
+        Bind,       // Pages on node NODE only
+        FirstTouch  // Construction is split over all hardware threads
+    };
+
+    // Anonymous mmap with optional huge pages & NUMA placement, heap memory on systems without mmap.
+    // Arrays under one huge page use normal pages, rounding them up would waste most of the 2 MB
+    template <HugePages HP = HugePages::Transparent, Numa N = Numa::None, int NODE = 0>
+    struct MmapAlloc
+    {
+        static constexpr bool PARALLEL_TOUCH = N == Numa::FirstTouch;
+        static constexpr size_t PAGE_SIZE = 4096;
+        static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+        [[nodiscard]] static constexpr bool use_huge_pages(size_t bytes) noexcept { return HP != HugePages::None && bytes >= HUGE_PAGE_SIZE; }
+
+        [[nodiscard]] static constexpr size_t mapped_size(size_t bytes) noexcept
+        {
+            const size_t page = use_huge_pages(bytes) ? HUGE_PAGE_SIZE : PAGE_SIZE;
+            return (bytes + page - 1) / page * page;
+        }
+
+        [[nodiscard]] static void *allocate(size_t bytes, [[maybe_unused]] size_t align) noexcept
+        {
+#if defined(__linux__)
+            assert(align <= PAGE_SIZE);
+            const size_t len = mapped_size(bytes);
+            void *p = MAP_FAILED;
+            if constexpr (HP == HugePages::Explicit)
+                if (use_huge_pages(bytes))
+                    p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p == MAP_FAILED)
+            {
+                p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (p == MAP_FAILED)
+                    std::terminate(); // Same as a failed new in the noexcept callers
+                if (use_huge_pages(bytes))
+                    madvise(p, len, MADV_HUGEPAGE);
+            }
+
+            // mbind errors, e.g. on a kernel without NUMA, leave the default policy in place
+            if constexpr (N == Numa::Interleave || N == Numa::Bind)
+            {
+                constexpr unsigned long MPOL_BIND_MODE = 2;
+                constexpr unsigned long MPOL_INTERLEAVE_MODE = 3;
+                const unsigned long mask = N == Numa::Bind ? 1ul << NODE : ~0ul;
+                syscall(SYS_mbind, p, len, N == Numa::Bind ? MPOL_BIND_MODE : MPOL_INTERLEAVE_MODE, &mask, sizeof(mask) * 8, 0);
+            }
+            return p;
+#else
+            return HeapAlloc::allocate(bytes, align);
+#endif
+        }
+
+        static void deallocate(void *p, size_t bytes, size_t align) noexcept
+        {
+#if defined(__linux__)
+            (void)align;
+            munmap(p, mapped_size(bytes));
+#else
+            HeapAlloc::deallocate(p, bytes, align);
+#endif
+        }
+    };
+
+    namespace detail
+    {
+        // Fixed size array of value-initialized T in memory from a backend, the slot & control arrays of a table
+        template <typename T, typename Alloc>
+        class Buffer
+        {
+        private:
+            T *m_data;
+            size_t m_size;
+
+            // Run fn(b, e) over [0, m_size), split over all hardware threads if the backend asks for it
+            template <typename Fn>
+            void for_ranges(const Fn &fn) noexcept
+            {
+                constexpr size_t MIN_PARALLEL_BYTES = 1 << 24;
+                const size_t n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+                if (!Alloc::PARALLEL_TOUCH || n_threads == 1 || m_size * sizeof(T) < MIN_PARALLEL_BYTES)
+                {
+                    fn(0, m_size);
+                    return;
+                }
+
+                std::vector<std::thread> threads;
+                threads.reserve(n_threads);
+                for (size_t i = 0; i < n_threads; i++)
+                    threads.emplace_back(fn, m_size * i / n_threads, m_size * (i + 1) / n_threads);
+                for (auto &t : threads)
+                    t.join();
+            }
+
+            [[nodiscard]] static T *allocate(size_t n) noexcept
+            {
+                return n == 0 ? nullptr : static_cast<T *>(Alloc::allocate(n * sizeof(T), alignof(T)));
+            }
+
+            void release() noexcept
+            {
+                if (m_data == nullptr)
+                    return;
+                std::destroy(m_data, m_data + m_size);
+                Alloc::deallocate(m_data, m_size * sizeof(T), alignof(T));
+                m_data = nullptr;
+                m_size = 0;
+            }
+
+        public:
+            // ctors
+            constexpr Buffer() noexcept : m_data(nullptr), m_size(0) {}
+            explicit Buffer(size_t n) noexcept : m_data(allocate(n)), m_size(n)
+            {
+                for_ranges([this](size_t b, size_t e)
+                           {
+                               for (size_t i = b; i < e; i++)
+                                   new (m_data + i) T(); });
+            }
+            ~Buffer() noexcept { release(); }
+
+            // copy operations
+            Buffer(const Buffer &other) noexcept : m_data(allocate(other.m_size)), m_size(other.m_size)
+            {
+                for_ranges([&](size_t b, size_t e)
+                           { std::uninitialized_copy(other.m_data + b, other.m_data + e, m_data + b); });
+            }
+            Buffer &operator=(const Buffer &other) noexcept
+            {
+                if (this != &other)
+                {
+                    Buffer copy(other);
+                    *this = std::move(copy);
+                }
+                return *this;
+            }
+
+            // move operations
+            Buffer(Buffer &&other) noexcept : m_data(other.m_data), m_size(other.m_size)
+            {
+                other.m_data = nullptr;
+                other.m_size = 0;
+            }
+            Buffer &operator=(Buffer &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    release();
+                    m_data = other.m_data;
+                    m_size = other.m_size;
+                    other.m_data = nullptr;
+                    other.m_size = 0;
+                }
+                return *this;
+            }
+
+            [[nodiscard]] constexpr T *get() const noexcept { return m_data; }
+            [[nodiscard]] constexpr T &operator[](size_t i) const noexcept { return m_data[i]; }
+        };
+    }
+}
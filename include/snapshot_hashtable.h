@@ -0,0 +1,322 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// ThreadSanitizer does not model std::atomic_thread_fence, the ordering unshared() relies on is annotated for it instead
+#if defined(__SANITIZE_THREAD__)
+#define HASHTABLE_TSAN
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define HASHTABLE_TSAN
+#endif
+#endif
+
+#if defined(HASHTABLE_TSAN)
+#include <sanitizer/tsan_interface.h>
+#endif
+
+namespace HashTable
+{
+    // Hash table whose slots are split into fixed size segments shared copy-on-write with snapshots.
+    // snapshot() copies one pointer per segment, the table clones a segment the first time it writes to it while a snapshot shares it.
+    // A snapshot is immutable, it may be read & destroyed on other threads while the table keeps changing on its own thread
+    template <typename K, typename V, size_t SEGMENT_SLOTS = 1024>
+    class SnapshotHashTable
+    {
+        static_assert(SEGMENT_SLOTS > 0 && (SEGMENT_SLOTS & (SEGMENT_SLOTS - 1)) == 0, "Segment size must be a power of 2");
+
+    public:
+        static constexpr float MAX_LOAD_FACTOR = 0.7;
+
+    private:
+        using Ctrl = detail::Ctrl;
+
+        struct Segment
+        {
+            Ctrl ctrl[SEGMENT_SLOTS];
+            K keys[SEGMENT_SLOTS];
+            V vals[SEGMENT_SLOTS];
+
+            Segment() noexcept { std::fill(ctrl, ctrl + SEGMENT_SLOTS, detail::CTRL_EMPTY); }
+        };
+        using Segments = std::vector<std::shared_ptr<const Segment>>;
+
+        // Probing shared by the table & its snapshots
+        struct Probe
+        {
+            // std::hash is the identity for integers, spread it before masking
+            [[nodiscard]] static size_t hash(const K &key) noexcept { return static_cast<size_t>(detail::mix_hash(std::hash<K>{}(key))); }
+
+            // Returns the slot holding the key or, if absent, the first reusable slot of its chain
+            [[nodiscard]] static std::pair<size_t, bool> find_slot(const Segments &segs, size_t mask, size_t hash, const K &key) noexcept
+            {
+                const Ctrl h2 = detail::h2(hash);
+                std::optional<size_t> first_del;
+                for (size_t i = hash & mask;; i = (i + 1) & mask)
+                {
+                    const Segment &seg = *segs[i / SEGMENT_SLOTS];
+                    const size_t off = i % SEGMENT_SLOTS;
+                    const Ctrl c = seg.ctrl[off];
+                    if (c == detail::CTRL_EMPTY)
+                        return {first_del.value_or(i), false};
+                    if (c == detail::CTRL_DELETED)
+                    {
+                        if (!first_del)
+                            first_del = i;
+                    }
+                    else if (c == h2 && seg.keys[off] == key)
+                        return {i, true};
+                }
+            }
+
+            template <typename Fn>
+            static void for_each(const Segments &segs, Fn &&fn)
+            {
+                for (const auto &seg : segs)
+                    for (size_t off = 0; off < SEGMENT_SLOTS; off++)
+                        if (detail::is_used(seg->ctrl[off]))
+                            fn(seg->keys[off], seg->vals[off]);
+            }
+        };
+
+        Segments m_segments;
+        size_t m_size;
+        size_t m_occupancy;
+        size_t m_segments_copied;
+
+        [[nodiscard]] size_t mask() const noexcept { return capacity() - 1; }
+
+        // Whether the table holds the only reference to a segment. use_count() is a relaxed load, the fence orders the reads
+        // of a snapshot that dropped the segment on another thread before the writes that follow. Under ThreadSanitizer the
+        // fence is replaced by an acquire of the segment, paired with the release of every snapshot dropping it
+        [[nodiscard]] static bool unshared(const std::shared_ptr<const Segment> &seg) noexcept
+        {
+            if (seg.use_count() > 1)
+                return false;
+#if defined(HASHTABLE_TSAN)
+            __tsan_acquire(const_cast<Segment *>(seg.get()));
+#else
+            std::atomic_thread_fence(std::memory_order_acquire);
+#endif
+            return true;
+        }
+
+        // Segment i for writing, cloned first if a snapshot still shares it
+        [[nodiscard]] Segment &writable(size_t i) noexcept
+        {
+            if (!unshared(m_segments[i]))
+            {
+                m_segments[i] = std::make_shared<const Segment>(*m_segments[i]);
+                m_segments_copied += 1;
+            }
+            return const_cast<Segment &>(*m_segments[i]);
+        }
+
+        // Rehash into new segments. Elements are moved out of unshared segments, shared ones are left untouched for the
+        // snapshots holding them
+        void rehash(size_t new_cap) noexcept
+        {
+            Segments old = std::move(m_segments);
+            const size_t n_segs = std::max<size_t>(new_cap / SEGMENT_SLOTS, 1);
+            m_segments.clear();
+            for (size_t i = 0; i < n_segs; i++)
+                m_segments.push_back(std::make_shared<const Segment>());
+
+            const size_t new_mask = capacity() - 1;
+            for (const auto &old_seg : old)
+            {
+                const bool owned = unshared(old_seg);
+                Segment &src = const_cast<Segment &>(*old_seg);
+                for (size_t off = 0; off < SEGMENT_SLOTS; off++)
+                {
+                    if (!detail::is_used(src.ctrl[off]))
+                        continue;
+                    const size_t h = Probe::hash(src.keys[off]);
+                    const size_t i = Probe::find_slot(m_segments, new_mask, h, src.keys[off]).first;
+                    Segment &seg = const_cast<Segment &>(*m_segments[i / SEGMENT_SLOTS]);
+                    seg.ctrl[i % SEGMENT_SLOTS] = detail::h2(h);
+                    if (owned)
+                    {
+                        seg.keys[i % SEGMENT_SLOTS] = std::move(src.keys[off]);
+                        seg.vals[i % SEGMENT_SLOTS] = std::move(src.vals[off]);
+                    }
+                    else
+                    {
+                        seg.keys[i % SEGMENT_SLOTS] = src.keys[off];
+                        seg.vals[i % SEGMENT_SLOTS] = src.vals[off];
+                    }
+                }
+            }
+            m_occupancy = m_size;
+        }
+
+        [[nodiscard]] static size_t min_capacity(size_t n) noexcept
+        {
+            size_t cap = SEGMENT_SLOTS;
+            while (static_cast<float>(n) >= MAX_LOAD_FACTOR * static_cast<float>(cap))
+                cap *= 2;
+            return cap;
+        }
+
+    public:
+        // Read-only view of the table at the time snapshot() was called
+        class Snapshot
+        {
+        private:
+            friend class SnapshotHashTable;
+
+            Segments m_segments;
+            size_t m_size;
+
+            Snapshot(const Segments &segs, size_t size) noexcept : m_segments(segs), m_size(size) {}
+
+#if defined(HASHTABLE_TSAN)
+            // Publish the reads of the segments to the acquire in unshared() before they are dropped
+            void tsan_release() const noexcept
+            {
+                for (const auto &seg : m_segments)
+                    __tsan_release(const_cast<Segment *>(seg.get()));
+            }
+#endif
+
+        public:
+            Snapshot() noexcept : m_size(0) {}
+#if defined(HASHTABLE_TSAN)
+            Snapshot(const Snapshot &) = default;
+            Snapshot(Snapshot &&) noexcept = default;
+            Snapshot &operator=(const Snapshot &other)
+            {
+                tsan_release();
+                m_segments = other.m_segments;
+                m_size = other.m_size;
+                return *this;
+            }
+            Snapshot &operator=(Snapshot &&other) noexcept
+            {
+                tsan_release();
+                m_segments = std::move(other.m_segments);
+                m_size = other.m_size;
+                return *this;
+            }
+            ~Snapshot() { tsan_release(); }
+#endif
+
+            [[nodiscard]] size_t size() const noexcept { return m_size; }
+            [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+            [[nodiscard]] std::optional<const V *> find(const K &key) const noexcept
+            {
+                if (m_segments.empty())
+                    return std::nullopt;
+                const auto [i, found] = Probe::find_slot(m_segments, m_segments.size() * SEGMENT_SLOTS - 1, Probe::hash(key), key);
+                if (!found)
+                    return std::nullopt;
+                return &m_segments[i / SEGMENT_SLOTS]->vals[i % SEGMENT_SLOTS];
+            }
+
+            // Calls fn(key, val) on every element
+            template <typename Fn>
+            void for_each(Fn &&fn) const { Probe::for_each(m_segments, std::forward<Fn>(fn)); }
+        };
+
+        // ctors
+        SnapshotHashTable() noexcept : m_size(0), m_occupancy(0), m_segments_copied(0) {}
+
+        // getters
+        [[nodiscard]] size_t capacity() const noexcept { return m_segments.size() * SEGMENT_SLOTS; }
+        [[nodiscard]] size_t size() const noexcept { return m_size; }
+        [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+        [[nodiscard]] size_t segments() const noexcept { return m_segments.size(); }
+
+        // Segments cloned because a snapshot shared them, the write amplification of snapshots
+        [[nodiscard]] size_t segments_copied() const noexcept { return m_segments_copied; }
+        [[nodiscard]] static constexpr size_t segment_bytes() noexcept { return sizeof(Segment); }
+
+        // functions
+        // O(segments), no slot is copied
+        [[nodiscard]] Snapshot snapshot() const noexcept { return Snapshot(m_segments, m_size); }
+
+        template <typename KK, typename VV>
+        std::optional<V> emplace(KK &&key, VV &&val) noexcept
+        {
+            if (capacity() == 0 || static_cast<float>(m_occupancy + 1) >= MAX_LOAD_FACTOR * static_cast<float>(capacity()))
+                rehash(min_capacity(m_size + 1)); // Same capacity when tombstones filled it
+
+            const size_t h = Probe::hash(key);
+            const auto [i, found] = Probe::find_slot(m_segments, mask(), h, key);
+            Segment &seg = writable(i / SEGMENT_SLOTS);
+            const size_t off = i % SEGMENT_SLOTS;
+            if (found)
+            {
+                V old = std::move(seg.vals[off]);
+                seg.vals[off] = std::forward<VV>(val);
+                return old;
+            }
+
+            m_size += 1;
+            if (seg.ctrl[off] == detail::CTRL_EMPTY)
+                m_occupancy += 1;
+            seg.ctrl[off] = detail::h2(h);
+            seg.keys[off] = std::forward<KK>(key);
+            seg.vals[off] = std::forward<VV>(val);
+            return std::nullopt;
+        }
+
+        // A mutable pointer may write to the slot, so a shared segment is cloned first
+        std::optional<V *> find(const K &key) noexcept
+        {
+            if (capacity() == 0)
+                return std::nullopt;
+            const auto [i, found] = Probe::find_slot(m_segments, mask(), Probe::hash(key), key);
+            if (!found)
+                return std::nullopt;
+            return &writable(i / SEGMENT_SLOTS).vals[i % SEGMENT_SLOTS];
+        }
+
+        std::optional<const V *> find(const K &key) const noexcept
+        {
+            if (capacity() == 0)
+                return std::nullopt;
+            const auto [i, found] = Probe::find_slot(m_segments, mask(), Probe::hash(key), key);
+            if (!found)
+                return std::nullopt;
+            return &m_segments[i / SEGMENT_SLOTS]->vals[i % SEGMENT_SLOTS];
+        }
+
+        std::optional<std::pair<K, V>> remove(const K &key) noexcept
+        {
+            if (capacity() == 0)
+                return std::nullopt;
+            const auto [i, found] = Probe::find_slot(m_segments, mask(), Probe::hash(key), key);
+            if (!found)
+                return std::nullopt;
+
+            Segment &seg = writable(i / SEGMENT_SLOTS);
+            const size_t off = i % SEGMENT_SLOTS;
+            seg.ctrl[off] = detail::CTRL_DELETED;
+            m_size -= 1;
+            return std::pair<K, V>(std::move(seg.keys[off]), std::move(seg.vals[off]));
+        }
+
+        // Calls fn(key, val) on every element
+        template <typename Fn>
+        void for_each(Fn &&fn) const { Probe::for_each(m_segments, std::forward<Fn>(fn)); }
+
+        void reserve(size_t n) noexcept
+        {
+            const size_t cap = min_capacity(n);
+            if (cap > capacity())
+                rehash(cap);
+        }
+    };
+}
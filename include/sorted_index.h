@@ -0,0 +1,86 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace HashTable
+{
+    // Sorted Index
+    // Secondary index over a HashTable in ascending key order, for range scans. The keys are kept in one sorted array next to
+    // the slot of each, so a scan is a binary search & a sequential walk. The index remembers the table version it was built
+    // at & is rebuilt by the first scan after a key is added or removed, a series of scans between mutations sorts once.
+    // The table must outlive the index
+    template <typename K, typename V, typename Policy = DefaultPolicy, typename Alloc = HeapAlloc>
+    class SortedIndex
+    {
+    public:
+        using Table = HashTable<K, V, Policy, Alloc>;
+
+    private:
+        const Table *m_table;
+        std::vector<K> m_keys;        // Ascending
+        std::vector<size_t> m_slots;  // Slot of m_keys[i]
+        uint64_t m_version;
+        bool m_built;
+
+        void refresh()
+        {
+            if (stale())
+                rebuild();
+        }
+
+        [[nodiscard]] const V &value(size_t i) const noexcept { return m_table->m_table[m_slots[i]].cval(); }
+
+    public:
+        // ctors
+        explicit SortedIndex(const HashTable<K, V, Policy, Alloc> &table) noexcept : m_table(&table), m_version(0), m_built(false) {}
+
+        // getters
+        // Whether the next scan rebuilds the index
+        [[nodiscard]] bool stale() const noexcept { return !m_built || m_version != m_table->version(); }
+
+        // functions
+        // Sort the keys of the table now, e.g. before scans that should not pay for it
+        void rebuild()
+        {
+            auto ks = m_table->sorted_key_slots();
+            m_keys.clear();
+            m_slots.clear();
+            m_keys.reserve(ks.size());
+            m_slots.reserve(ks.size());
+            for (auto &[key, i] : ks)
+            {
+                m_keys.push_back(std::move(key));
+                m_slots.push_back(i);
+            }
+            m_version = m_table->version();
+            m_built = true;
+        }
+
+        // Call fn(key, val) on every element with lo <= key < hi in ascending key order, returns the number of elements
+        template <typename Fn>
+        size_t range(const K &lo, const K &hi, Fn fn)
+        {
+            refresh();
+            const size_t b = std::lower_bound(m_keys.begin(), m_keys.end(), lo) - m_keys.begin();
+            size_t i = b;
+            for (; i < m_keys.size() && m_keys[i] < hi; i++)
+                fn(m_keys[i], value(i));
+            return i - b;
+        }
+
+        // Call fn(key, val) on every element in ascending key order
+        template <typename Fn>
+        void for_each(Fn fn)
+        {
+            refresh();
+            for (size_t i = 0; i < m_keys.size(); i++)
+                fn(m_keys[i], value(i));
+        }
+    };
+}
@@ -0,0 +1,443 @@
+#pragma once
+
+#include "hashtable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace HashTable
+{
+    // Open Address Hash Table for string keys
+    // Keys up to INLINE_SIZE bytes are stored in the slot, longer keys in one contiguous arena.
+    // Every slot carries the key length & first 4 bytes, so most mismatches are rejected without touching the key bytes
+    template <typename V, typename Policy = DefaultPolicy>
+    class StringHashTable
+    {
+    public:
+        static constexpr size_t INLINE_SIZE = 23;
+
+    private:
+        static_assert(Policy::MAX_LOAD_FACTOR < 1, "Max load factor must be smaller than 1");
+
+        using Ctrl = detail::Ctrl;
+
+        class Slot
+        {
+        private:
+            uint32_t m_len;
+            uint32_t m_prefix;
+            union
+            {
+                char m_inline[INLINE_SIZE + 1];
+                uint64_t m_offset;
+            };
+            V m_val;
+
+        public:
+            [[nodiscard]] static uint32_t prefix(std::string_view key) noexcept
+            {
+                uint32_t p = 0;
+                if (key.size() >= sizeof(p))
+                    std::memcpy(&p, key.data(), sizeof(p));
+                else
+                    std::memcpy(&p, key.data(), key.size());
+                return p;
+            }
+
+            // ctors
+            constexpr Slot() noexcept : m_len(0), m_prefix(0), m_offset(0), m_val() {}
+
+            // member functions
+            [[nodiscard]] constexpr bool is_inline() const noexcept { return m_len <= INLINE_SIZE; }
+            [[nodiscard]] constexpr uint32_t len() const noexcept { return m_len; }
+            [[nodiscard]] constexpr uint64_t offset() const noexcept
+            {
+                assert(!is_inline());
+                return m_offset;
+            }
+            [[nodiscard]] std::string_view key(const char *arena) const noexcept
+            {
+                return is_inline() ? std::string_view(m_inline, m_len) : std::string_view(arena + m_offset, m_len);
+            }
+            [[nodiscard]] constexpr V &val() noexcept { return m_val; }
+            [[nodiscard]] constexpr const V &val() const noexcept { return m_val; }
+
+            // Length & prefix are compared first, the key bytes only if both match
+            [[nodiscard]] bool matches(std::string_view key, uint32_t key_prefix, const char *arena) const noexcept
+            {
+                if (m_len != key.size() || m_prefix != key_prefix)
+                    return false;
+                if (m_len <= sizeof(m_prefix))
+                    return true;
+                return std::memcmp(is_inline() ? m_inline : arena + m_offset, key.data(), m_len) == 0;
+            }
+
+            // Set the key, long keys are appended to the arena
+            void set_key(std::string_view key, std::vector<char> &arena) noexcept
+            {
+                m_len = static_cast<uint32_t>(key.size());
+                m_prefix = prefix(key);
+                if (is_inline())
+                    std::memcpy(m_inline, key.data(), key.size());
+                else
+                {
+                    m_offset = arena.size();
+                    arena.insert(arena.end(), key.begin(), key.end());
+                }
+            }
+
+            template <typename VV>
+            void set_val(VV &&v) noexcept { m_val = std::forward<VV>(v); }
+        };
+
+        template <bool Const>
+        class Iter
+        {
+        private:
+            using Table = std::conditional_t<Const, const StringHashTable, StringHashTable>;
+            using VRef = std::conditional_t<Const, const V &, V &>;
+
+            Table *m_table;
+            size_t m_cur;
+
+            constexpr void next() noexcept
+            {
+                do
+                {
+                    m_cur += 1;
+                } while (m_cur < m_table->m_capacity && !detail::is_used(m_table->m_ctrl[m_cur]));
+            }
+
+        public:
+            constexpr Iter(Table *t, size_t c) noexcept : m_table(t), m_cur(c - 1) // -1 from index because next() increments it by 1
+            {
+                next();
+            }
+            std::pair<std::string_view, VRef> operator*() const noexcept
+            {
+                auto &s = m_table->m_slots[m_cur];
+                return {s.key(m_table->m_arena.data()), s.val()};
+            }
+            constexpr bool operator==(const Iter &rhs) const noexcept { return m_cur == rhs.m_cur; }
+            constexpr bool operator!=(const Iter &rhs) const noexcept { return !(m_cur == rhs.m_cur); }
+            constexpr Iter &operator++() noexcept
+            {
+                next();
+                return *this;
+            }
+        };
+
+        template <bool Const>
+        class KVIter
+        {
+        private:
+            using Table = std::conditional_t<Const, const StringHashTable, StringHashTable>;
+            Table *m_table;
+
+        public:
+            constexpr KVIter(Table *t) noexcept : m_table(t) {}
+            [[nodiscard]] constexpr Iter<Const> begin() const noexcept { return Iter<Const>(m_table, 0); }
+            [[nodiscard]] constexpr Iter<Const> end() const noexcept { return Iter<Const>(m_table, m_table->m_capacity); }
+        };
+
+        // Member variables
+        std::unique_ptr<Slot[]> m_slots;
+        std::unique_ptr<Ctrl[]> m_ctrl;
+        std::vector<char> m_arena;
+        size_t m_capacity;
+        size_t m_size;
+        size_t m_occupancy;
+        size_t m_arena_garbage;
+        float m_max_load_factor;
+        std::hash<std::string_view> m_hasher;
+
+        [[nodiscard]] static constexpr float load_factor(size_t size, size_t cap) noexcept { return static_cast<float>(size) / static_cast<float>(cap); }
+
+        // Smallest valid capacity that holds n elements under the max load factor
+        [[nodiscard]] constexpr size_t min_capacity(size_t n) const noexcept
+        {
+            size_t cap = static_cast<size_t>(static_cast<float>(n) / m_max_load_factor) + 1; // Strictly under the max load factor
+
+            // Past 2^24 the float load factor rounds, grow until the check emplace makes passes for n elements
+            while (load_factor(n, cap) >= m_max_load_factor)
+                cap += cap / 1024 + 1;
+            return Policy::fit(std::max(cap, Policy::INIT_SIZE)); // Greater than the minimum size
+        }
+
+        // Returns the index of a slot that either matches the key or a usable slot
+        [[nodiscard]] size_t find_slot(const size_t hash, std::string_view key) const noexcept
+        {
+            const Ctrl *ctrl = m_ctrl.get();
+            const char *arena = m_arena.data();
+            const Ctrl h2 = detail::h2(hash);
+            const uint32_t key_prefix = Slot::prefix(key);
+            size_t ipos = Policy::index(hash, m_capacity);
+
+            // Optional Deleted Slot
+            std::optional<size_t> first_del_slot = std::nullopt;
+
+            // Linear Probe
+            while (true)
+            {
+                if (ipos + detail::GROUP_WIDTH <= m_capacity)
+                {
+                    // Probe a whole group, only the slots before the first empty one are part of the chain
+                    const detail::Group g(ctrl + ipos);
+                    const uint32_t empty = g.match_empty();
+                    const uint32_t in_chain = empty ? (empty & -empty) - 1 : 0xFFFF;
+
+                    // Return if key is the same
+                    for (uint32_t match = g.match(h2) & in_chain; match; match &= match - 1)
+                    {
+                        const size_t i = ipos + detail::lowest_bit(match);
+                        if (m_slots[i].matches(key, key_prefix, arena))
+                            return i;
+                    }
+
+                    // Set first deleted slot if it is null
+                    const uint32_t deleted = g.match_deleted() & in_chain;
+                    if (!first_del_slot && deleted)
+                        first_del_slot.emplace(ipos + detail::lowest_bit(deleted));
+
+                    // Return if slot is empty, reuse deleted slot if found
+                    if (empty)
+                        return first_del_slot ? first_del_slot.value() : ipos + detail::lowest_bit(empty);
+
+                    ipos += detail::GROUP_WIDTH;
+                }
+                else
+                {
+                    // Probe slot by slot near the end of the table
+                    const Ctrl c = ctrl[ipos];
+                    if (c == detail::CTRL_EMPTY)
+                        return first_del_slot ? first_del_slot.value() : ipos;
+                    else if (c == detail::CTRL_DELETED)
+                    {
+                        if (!first_del_slot)
+                            first_del_slot.emplace(ipos);
+                    }
+                    else if (c == h2 && m_slots[ipos].matches(key, key_prefix, arena))
+                        return ipos;
+
+                    ipos += 1;
+                }
+
+                // Wrap cursor
+                if (ipos >= m_capacity)
+                    ipos -= m_capacity;
+            }
+        }
+
+        // Rehash into new_cap slots, long keys are copied into a fresh arena which drops removed keys
+        void rehash(size_t new_cap) noexcept
+        {
+            auto old_slots = std::move(m_slots);
+            auto old_ctrl = std::move(m_ctrl);
+            std::vector<char> old_arena;
+            old_arena.swap(m_arena);
+            const size_t old_cap = m_capacity;
+
+            m_slots = std::make_unique<Slot[]>(new_cap);
+            m_ctrl = std::make_unique<Ctrl[]>(new_cap);
+            std::fill(m_ctrl.get(), m_ctrl.get() + new_cap, detail::CTRL_EMPTY);
+            m_capacity = new_cap;
+            m_arena.reserve(old_arena.size() - m_arena_garbage);
+            m_arena_garbage = 0;
+
+            for (size_t i = 0; i < old_cap; i++)
+            {
+                if (!detail::is_used(old_ctrl[i]))
+                    continue;
+                const std::string_view key = old_slots[i].key(old_arena.data());
+                const size_t hash = m_hasher(key);
+                const size_t j = find_slot(hash, key);
+                m_ctrl[j] = detail::h2(hash);
+                m_slots[j].set_key(key, m_arena);
+                m_slots[j].set_val(std::move(old_slots[i].val()));
+            }
+            m_occupancy = m_size;
+        }
+
+        // Copy the live long keys into a fresh arena, in place of a rehash when removes without inserts pile up garbage
+        void compact_arena() noexcept
+        {
+            std::vector<char> old_arena;
+            old_arena.swap(m_arena);
+            m_arena.reserve(old_arena.size() - m_arena_garbage);
+            m_arena_garbage = 0;
+            for (size_t i = 0; i < m_capacity; i++)
+                if (detail::is_used(m_ctrl[i]) && !m_slots[i].is_inline())
+                    m_slots[i].set_key(m_slots[i].key(old_arena.data()), m_arena);
+        }
+
+    public:
+        // ctors
+        StringHashTable() noexcept : m_capacity(0), m_size(0), m_occupancy(0), m_arena_garbage(0), m_max_load_factor(Policy::MAX_LOAD_FACTOR) {}
+
+        // copy operations
+        StringHashTable(const StringHashTable &other) noexcept
+            : m_arena(other.m_arena), m_capacity(other.m_capacity), m_size(other.m_size), m_occupancy(other.m_occupancy),
+              m_arena_garbage(other.m_arena_garbage), m_max_load_factor(other.m_max_load_factor)
+        {
+            m_slots = std::make_unique<Slot[]>(m_capacity);
+            m_ctrl = std::make_unique<Ctrl[]>(m_capacity);
+            std::copy(other.m_slots.get(), other.m_slots.get() + m_capacity, m_slots.get());
+            std::copy(other.m_ctrl.get(), other.m_ctrl.get() + m_capacity, m_ctrl.get());
+        }
+        StringHashTable &operator=(const StringHashTable &other) noexcept
+        {
+            StringHashTable copy(other);
+            *this = std::move(copy);
+            return *this;
+        }
+
+        // move operations
+        StringHashTable(StringHashTable &&other) noexcept
+            : m_slots(std::move(other.m_slots)), m_ctrl(std::move(other.m_ctrl)), m_arena(std::move(other.m_arena)), m_capacity(other.m_capacity),
+              m_size(other.m_size), m_occupancy(other.m_occupancy), m_arena_garbage(other.m_arena_garbage), m_max_load_factor(other.m_max_load_factor)
+        {
+            other.m_capacity = 0;
+            other.m_size = 0;
+            other.m_occupancy = 0;
+            other.m_arena_garbage = 0;
+        }
+        StringHashTable &operator=(StringHashTable &&other) noexcept
+        {
+            m_slots = std::move(other.m_slots);
+            m_ctrl = std::move(other.m_ctrl);
+            m_arena = std::move(other.m_arena);
+            m_capacity = other.m_capacity;
+            m_size = other.m_size;
+            m_occupancy = other.m_occupancy;
+            m_arena_garbage = other.m_arena_garbage;
+            m_max_load_factor = other.m_max_load_factor;
+            other.m_capacity = 0;
+            other.m_size = 0;
+            other.m_occupancy = 0;
+            other.m_arena_garbage = 0;
+            return *this;
+        }
+
+        // getters
+        [[nodiscard]] constexpr size_t capacity() const noexcept { return m_capacity; }
+        [[nodiscard]] constexpr size_t size() const noexcept { return m_size; }
+        [[nodiscard]] constexpr size_t occupancy() const noexcept { return m_occupancy; }
+        [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+        [[nodiscard]] constexpr float max_load_factor() const noexcept { return m_max_load_factor; }
+        [[nodiscard]] size_t arena_size() const noexcept { return m_arena.size(); }
+        [[nodiscard]] constexpr KVIter<false> key_values() noexcept { return KVIter<false>(this); }
+        [[nodiscard]] constexpr KVIter<true> key_values() const noexcept { return KVIter<true>(this); }
+
+        // setters
+        // Set the max load factor, the table rehashes right away if it is already over the new limit
+        void max_load_factor(float lf) noexcept
+        {
+            assert(lf > 0 && lf < 1);
+            m_max_load_factor = lf;
+            if (m_capacity != 0 && load_factor(m_occupancy, m_capacity) >= m_max_load_factor)
+                rehash(min_capacity(m_size + 1));
+        }
+
+        // functions
+        template <typename VV>
+        std::optional<V> emplace(std::string_view key, VV &&val) noexcept
+        {
+            assert(key.size() <= UINT32_MAX);
+
+            // Rehash if over load factor limit
+            if (m_capacity == 0 || load_factor(m_occupancy + 1, m_capacity) >= m_max_load_factor)
+                rehash(std::max(Policy::grow(m_capacity), min_capacity(m_size + 1)));
+
+            // Hash & find slot
+            const size_t hash = m_hasher(key);
+            const size_t i = find_slot(hash, key);
+            Slot &s = m_slots[i];
+
+            // Replace and return old value if slot is used
+            if (detail::is_used(m_ctrl[i]))
+            {
+                V old = std::move(s.val());
+                s.set_val(std::forward<VV>(val));
+                return old;
+            }
+
+            // Only increase the occupancy if using an empty slot
+            m_size += 1;
+            if (m_ctrl[i] == detail::CTRL_EMPTY)
+                m_occupancy += 1;
+            m_ctrl[i] = detail::h2(hash);
+            s.set_key(key, m_arena);
+            s.set_val(std::forward<VV>(val));
+            return std::nullopt;
+        }
+
+        std::optional<V *> find(std::string_view key) noexcept
+        {
+            if (m_capacity == 0)
+                return std::nullopt;
+            const size_t i = find_slot(m_hasher(key), key);
+            if (!detail::is_used(m_ctrl[i]))
+                return std::nullopt;
+            return &m_slots[i].val();
+        }
+
+        std::optional<const V *> find(std::string_view key) const noexcept
+        {
+            if (m_capacity == 0)
+                return std::nullopt;
+            const size_t i = find_slot(m_hasher(key), key);
+            if (!detail::is_used(m_ctrl[i]))
+                return std::nullopt;
+            return static_cast<const V *>(&m_slots[i].val());
+        }
+
+        std::optional<std::pair<std::string, V>> remove(std::string_view key) noexcept
+        {
+            if (m_capacity == 0)
+                return std::nullopt;
+
+            // If slot is empty, return null
+            const size_t i = find_slot(m_hasher(key), key);
+            if (!detail::is_used(m_ctrl[i]))
+                return std::nullopt;
+
+            // Extract the key & value, a long key's bytes stay in the arena until the next rehash or compaction
+            Slot &s = m_slots[i];
+            std::pair<std::string, V> kv(std::string(key), std::move(s.val()));
+            if (!s.is_inline())
+                m_arena_garbage += s.len();
+            m_size -= 1;
+            m_ctrl[i] = detail::CTRL_DELETED;
+
+            // Reused tombstones never rehash, so compact once the garbage outweighs the live keys & the slots to scan
+            if (m_arena_garbage > m_arena.size() - m_arena_garbage + m_capacity)
+                compact_arena();
+            return kv;
+        }
+
+        void reserve(size_t new_size) noexcept
+        {
+            const size_t new_cap = min_capacity(new_size);
+
+            // Table can only grow
+            if (new_cap > m_capacity)
+                rehash(new_cap);
+        }
+
+        // Shrink the table to the size that exactly fits all keys & values, and compact the arena
+        void shrink_to_fit() noexcept
+        {
+            rehash(min_capacity(m_size));
+            m_arena.shrink_to_fit();
+        }
+    };
+}
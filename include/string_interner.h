@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace HashTable
+{
+    // Maps strings to dense 32-bit IDs & back
+    // String bytes are stored once in an append-only chunked arena, so resolved views stay valid for the interner's lifetime.
+    // Hash slots only hold an ID & a 32-bit hash, a rehash never touches the string bytes
+    class StringInterner
+    {
+    public:
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+        static constexpr float MAX_LOAD_FACTOR = 0.75;
+        static constexpr size_t INIT_SIZE = 16;
+
+    private:
+        static constexpr uint32_t EMPTY_ID = UINT32_MAX;
+
+        struct Slot
+        {
+            uint32_t id;
+            uint32_t hash;
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        size_t m_mask;
+        std::vector<std::string_view> m_strings;
+        std::vector<std::unique_ptr<char[]>> m_chunks;
+        std::vector<std::unique_ptr<char[]>> m_large;
+        size_t m_chunk_used;
+        size_t m_arena_bytes;
+        std::hash<std::string_view> m_hasher;
+
+        [[nodiscard]] uint32_t hash(std::string_view s) const noexcept
+        {
+            const size_t h = m_hasher(s);
+            return static_cast<uint32_t>(h ^ (h >> 32));
+        }
+
+        [[nodiscard]] size_t capacity() const noexcept { return m_slots ? m_mask + 1 : 0; }
+
+        // Returns the index of the slot holding the string, or the empty slot ending its probe chain
+        [[nodiscard]] size_t find_slot(uint32_t h, std::string_view s) const noexcept
+        {
+            size_t ipos = h & m_mask;
+            while (true)
+            {
+                const Slot &slot = m_slots[ipos];
+                if (slot.id == EMPTY_ID)
+                    return ipos;
+                if (slot.hash == h && m_strings[slot.id] == s)
+                    return ipos;
+                ipos = (ipos + 1) & m_mask;
+            }
+        }
+
+        void rehash(size_t new_cap) noexcept
+        {
+            const size_t old_cap = capacity();
+            auto old_slots = std::move(m_slots);
+            m_slots = std::make_unique<Slot[]>(new_cap);
+            m_mask = new_cap - 1;
+            std::fill(m_slots.get(), m_slots.get() + new_cap, Slot{EMPTY_ID, 0});
+
+            // Slots are moved by their stored hash, the strings are not read
+            for (size_t i = 0; i < old_cap; i++)
+            {
+                const Slot &slot = old_slots[i];
+                if (slot.id == EMPTY_ID)
+                    continue;
+                size_t ipos = slot.hash & m_mask;
+                while (m_slots[ipos].id != EMPTY_ID)
+                    ipos = (ipos + 1) & m_mask;
+                m_slots[ipos] = slot;
+            }
+        }
+
+        // Copy the bytes into the arena, strings larger than a quarter chunk get a chunk of their own
+        [[nodiscard]] std::string_view store(std::string_view s) noexcept
+        {
+            if (s.size() > CHUNK_SIZE / 4)
+            {
+                m_large.push_back(std::make_unique<char[]>(s.size()));
+                std::memcpy(m_large.back().get(), s.data(), s.size());
+                m_arena_bytes += s.size();
+                return std::string_view(m_large.back().get(), s.size());
+            }
+            if (m_chunks.empty() || m_chunk_used + s.size() > CHUNK_SIZE)
+            {
+                m_chunks.push_back(std::make_unique<char[]>(CHUNK_SIZE));
+                m_chunk_used = 0;
+                m_arena_bytes += CHUNK_SIZE;
+            }
+            char *dst = m_chunks.back().get() + m_chunk_used;
+            std::memcpy(dst, s.data(), s.size());
+            m_chunk_used += s.size();
+            return std::string_view(dst, s.size());
+        }
+
+    public:
+        // ctors
+        StringInterner() noexcept : m_mask(0), m_chunk_used(0), m_arena_bytes(0) {}
+
+        // An interner hands out views into its arena, it can be moved but not copied
+        StringInterner(const StringInterner &) = delete;
+        StringInterner &operator=(const StringInterner &) = delete;
+        StringInterner(StringInterner &&) noexcept = default;
+        StringInterner &operator=(StringInterner &&) noexcept = default;
+
+        // getters
+        [[nodiscard]] size_t size() const noexcept { return m_strings.size(); }
+        [[nodiscard]] bool empty() const noexcept { return m_strings.empty(); }
+
+        // Bytes held by the hash slots, the ID table & the arena
+        [[nodiscard]] size_t memory_usage() const noexcept
+        {
+            return capacity() * sizeof(Slot) + m_strings.capacity() * sizeof(std::string_view) + m_arena_bytes;
+        }
+
+        // functions
+        // Returns the ID of the string, interning it if it is new
+        uint32_t intern(std::string_view s) noexcept
+        {
+            // Grow before the probe so the returned slot stays valid
+            if (capacity() == 0 || static_cast<float>(size() + 1) / static_cast<float>(capacity()) >= MAX_LOAD_FACTOR)
+                rehash(std::max(capacity() * 2, INIT_SIZE));
+
+            const uint32_t h = hash(s);
+            Slot &slot = m_slots[find_slot(h, s)];
+            if (slot.id != EMPTY_ID)
+                return slot.id;
+
+            assert(m_strings.size() < EMPTY_ID);
+            const uint32_t id = static_cast<uint32_t>(m_strings.size());
+            m_strings.push_back(store(s));
+            slot = Slot{id, h};
+            return id;
+        }
+
+        // Returns the ID of the string if it was interned
+        [[nodiscard]] std::optional<uint32_t> find(std::string_view s) const noexcept
+        {
+            if (capacity() == 0)
+                return std::nullopt;
+            const Slot &slot = m_slots[find_slot(hash(s), s)];
+            if (slot.id == EMPTY_ID)
+                return std::nullopt;
+            return slot.id;
+        }
+
+        // Returns the string of an ID
+        [[nodiscard]] std::string_view resolve(uint32_t id) const noexcept
+        {
+            assert(id < m_strings.size());
+            return m_strings[id];
+        }
+
+        void reserve(size_t n) noexcept
+        {
+            m_strings.reserve(n);
+            size_t new_cap = INIT_SIZE;
+            while (static_cast<float>(n) / static_cast<float>(new_cap) >= MAX_LOAD_FACTOR)
+                new_cap *= 2;
+            if (new_cap > capacity())
+                rehash(new_cap);
+        }
+
+    private:
+        friend class FrozenStringInterner;
+
+        void shrink_ids() { m_strings.shrink_to_fit(); }
+    };
+
+    // Read only interner, only const member functions exist so it is safe to share across threads
+    class FrozenStringInterner
+    {
+    private:
+        StringInterner m_interner;
+
+    public:
+        explicit FrozenStringInterner(StringInterner &&interner) noexcept : m_interner(std::move(interner))
+        {
+            m_interner.shrink_ids();
+        }
+
+        [[nodiscard]] size_t size() const noexcept { return m_interner.size(); }
+        [[nodiscard]] bool empty() const noexcept { return m_interner.empty(); }
+        [[nodiscard]] size_t memory_usage() const noexcept { return m_interner.memory_usage(); }
+        [[nodiscard]] std::optional<uint32_t> find(std::string_view s) const noexcept { return m_interner.find(s); }
+        [[nodiscard]] std::string_view resolve(uint32_t id) const noexcept { return m_interner.resolve(id); }
+    };
+
+    // Freeze an interner, it can no longer intern new strings
+    [[nodiscard]] inline FrozenStringInterner freeze(StringInterner &&interner) noexcept
+    {
+        return FrozenStringInterner(std::move(interner));
+    }
+}
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Compare two google-benchmark JSON results, files or directories of them, & fail on a significant regression.
+
+Every benchmark needs repetitions (--benchmark_repetitions). The repetitions of the baseline & the current run are
+compared with a two-sided Mann-Whitney U test. A benchmark regresses when the test finds a difference at --alpha &
+its median got worse by more than --threshold. Exits 1 if any benchmark regressed, so it can gate a build.
+Standard library only, it runs offline.
+"""
+
+import argparse
+import json
+import math
+import os
+import sys
+
+# Metrics where a larger value is better, every other one is a time or a count per op
+HIGHER_IS_BETTER = ("items_per_second", "bytes_per_second", "ipc")
+
+# Largest sample sizes for the exact U distribution, larger ones use the normal approximation
+EXACT_MAX = 20
+
+
+def load(path):
+    """Returns ({run_name: [metric values of each repetition]}, context) of a JSON file or a directory of them"""
+    files = [path]
+    if os.path.isdir(path):
+        files = sorted(os.path.join(path, f) for f in os.listdir(path) if f.endswith(".json"))
+        files = [f for f in files if os.path.getsize(f) > 0]  # A binary whose benchmarks were all filtered out
+    runs = {}
+    context = {}
+    for f in files:
+        with open(f) as fp:
+            doc = json.load(fp)
+        context = doc.get("context", context)
+        for b in doc.get("benchmarks", []):
+            if b.get("run_type", "iteration") != "iteration" or "error_occurred" in b:
+                continue
+            runs.setdefault(b["run_name"], []).append(b)
+    return runs, context
+
+
+def median(xs):
+    s = sorted(xs)
+    n = len(s)
+    return s[n // 2] if n % 2 else (s[n // 2 - 1] + s[n // 2]) / 2
+
+
+def ranks(values):
+    """Ranks from 1 with ties given their mean rank, & the tie group sizes"""
+    order = sorted(range(len(values)), key=lambda i: values[i])
+    r = [0.0] * len(values)
+    ties = []
+    i = 0
+    while i < len(order):
+        j = i
+        while j + 1 < len(order) and values[order[j + 1]] == values[order[i]]:
+            j += 1
+        for k in range(i, j + 1):
+            r[order[k]] = (i + j) / 2 + 1
+        ties.append(j - i + 1)
+        i = j + 1
+    return r, ties
+
+
+def exact_u_cdf(n1, n2):
+    """Cumulative counts of U over all C(n1 + n2, n1) orderings, f(n1, n2, u) = f(n1 - 1, n2, u - n2) + f(n1, n2 - 1, u)"""
+    f = [[[1] + [0] * (n1 * n2) for _ in range(n2 + 1)] for _ in range(n1 + 1)]
+    for a in range(1, n1 + 1):
+        for b in range(1, n2 + 1):
+            for u in range(a * b + 1):
+                f[a][b][u] = (f[a - 1][b][u - b] if u >= b else 0) + f[a][b - 1][u]
+    cdf = []
+    total = 0
+    for c in f[n1][n2]:
+        total += c
+        cdf.append(total)
+    return cdf
+
+
+def mann_whitney(xs, ys):
+    """Two-sided p-value of the Mann-Whitney U test"""
+    n1, n2 = len(xs), len(ys)
+    r, ties = ranks(list(xs) + list(ys))
+    u1 = sum(r[:n1]) - n1 * (n1 + 1) / 2
+    u = min(u1, n1 * n2 - u1)
+
+    if max(n1, n2) <= EXACT_MAX and all(t == 1 for t in ties):
+        cdf = exact_u_cdf(n1, n2)
+        return min(1.0, 2 * cdf[int(u)] / cdf[-1])
+
+    n = n1 + n2
+    tie_term = sum(t ** 3 - t for t in ties) / (n * (n - 1))
+    sigma = math.sqrt(n1 * n2 / 12 * ((n + 1) - tie_term))
+    if sigma == 0:
+        return 1.0
+    z = (abs(u1 - n1 * n2 / 2) - 0.5) / sigma  # Continuity correction
+    return min(1.0, math.erfc(max(z, 0) / math.sqrt(2)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline", help="JSON file or directory of JSON files")
+    parser.add_argument("current", help="JSON file or directory of JSON files")
+    parser.add_argument("--metric", default="real_time", help="real_time, cpu_time or any counter such as instructions_per_op")
+    parser.add_argument("--threshold", type=float, default=0.05, help="Median change counted as a regression, 0.05 is 5%%")
+    parser.add_argument("--alpha", type=float, default=0.05, help="Significance level of the U test")
+    args = parser.parse_args()
+
+    base, base_ctx = load(args.baseline)
+    cur, cur_ctx = load(args.current)
+    if not base or not cur:
+        print("bm_compare: no benchmark results in %s" % (args.baseline if not base else args.current), file=sys.stderr)
+        return 2
+    if base_ctx.get("host_name") != cur_ctx.get("host_name") or base_ctx.get("num_cpus") != cur_ctx.get("num_cpus"):
+        print("bm_compare: warning, baseline & current ran on different machines", file=sys.stderr)
+
+    higher_better = args.metric in HIGHER_IS_BETTER
+    width = max(len(name) for name in cur)
+    print("%-*s %12s %12s %9s %8s  %s" % (width, "Benchmark", "Baseline", "Current", "Change", "p", "Verdict"))
+
+    regressions = []
+    unpaired = 0
+    for name, runs in cur.items():
+        if name not in base:
+            unpaired += 1
+            continue
+        xs = [b[args.metric] for b in base[name] if args.metric in b]
+        ys = [b[args.metric] for b in runs if args.metric in b]
+        if not xs or not ys:
+            continue
+
+        mx, my = median(xs), median(ys)
+        change = (my - mx) / mx if mx else 0.0
+        worse = -change if higher_better else change
+        if min(len(xs), len(ys)) < 2:
+            p = float("nan")
+            verdict = "no test, needs repetitions"
+        else:
+            p = mann_whitney(xs, ys)
+            if p >= args.alpha:
+                verdict = ""
+            elif worse > args.threshold:
+                verdict = "REGRESSION"
+                regressions.append(name)
+            elif worse < -args.threshold:
+                verdict = "improvement"
+            else:
+                verdict = "within threshold"
+        print("%-*s %12.4g %12.4g %+8.1f%% %8.4f  %s" % (width, name, mx, my, 100 * change, p, verdict))
+
+    if unpaired:
+        print("%d benchmarks have no baseline" % unpaired)
+    if regressions:
+        print("%d regressions past %.1f%%: %s" % (len(regressions), 100 * args.threshold, ", ".join(regressions)))
+        return 1
+    print("No regressions past %.1f%%" % (100 * args.threshold))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
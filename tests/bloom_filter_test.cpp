@@ -0,0 +1,68 @@
+#include "bloom_filter.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+
+constexpr size_t VEC_SIZE = 4096;
+
+int main()
+{
+    // No false negatives & few false positives
+    {
+        HashTable::BlockedBloomFilter f(VEC_SIZE * 4);
+        for (size_t i = 0; i < VEC_SIZE * 4; i++)
+            f.insert(HashTable::detail::mix_hash(i));
+        for (size_t i = 0; i < VEC_SIZE * 4; i++)
+            assert(f.may_contain(HashTable::detail::mix_hash(i)));
+        size_t false_positives = 0;
+        for (size_t i = 0; i < VEC_SIZE * 4; i++)
+            false_positives += f.may_contain(HashTable::detail::mix_hash(VEC_SIZE * 4 + i));
+        assert(false_positives < VEC_SIZE * 4 / 50); // Assert under 2%
+
+        f.clear();
+        assert(!f.may_contain(HashTable::detail::mix_hash(0)));
+        assert(!HashTable::BlockedBloomFilter().may_contain(0));
+    }
+
+    // Random inserts, updates & removals checked against std::unordered_map, removals trigger filter rebuilds
+    {
+        HashTable::FilteredHashTable<size_t, size_t> m;
+        std::unordered_map<size_t, size_t> model;
+        std::mt19937_64 gen(7);
+        for (size_t i = 0; i < VEC_SIZE * 16; i++)
+        {
+            const size_t k = gen() % VEC_SIZE;
+            if (gen() % 2 == 0)
+            {
+                const auto kv = m.remove(k);
+                assert(kv.has_value() == (model.count(k) == 1));
+                assert(!kv || kv->second == model[k]);
+                model.erase(k);
+            }
+            else
+            {
+                const auto old = m.emplace(k, i);
+                assert(old.has_value() == (model.count(k) == 1));
+                model[k] = i;
+            }
+            assert(m.size() == model.size());
+        }
+        const auto &cm = m;
+        for (size_t k = 0; k < VEC_SIZE * 2; k++)
+        {
+            const auto v = cm.find(k);
+            assert(v.has_value() == (model.count(k) == 1));
+            assert(!v || *v.value() == model[k]);
+        }
+        assert(m.filter_memory_usage() > 0);
+
+        // Growth past the filter sizing keeps every key
+        m.reserve(VEC_SIZE * 4);
+        for (size_t k = 0; k < VEC_SIZE * 8; k++)
+            m.emplace(k, k);
+        for (size_t k = 0; k < VEC_SIZE * 8; k++)
+            assert(*m.find(k).value() == k);
+    }
+}
@@ -0,0 +1,88 @@
+#include "compact_hashtable.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <random>
+#include <unordered_set>
+
+constexpr size_t VEC_SIZE = 4096;
+
+// Random inserts & removals checked against std::unordered_set
+template <typename K>
+void test_against_set(K key_range)
+{
+    HashTable::CompactIntSet<K> m;
+    std::unordered_set<K> model;
+    std::mt19937_64 gen(42);
+    for (size_t i = 0; i < VEC_SIZE * 8; i++)
+    {
+        const K k = static_cast<K>(gen() % key_range);
+        if (gen() % 3 == 0)
+        {
+            const bool removed = m.remove(k);
+            const bool expected = model.erase(k) == 1;
+            assert(removed == expected);
+        }
+        else
+        {
+            const bool inserted = m.insert(k);
+            const bool expected = model.insert(k).second;
+            assert(inserted == expected);
+        }
+        assert(m.size() == model.size());
+    }
+    for (K k = 0; k < key_range; k++)
+        assert(m.contains(k) == (model.count(k) == 1));
+
+    // Every slot decodes back to its key
+    size_t count = 0;
+    m.for_each([&](K k)
+               {
+                   assert(model.count(k) == 1);
+                   count += 1; });
+    assert(count == model.size());
+
+    // Copy
+    const auto copy = m;
+    for (const K k : model)
+        assert(copy.contains(k));
+}
+
+// Fill up to the max load factor without a rehash
+template <typename K>
+void test_high_load()
+{
+    HashTable::CompactIntSet<K> m(VEC_SIZE * 16);
+    const size_t cap = m.capacity();
+    const size_t n = static_cast<size_t>(cap * HashTable::CompactIntSet<K>::MAX_LOAD_FACTOR);
+    std::mt19937_64 gen(7);
+    while (m.size() < n)
+        m.insert(static_cast<K>(gen()));
+    assert(m.capacity() == cap);
+    assert(m.load_factor() > 0.95);
+    assert(m.memory_usage() < m.size() * sizeof(K)); // Assert fewer bytes than the raw keys
+
+    // Keys & extremes survive a rehash
+    m.insert(0);
+    m.insert(static_cast<K>(-1));
+    m.reserve(cap * 2);
+    assert(m.capacity() > cap);
+    assert(m.contains(0) && m.contains(static_cast<K>(-1)));
+}
+
+int main()
+{
+    // Round trip of the key bijection
+    std::mt19937_64 gen(1);
+    for (size_t i = 0; i < VEC_SIZE; i++)
+    {
+        const uint64_t k = gen();
+        assert(HashTable::detail::InvertibleMix<uint64_t>::unmix(HashTable::detail::InvertibleMix<uint64_t>::mix(k)) == k);
+        assert(HashTable::detail::InvertibleMix<uint32_t>::unmix(HashTable::detail::InvertibleMix<uint32_t>::mix(static_cast<uint32_t>(k))) == static_cast<uint32_t>(k));
+    }
+
+    test_against_set<uint32_t>(VEC_SIZE);
+    test_against_set<uint64_t>(VEC_SIZE);
+    test_high_load<uint32_t>();
+    test_high_load<uint64_t>();
+}
@@ -0,0 +1,95 @@
+#include "coro_find.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+constexpr size_t VEC_SIZE = 1024;
+constexpr size_t STR_SIZE = 32;
+
+using Table = HashTable::HashTable<uint64_t, uint64_t>;
+
+// Two dependent lookups in one coroutine, the second key is the value found by the first
+HashTable::LookupTask<std::optional<uint64_t>> find_chain(const Table &a, const Table &b, const uint64_t &key)
+{
+    const auto first = co_await HashTable::async_find(a, key);
+    if (!first)
+        co_return std::nullopt;
+    const uint64_t mid = *first.value();
+    const auto second = co_await HashTable::async_find(b, mid);
+    if (!second)
+        co_return std::nullopt;
+    co_return *second.value();
+}
+
+int main()
+{
+    // A lookup on an empty table finds nothing
+    Table empty;
+    const uint64_t zero = 0;
+    auto task = HashTable::co_find(empty, zero);
+    while (!task.done())
+        task.resume();
+    assert(!task.result());
+
+    // Interleaved lookups agree with find, every result is delivered once
+    Table m;
+    for (uint64_t i = 0; i < VEC_SIZE; i += 2)
+        m.emplace(i, i * 3);
+    std::vector<uint64_t> keys;
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        keys.push_back(i);
+    std::vector<int> seen(VEC_SIZE, 0);
+    HashTable::interleave<8>(
+        keys.size(), [&](size_t i)
+        { return HashTable::co_find(m, keys[i]); },
+        [&](size_t i, std::optional<const uint64_t *> val)
+        {
+            seen[i] += 1;
+            assert(val.has_value() == (i % 2 == 0));
+            if (val)
+                assert(*val.value() == i * 3);
+        });
+    for (const int s : seen)
+        assert(s == 1);
+
+    // Fewer lookups than the ring holds, & none at all
+    size_t n_done = 0;
+    HashTable::interleave<64>(3, [&](size_t i)
+                              { return HashTable::co_find(m, keys[i]); },
+                              [&](size_t, std::optional<const uint64_t *>)
+                              { n_done += 1; });
+    assert(n_done == 3);
+    HashTable::interleave(0, [&](size_t i)
+                          { return HashTable::co_find(m, keys[i]); },
+                          [&](size_t, std::optional<const uint64_t *>)
+                          { assert(false); });
+
+    // Coroutines that suspend a different number of times each
+    Table b;
+    for (uint64_t i = 0; i < VEC_SIZE * 3; i += 4)
+        b.emplace(i, i + 1);
+    HashTable::interleave<4>(
+        keys.size(), [&](size_t i)
+        { return find_chain(m, b, keys[i]); },
+        [&](size_t i, std::optional<uint64_t> val)
+        {
+            const bool hit = i % 2 == 0 && (i * 3) % 4 == 0;
+            assert(val.has_value() == hit);
+            if (hit)
+                assert(*val == i * 3 + 1);
+        });
+
+    // String keys
+    const auto v = make_rand_vec(VEC_SIZE, STR_SIZE);
+    HashTable::HashTable<std::string, size_t> ms;
+    for (size_t i = 0; i < VEC_SIZE; i++)
+        ms.emplace(v[i], i);
+    HashTable::interleave(
+        v.size(), [&](size_t i)
+        { return HashTable::co_find(ms, v[i]); },
+        [&](size_t i, std::optional<const size_t *> val)
+        { assert(val && *val.value() == i); });
+}
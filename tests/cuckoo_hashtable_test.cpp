@@ -0,0 +1,101 @@
+#include "cuckoo_hashtable.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+constexpr size_t VEC_SIZE = 4096;
+
+// Random inserts, updates & removals checked against std::unordered_map
+template <typename Table>
+void test_against_map(size_t key_range)
+{
+    Table m;
+    std::unordered_map<uint64_t, uint64_t> model;
+    std::mt19937_64 gen(42);
+    for (size_t i = 0; i < VEC_SIZE * 8; i++)
+    {
+        const uint64_t k = gen() % key_range;
+        if (gen() % 3 == 0)
+        {
+            const auto kv = m.remove(k);
+            assert(kv.has_value() == (model.count(k) == 1));
+            assert(!kv || kv->second == model[k]);
+            model.erase(k);
+        }
+        else
+        {
+            const auto old = m.emplace(k, i);
+            assert(old.has_value() == (model.count(k) == 1));
+            assert(!old || old.value() == model[k]);
+            model[k] = i;
+        }
+        assert(m.size() == model.size());
+    }
+
+    const auto copy = m;
+    for (uint64_t k = 0; k < key_range; k++)
+    {
+        const auto v = copy.find(k);
+        assert(v.has_value() == (model.count(k) == 1));
+        assert(!v || *v.value() == model[k]);
+    }
+
+    size_t count = 0;
+    m.for_each([&](const auto &k, auto &v)
+               {
+                   assert(model[k] == v);
+                   count += 1; });
+    assert(count == model.size());
+
+    auto moved = std::move(m);
+    assert(moved.size() == model.size());
+    assert(m.size() == 0 && !m.find(0));
+}
+
+// Fill a fixed table to high load, every insert must fit without growing
+template <typename Table>
+void test_high_load(float load)
+{
+    Table m;
+    m.reserve(VEC_SIZE * 16);
+    const size_t cap = m.capacity();
+    std::mt19937_64 gen(7);
+    while (m.load_factor() < load)
+        m.emplace(gen(), 0);
+    assert(m.capacity() == cap);
+    assert(m.stash_size() <= Table::STASH_SIZE);
+}
+
+int main()
+{
+    static_assert(HashTable::detail::cuckoo_bucket_size<uint32_t, uint32_t>() == 7);
+    static_assert(HashTable::detail::cuckoo_bucket_size<uint64_t, uint64_t>() == 3);
+    static_assert(sizeof(HashTable::CuckooHashTable<uint64_t, uint64_t>) > 0);
+
+    test_against_map<HashTable::CuckooHashTable<uint64_t, uint64_t>>(VEC_SIZE);
+    test_against_map<HashTable::CuckooHashTable<uint64_t, uint64_t, 1>>(VEC_SIZE);
+    test_against_map<HashTable::CuckooHashTable<uint64_t, uint64_t, 8>>(VEC_SIZE);
+    test_high_load<HashTable::CuckooHashTable<uint32_t, uint32_t>>(0.95);
+    test_high_load<HashTable::CuckooHashTable<uint64_t, uint64_t, 4>>(0.95);
+    test_high_load<HashTable::CuckooHashTable<uint64_t, uint64_t>>(0.9);
+
+    // Non trivial keys
+    HashTable::CuckooHashTable<std::string, std::string> s;
+    const auto vkey = make_rand_vec(VEC_SIZE, 16);
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const auto before = s.emplace(vkey[i], vkey[i]);
+        assert(!before);
+    }
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(*s.find(vkey[i]).value() == vkey[i]);
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const auto kv = s.remove(vkey[i]);
+        assert(kv->second == vkey[i]);
+    }
+    assert(s.empty());
+}
@@ -0,0 +1,205 @@
+#include "durable_hashtable.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+constexpr size_t VEC_SIZE = 4096;
+
+namespace fs = std::filesystem;
+
+// Fresh directory under the system temp dir
+fs::path make_dir(const std::string &name)
+{
+    const auto dir = fs::temp_directory_path() / ("durable_test_" + name + "_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    return dir;
+}
+
+template <typename Table, typename Map>
+void check_equal(const Table &m, const Map &model)
+{
+    assert(m.size() == model.size());
+    for (const auto &[k, v] : model)
+        assert(*m.find(k).value() == v);
+}
+
+// Random operations survive a reopen, across automatic checkpoints & every group size
+void test_recovery(size_t n_ops, size_t group_commit, size_t checkpoint_bytes)
+{
+    const auto dir = make_dir("recovery");
+    std::unordered_map<uint64_t, uint64_t> model;
+    std::mt19937_64 gen(42);
+    for (int round = 0; round < 3; round++)
+    {
+        HashTable::DurableHashTable<uint64_t, uint64_t> m(dir, {group_commit, checkpoint_bytes});
+        check_equal(m, model);
+        for (size_t i = 0; i < n_ops; i++)
+        {
+            const uint64_t k = gen() % (n_ops / 2);
+            if (gen() % 3 == 0)
+            {
+                const auto kv = m.remove(k);
+                assert(kv.has_value() == (model.count(k) == 1));
+                model.erase(k);
+            }
+            else
+            {
+                const auto old = m.emplace(k, i);
+                assert(old.has_value() == (model.count(k) == 1));
+                model[k] = i;
+            }
+        }
+        check_equal(m, model);
+    }
+
+    HashTable::DurableHashTable<uint64_t, uint64_t> m(dir);
+    check_equal(m, model);
+    if (checkpoint_bytes != 0)
+        assert(m.generation() > 0);
+    fs::remove_all(dir);
+}
+
+// A torn last record is dropped & later records follow the valid prefix
+void test_torn_tail()
+{
+    const auto dir = make_dir("torn");
+    {
+        HashTable::DurableHashTable<uint64_t, uint64_t> m(dir, {1, 0});
+        for (uint64_t i = 0; i < 100; i++)
+            m.emplace(i, i);
+    }
+    const auto wal = dir / "wal";
+    fs::resize_file(wal, fs::file_size(wal) - 3);
+    {
+        HashTable::DurableHashTable<uint64_t, uint64_t> m(dir);
+        assert(m.size() == 99 && !m.find(99));
+        m.emplace(uint64_t(1000), uint64_t(1));
+    }
+    HashTable::DurableHashTable<uint64_t, uint64_t> m(dir);
+    assert(m.size() == 100 && *m.find(1000).value() == 1);
+    fs::remove_all(dir);
+}
+
+// Records of the open group are lost without sync(), everything before it is kept
+void test_group_commit()
+{
+    const auto dir = make_dir("group");
+    {
+        HashTable::DurableHashTable<uint64_t, uint64_t> m(dir, {8, 0});
+        for (uint64_t i = 0; i < 20; i++)
+            m.emplace(i, i);
+        // Simulate a crash, the log holds the first two groups
+        HashTable::DurableHashTable<uint64_t, uint64_t> crashed(dir);
+        assert(crashed.size() == 16);
+    }
+    fs::remove_all(dir);
+}
+
+// A log from before the last checkpoint, left by a crash before it was replaced, is ignored
+void test_stale_log()
+{
+    const auto dir = make_dir("stale");
+    {
+        HashTable::DurableHashTable<uint64_t, uint64_t> m(dir, {1, 0});
+        for (uint64_t i = 0; i < 100; i++)
+            m.emplace(i, i);
+        fs::copy_file(dir / "wal", dir / "old_wal");
+        for (uint64_t i = 0; i < 50; i++)
+            m.remove(i);
+        m.checkpoint();
+    }
+    fs::rename(dir / "old_wal", dir / "wal");
+    HashTable::DurableHashTable<uint64_t, uint64_t> m(dir);
+    assert(m.size() == 50 && !m.find(0) && *m.find(50).value() == 50);
+    fs::remove_all(dir);
+}
+
+// Overwrite bytes of a file in place
+void patch_file(const fs::path &file, size_t offset, const void *data, size_t n)
+{
+    std::fstream f(file, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(static_cast<std::streamoff>(offset));
+    f.write(static_cast<const char *>(data), static_cast<std::streamsize>(n));
+}
+
+bool open_fails(const fs::path &dir)
+{
+    try
+    {
+        HashTable::DurableHashTable<uint64_t, uint64_t> m(dir);
+    }
+    catch (const std::system_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+// A corrupt checkpoint header is rejected before its count is used, even with a matching header crc
+void test_corrupt_header()
+{
+    constexpr size_t COUNT_OFFSET = 16;
+    constexpr size_t HEADER_CRC_OFFSET = 24;
+    const auto dir = make_dir("header");
+    {
+        HashTable::DurableHashTable<uint64_t, uint64_t> m(dir);
+        for (uint64_t i = 0; i < 100; i++)
+            m.emplace(i, i);
+        m.checkpoint();
+    }
+    const auto file = dir / "checkpoint";
+    std::string header(HEADER_CRC_OFFSET, '\0');
+    std::ifstream(file, std::ios::binary).read(header.data(), header.size());
+
+    const uint64_t huge = uint64_t(1) << 60;
+    patch_file(file, COUNT_OFFSET, &huge, sizeof(huge));
+    assert(open_fails(dir));
+
+    std::memcpy(header.data() + COUNT_OFFSET, &huge, sizeof(huge));
+    const uint32_t crc = HashTable::detail::crc32c(header.data(), header.size());
+    patch_file(file, HEADER_CRC_OFFSET, &crc, sizeof(crc));
+    assert(open_fails(dir));
+    fs::remove_all(dir);
+}
+
+int main()
+{
+    test_recovery(VEC_SIZE / 16, 1, 0);
+    test_recovery(VEC_SIZE, 64, 0);
+    test_recovery(VEC_SIZE, 64, 16 * 1024);
+    test_recovery(VEC_SIZE, VEC_SIZE * 4, 64 * 1024);
+    test_torn_tail();
+    test_group_commit();
+    test_stale_log();
+    test_corrupt_header();
+
+    // Non trivial keys
+    const auto dir = make_dir("string");
+    const auto vkey = make_rand_vec(VEC_SIZE, 16);
+    {
+        HashTable::DurableHashTable<std::string, std::string> s(dir);
+        for (size_t i = 0; i < vkey.size(); i++)
+        {
+            const auto before = s.emplace(vkey[i], vkey[i] + "v");
+            assert(!before);
+        }
+        s.checkpoint();
+        for (size_t i = 0; i < vkey.size(); i += 2)
+        {
+            const auto kv = s.remove(vkey[i]);
+            assert(kv->second == vkey[i] + "v");
+        }
+    }
+    HashTable::DurableHashTable<std::string, std::string> s(dir);
+    assert(s.size() == vkey.size() / 2);
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(s.find(vkey[i]).has_value() == (i % 2 == 1));
+    fs::remove_all(dir);
+}
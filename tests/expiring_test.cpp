@@ -0,0 +1,91 @@
+#include "expiring_hashtable.h"
+#include "tests.h"
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+constexpr size_t VEC_SIZE = 256;
+constexpr size_t STR_SIZE = 32;
+
+// Clock that only moves when told to
+struct ManualClock
+{
+    using duration = std::chrono::milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<ManualClock>;
+    static constexpr bool is_steady = true;
+
+    static inline time_point current{};
+    static time_point now() noexcept { return current; }
+    static void advance(duration d) noexcept { current += d; }
+};
+
+int main()
+{
+    using namespace std::chrono_literals;
+    const auto vkey = make_rand_vec(VEC_SIZE, STR_SIZE);
+    HashTable::ExpiringHashTable<std::string, size_t, ManualClock> m;
+
+    // Insert with TTLs of 1..VEC_SIZE ms
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const auto before = m.emplace(vkey[i], i, ManualClock::duration(i + 1));
+        assert(!before.has_value());
+    }
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(*m.find(vkey[i]).value() == i);
+
+    // Assert entries past their deadline are absent
+    ManualClock::advance(ManualClock::duration(VEC_SIZE / 2));
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const bool live = i + 1 > VEC_SIZE / 2;
+        const bool found = m.find(vkey[i]).has_value();
+        assert(found == live);
+        assert(m.deadline(vkey[i]).has_value() == live);
+    }
+
+    // Assert lazily found expired entries are reclaimed
+    assert(m.size() == vkey.size() - VEC_SIZE / 2);
+
+    // Assert updating a key moves its deadline
+    m.emplace(vkey.back(), 0, 1000ms);
+    ManualClock::advance(ManualClock::duration(VEC_SIZE));
+    assert(m.find(vkey.back()).has_value());
+
+    // Assert the expire sweep is bounded by its budget
+    for (size_t i = 0; i < vkey.size(); i++)
+        m.emplace(vkey[i], i, 1ms);
+    ManualClock::advance(1ms);
+    const size_t before = m.size();
+    const size_t reclaimed = m.expire(10);
+    assert(reclaimed <= 10);
+    assert(m.size() == before - reclaimed);
+
+    // Assert emplace reclaims expired entries incrementally
+    m.sweep_budget(VEC_SIZE);
+    m.emplace(std::string("fresh"), 1, 1000ms);
+    assert(m.size() == 1);
+
+    // Assert removal of an expired key returns nothing
+    m.emplace(vkey[0], 0, 1ms);
+    ManualClock::advance(1ms);
+    const auto expired = m.remove(vkey[0]);
+    const auto fresh = m.remove(std::string("fresh"));
+    assert(!expired.has_value() && fresh.has_value());
+    assert(m.empty());
+    const size_t left = m.expire_all();
+    assert(left == 0);
+
+    // Assert a new key keeps its deadline when its insert rebuilds a heap of stale deadlines
+    HashTable::ExpiringHashTable<int, int, ManualClock> r;
+    for (int i = 0; i < 66; i++)
+        r.emplace(0, i, 1000ms);
+    r.emplace(1, 1, 1ms);
+    ManualClock::advance(1ms);
+    const size_t stale = r.expire_all();
+    assert(stale == 1);
+    assert(r.size() == 1 && r.find(0).has_value());
+}
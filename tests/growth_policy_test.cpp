@@ -0,0 +1,113 @@
+#include "hashtable.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+
+constexpr size_t VEC_SIZE = 256;
+constexpr size_t STR_SIZE = 32;
+constexpr size_t N_STRIDED = 20000;
+constexpr uint64_t STRIDE = 4096;
+
+bool is_prime(size_t n)
+{
+    if (n < 2)
+        return false;
+    for (size_t i = 2; i * i <= n; i++)
+        if (n % i == 0)
+            return false;
+    return true;
+}
+
+// Strided integer keys, which std::hash maps to themselves, still spread over home slots & control byte tags
+template <typename Policy>
+void test_strided()
+{
+    HashTable::HashTable<uint64_t, uint64_t, Policy> m;
+    for (uint64_t i = 0; i < N_STRIDED; i++)
+        m.emplace(i * STRIDE, i);
+
+    std::set<size_t> homes;
+    std::set<HashTable::detail::Ctrl> tags;
+    for (uint64_t i = 0; i < N_STRIDED; i++)
+    {
+        assert(*m.find(i * STRIDE).value() == i);
+        homes.insert(Policy::index(m.hash(i * STRIDE), m.capacity()));
+        tags.insert(HashTable::detail::h2(m.hash(i * STRIDE)));
+    }
+    assert(homes.size() > N_STRIDED / 2);
+    assert(tags.size() == 128);
+}
+
+template <typename Policy, typename CapCheck>
+void test_policy(const std::vector<std::string> &vkey, const std::vector<std::string> &vval, CapCheck cap_check)
+{
+    HashTable::HashTable<std::string, std::string_view, Policy> m;
+    assert(m.max_load_factor() == Policy::MAX_LOAD_FACTOR); // Assert default load factor comes from the policy
+
+    // Insert into map
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const auto before = m.emplace(vkey[i], vval[i]);
+        assert(!before.has_value());                                                            // Assert there is no previous value
+        assert(static_cast<float>(m.occupancy()) / m.capacity() < m.max_load_factor()); // Assert load factor is respected
+        assert(cap_check(m.capacity()));                                                        // Assert capacity is valid for the policy
+    }
+
+    // Assert all keys can be found
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const auto val = m.find(vkey[i]);
+        assert(val.has_value());
+        assert(*val.value() == vval[i]);
+    }
+
+    // Lower the load factor, the table grows right away
+    const size_t old_cap = m.capacity();
+    m.max_load_factor(0.25);
+    assert(m.max_load_factor() == 0.25f);
+    assert(m.capacity() > old_cap);
+    assert(static_cast<float>(m.occupancy()) / m.capacity() < 0.25f);
+    assert(cap_check(m.capacity()));
+
+    // Assert all keys can still be found after the rehash
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const auto val = m.find(vkey[i]);
+        assert(val.has_value());
+        assert(*val.value() == vval[i]);
+    }
+
+    // Remove half of the keys and shrink
+    for (size_t i = 0; i < vkey.size(); i += 2)
+    {
+        const auto kv = m.remove(vkey[i]);
+        assert(kv.has_value());
+    }
+    m.shrink_to_fit();
+    assert(cap_check(m.capacity()));
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(m.find(vkey[i]).has_value() == (i % 2 == 1));
+}
+
+int main()
+{
+    const auto vkey = make_rand_vec(VEC_SIZE, STR_SIZE);
+    const auto vval = make_rand_vec(VEC_SIZE, STR_SIZE);
+
+    const auto any_cap = [](size_t) { return true; };
+    const auto pow2_cap = [](size_t cap) { return (cap & (cap - 1)) == 0; };
+    const auto prime_cap = [](size_t cap) { return is_prime(cap); };
+
+    test_policy<HashTable::DefaultPolicy>(vkey, vval, any_cap);
+    test_policy<HashTable::PowerOfTwoPolicy>(vkey, vval, pow2_cap);
+    test_policy<HashTable::PrimePolicy>(vkey, vval, prime_cap);
+    test_policy<HashTable::FrugalPolicy>(vkey, vval, any_cap);
+    test_policy<HashTable::HighLoadPolicy>(vkey, vval, pow2_cap);
+
+    test_strided<HashTable::DefaultPolicy>();
+    test_strided<HashTable::PowerOfTwoPolicy>();
+    test_strided<HashTable::HighLoadPolicy>();
+}
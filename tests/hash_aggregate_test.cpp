@@ -0,0 +1,134 @@
+#include "hash_aggregate.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+constexpr size_t N_ROWS = 10000; // Spans several batches, the last one partial
+constexpr size_t N_GROUPS = 300;
+constexpr size_t STR_SIZE = 16;
+
+struct Ref
+{
+    int64_t sum = 0;
+    uint64_t count = 0;
+    int64_t min = INT64_MAX;
+    int64_t max = INT64_MIN;
+};
+
+// Checks every group of a against the reference & returns the number of groups
+template <typename A, typename K>
+size_t check(const A &a, const std::unordered_map<K, Ref> &ref)
+{
+    for (size_t g = 0; g < a.size(); g++)
+    {
+        const Ref &r = ref.at(a.keys()[g]);
+        assert(a.sums()[g] == r.sum && a.counts()[g] == r.count);
+        assert(a.mins()[g] == r.min && a.maxs()[g] == r.max);
+        assert(a.group(a.keys()[g]) == g);
+    }
+    return a.size();
+}
+
+int main()
+{
+    std::mt19937_64 gen(7);
+    std::vector<uint64_t> keys(N_ROWS);
+    std::vector<int64_t> vals(N_ROWS);
+    std::unordered_map<uint64_t, Ref> ref;
+    for (size_t i = 0; i < N_ROWS; i++)
+    {
+        keys[i] = gen() % N_GROUPS;
+        vals[i] = static_cast<int64_t>(gen() % 2001) - 1000;
+        Ref &r = ref[keys[i]];
+        r.sum += vals[i];
+        r.count += 1;
+        r.min = std::min(r.min, vals[i]);
+        r.max = std::max(r.max, vals[i]);
+    }
+
+    // One pass over all rows, groups are numbered by first appearance
+    HashTable::HashAggregate<uint64_t, int64_t> a;
+    a.consume(keys.data(), vals.data(), N_ROWS);
+    assert(check(a, ref) == ref.size());
+    assert(a.group(keys[0]) == 0 && !a.group(N_GROUPS));
+
+    // Halves aggregated apart & merged agree with one pass
+    HashTable::HashAggregate<uint64_t, int64_t> lo;
+    HashTable::HashAggregate<uint64_t, int64_t> hi;
+    lo.consume(keys.data(), vals.data(), N_ROWS / 2);
+    hi.consume(keys.data() + N_ROWS / 2, vals.data() + N_ROWS / 2, N_ROWS - N_ROWS / 2);
+    lo.merge(hi);
+    assert(check(lo, ref) == ref.size());
+
+    // Clear keeps nothing
+    lo.clear();
+    assert(lo.empty() && !lo.group(keys[0]));
+    lo.consume(keys.data(), vals.data(), 0);
+    assert(lo.empty());
+
+    // A subset of aggregates leaves the other columns empty
+    HashTable::HashAggregate<uint64_t, int64_t, HashTable::AGG_SUM | HashTable::AGG_COUNT> sc;
+    sc.consume(keys.data(), vals.data(), N_ROWS);
+    assert(sc.mins().empty() && sc.maxs().empty());
+    for (size_t g = 0; g < sc.size(); g++)
+        assert(sc.sums()[g] == ref[sc.keys()[g]].sum && sc.counts()[g] == ref[sc.keys()[g]].count);
+
+    // A tiny local table spills often, each key ends up in exactly one partition
+    HashTable::PartitionedAggregate<uint64_t, int64_t> p(3, 16);
+    assert(p.partitions() == 8);
+    p.consume(keys.data(), vals.data(), N_ROWS / 3);
+    p.flush();
+    p.consume(keys.data() + N_ROWS / 3, vals.data() + N_ROWS / 3, N_ROWS - N_ROWS / 3);
+    uint64_t n_seen = 0;
+    for (size_t i = 0; i < p.partitions(); i++)
+        for (const uint64_t c : p.partition(i).counts())
+            n_seen += c;
+    assert(n_seen == N_ROWS / 3); // Rows since the last flush are not visible
+    p.flush();
+    size_t n_groups = 0;
+    for (size_t i = 0; i < p.partitions(); i++)
+        n_groups += check(p.partition(i), ref);
+    assert(n_groups == ref.size() && p.size() == ref.size());
+
+    // Without radix bits there is one partition
+    HashTable::PartitionedAggregate<uint64_t, int64_t> one(0, 64);
+    one.consume(keys.data(), vals.data(), N_ROWS);
+    one.flush();
+    assert(one.partitions() == 1 && check(one.partition(0), ref) == ref.size());
+
+    // String keys & floating point values
+    const auto names = make_rand_vec(N_GROUPS / 10, STR_SIZE);
+    std::vector<std::string> skeys(N_ROWS);
+    std::vector<double> dvals(N_ROWS);
+    for (size_t i = 0; i < N_ROWS; i++)
+    {
+        skeys[i] = names[keys[i] % names.size()];
+        dvals[i] = static_cast<double>(vals[i]) / 4;
+    }
+    HashTable::PartitionedAggregate<std::string, double> s(2, 8);
+    s.consume(skeys.data(), dvals.data(), N_ROWS);
+    s.flush();
+    assert(s.size() == names.size());
+    for (size_t i = 0; i < s.partitions(); i++)
+    {
+        const auto &part = s.partition(i);
+        for (size_t g = 0; g < part.size(); g++)
+        {
+            double sum = 0;
+            uint64_t count = 0;
+            double min = 1e9;
+            for (size_t r = 0; r < N_ROWS; r++)
+                if (skeys[r] == part.keys()[g])
+                {
+                    sum += dvals[r];
+                    count += 1;
+                    min = std::min(min, dvals[r]);
+                }
+            assert(part.sums()[g] == sum && part.counts()[g] == count && part.mins()[g] == min);
+        }
+    }
+}
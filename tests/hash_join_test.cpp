@@ -0,0 +1,109 @@
+#include "hash_join.h"
+#include "tests.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr size_t N_BUILD = 5000;
+constexpr size_t N_PROBE = 7000;
+constexpr size_t N_KEYS = 3000; // Keys repeat on both sides & some are on one side only
+constexpr size_t STR_SIZE = 16;
+
+using Pairs = std::vector<std::pair<uint32_t, uint32_t>>;
+
+Pairs sorted_pairs(const HashTable::JoinMatches &m)
+{
+    assert(m.build.size() == m.probe.size());
+    Pairs p;
+    for (size_t i = 0; i < m.size(); i++)
+        p.emplace_back(m.build[i], m.probe[i]);
+    std::sort(p.begin(), p.end());
+    return p;
+}
+
+template <typename K>
+Pairs reference_join(const std::vector<K> &build, const std::vector<K> &probe)
+{
+    std::unordered_multimap<K, uint32_t> m;
+    for (size_t i = 0; i < build.size(); i++)
+        m.emplace(build[i], static_cast<uint32_t>(i));
+    Pairs p;
+    for (size_t i = 0; i < probe.size(); i++)
+    {
+        const auto [b, e] = m.equal_range(probe[i]);
+        for (auto it = b; it != e; ++it)
+            p.emplace_back(it->second, static_cast<uint32_t>(i));
+    }
+    std::sort(p.begin(), p.end());
+    return p;
+}
+
+int main()
+{
+    std::mt19937_64 gen(3);
+    std::vector<uint64_t> build(N_BUILD);
+    std::vector<uint64_t> probe(N_PROBE);
+    for (auto &k : build)
+        k = gen() % N_KEYS;
+    for (auto &k : probe)
+        k = gen() % (N_KEYS * 2);
+    const Pairs expected = reference_join(build, probe);
+    assert(!expected.empty());
+
+    // Duplicate build keys are chained, every pair is emitted once
+    HashTable::HashJoin<uint64_t> j;
+    j.build(build.data(), build.size());
+    assert(j.size() == N_BUILD && j.distinct_keys() <= N_KEYS);
+    HashTable::JoinMatches out;
+    j.probe(probe.data(), probe.size(), out);
+    assert(sorted_pairs(out) == expected);
+
+    // Probing in two calls with row offsets gives the same pairs
+    HashTable::JoinMatches halves;
+    j.probe(probe.data(), N_PROBE / 2, halves);
+    j.probe(probe.data() + N_PROBE / 2, N_PROBE - N_PROBE / 2, halves, N_PROBE / 2);
+    assert(sorted_pairs(halves) == expected);
+
+    // Parallel probe keeps the order of a single probe
+    const auto par = j.parallel_probe(probe.data(), probe.size(), 4);
+    assert(par.build == out.build && par.probe == out.probe);
+
+    // A rebuild replaces the previous build, an empty one matches nothing
+    j.build(build.data(), 0);
+    out.clear();
+    j.probe(probe.data(), probe.size(), out);
+    assert(out.empty() && j.size() == 0);
+
+    // Radix partitioned, with fixed & automatic bits, on one & several threads
+    for (const size_t bits : {size_t(0), size_t(3), HashTable::RadixHashJoin<uint64_t>::AUTO_RADIX_BITS})
+        for (const size_t n_threads : {1, 3})
+        {
+            HashTable::RadixHashJoin<uint64_t> r(bits);
+            r.build(build.data(), build.size(), n_threads);
+            assert(r.size() == N_BUILD);
+            assert(bits == HashTable::RadixHashJoin<uint64_t>::AUTO_RADIX_BITS || r.partitions() == size_t(1) << bits);
+            assert(sorted_pairs(r.probe(probe.data(), probe.size(), n_threads)) == expected);
+        }
+
+    // Probing before any build matches nothing
+    HashTable::RadixHashJoin<uint64_t> unbuilt;
+    assert(unbuilt.probe(probe.data(), probe.size()).empty());
+
+    // String keys
+    const auto names = make_rand_vec(N_KEYS / 10, STR_SIZE);
+    std::vector<std::string> sbuild(N_BUILD);
+    std::vector<std::string> sprobe(N_PROBE);
+    for (size_t i = 0; i < N_BUILD; i++)
+        sbuild[i] = names[build[i] % names.size()];
+    for (size_t i = 0; i < N_PROBE; i++)
+        sprobe[i] = probe[i] % 2 ? names[probe[i] % names.size()] : std::string("missing");
+    const Pairs sexpected = reference_join(sbuild, sprobe);
+    HashTable::RadixHashJoin<std::string> rs(2);
+    rs.build(sbuild.data(), sbuild.size(), 2);
+    assert(sorted_pairs(rs.probe(sprobe.data(), sprobe.size(), 2)) == sexpected);
+}
@@ -0,0 +1,106 @@
+#include "hashcache.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+constexpr size_t VEC_SIZE = 256;
+constexpr size_t STR_SIZE = 32;
+constexpr size_t CACHE_SIZE = 64;
+constexpr uint64_t N_STRIDED = 40000;
+constexpr uint64_t STRIDE = 4096; // Integer keys whose std::hash, the identity, shares its low 12 bits
+
+int main()
+{
+    const auto vkey = make_rand_vec(VEC_SIZE, STR_SIZE);
+    const auto vval = make_rand_vec(VEC_SIZE, STR_SIZE);
+
+    // Assert the cache behaves as a map while under capacity
+    {
+        HashTable::HashCache<std::string, std::string> c(VEC_SIZE);
+        for (size_t i = 0; i < vkey.size(); i++)
+        {
+            const auto evicted = c.emplace(vkey[i], vval[i]);
+            assert(!evicted.has_value());
+        }
+        assert(c.size() == vkey.size());
+        for (size_t i = 0; i < vkey.size(); i++)
+            assert(*c.find(vkey[i]).value() == vval[i]);
+        assert(c.hits() == vkey.size());
+        assert(c.misses() == 0);
+
+        // Remove half, the other half is still reachable after the chains are shifted back
+        for (size_t i = 0; i < vkey.size(); i += 2)
+        {
+            const auto kv = c.remove(vkey[i]);
+            assert(kv.has_value());
+            assert(kv->first == vkey[i]);
+            assert(kv->second == vval[i]);
+        }
+        assert(c.size() == vkey.size() / 2);
+        for (size_t i = 0; i < vkey.size(); i++)
+            assert(c.contains(vkey[i]) == (i % 2 == 1));
+        assert(!c.find(vkey[0]).has_value());
+        assert(c.misses() == 1);
+    }
+
+    // Assert the cache never exceeds capacity and counts evictions
+    {
+        HashTable::HashCache<std::string, size_t> c(CACHE_SIZE);
+        std::unordered_map<std::string, size_t> model;
+        for (size_t i = 0; i < vkey.size(); i++)
+        {
+            const auto evicted = c.emplace(vkey[i], i);
+            model[vkey[i]] = i;
+            if (evicted)
+                model.erase(evicted->first);
+            assert(c.size() == std::min(i + 1, CACHE_SIZE));
+        }
+        assert(c.evictions() == vkey.size() - CACHE_SIZE);
+
+        // Assert the cache holds exactly the entries that were not evicted
+        assert(model.size() == CACHE_SIZE);
+        for (const auto &[k, v] : model)
+            assert(*c.find(k).value() == v);
+    }
+
+    // Assert recently referenced entries survive eviction
+    {
+        HashTable::HashCache<std::string, size_t> c(CACHE_SIZE);
+        for (size_t i = 0; i < CACHE_SIZE; i++)
+            c.emplace(vkey[i], i);
+
+        // Keep referencing the first key while streaming new keys through the cache
+        for (size_t i = CACHE_SIZE; i < vkey.size(); i++)
+        {
+            const bool hit = c.find(vkey[0]).has_value();
+            assert(hit);
+            c.emplace(vkey[i], i);
+        }
+        assert(c.find(vkey[0]).has_value());
+    }
+
+    // Assert strided integer keys spread over slots & tags, & stay reachable once removals shift the chains back
+    {
+        HashTable::HashCache<uint64_t, uint64_t> c(N_STRIDED + N_STRIDED / 4);
+        std::set<size_t> homes;
+        std::set<size_t> tags;
+        for (uint64_t i = 0; i < N_STRIDED; i++)
+        {
+            c.emplace(i * STRIDE, i);
+            homes.insert(c.hash(i * STRIDE) & 0xFFFF);
+            tags.insert(c.hash(i * STRIDE) >> (sizeof(size_t) * 8 - 6));
+        }
+        assert(homes.size() > N_STRIDED / 2);
+        assert(tags.size() == 64);
+
+        for (uint64_t i = 0; i < N_STRIDED; i += 2)
+            c.remove(i * STRIDE);
+        assert(c.size() == N_STRIDED / 2 && c.evictions() == 0);
+        for (uint64_t i = 0; i < N_STRIDED; i++)
+            assert(c.contains(i * STRIDE) == (i % 2 == 1));
+    }
+}
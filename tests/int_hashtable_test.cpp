@@ -0,0 +1,111 @@
+#include "int_hashtable.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+constexpr size_t VEC_SIZE = 4096;
+
+// Random inserts, updates & removals checked against std::unordered_map
+template <typename K>
+void test_against_map(HashTable::IntHashTable<K, uint64_t> m, K key_range)
+{
+    std::unordered_map<K, uint64_t> model;
+    std::mt19937_64 gen(42);
+    for (size_t i = 0; i < VEC_SIZE * 8; i++)
+    {
+        const K k = static_cast<K>(gen() % key_range);
+        switch (gen() % 3)
+        {
+        case 0:
+        {
+            const auto before = m.emplace(k, i);
+            assert(before.has_value() == (model.count(k) == 1));
+            model[k] = i;
+            break;
+        }
+        case 1:
+        {
+            const auto kv = m.remove(k);
+            assert(kv.has_value() == (model.count(k) == 1));
+            if (kv)
+                assert(kv->second == model[k]);
+            model.erase(k);
+            break;
+        }
+        default:
+        {
+            const auto val = m.find(k);
+            assert(val.has_value() == (model.count(k) == 1));
+            if (val)
+                assert(*val.value() == model[k]);
+        }
+        }
+        assert(m.size() == model.size());
+    }
+
+    // Assert iteration yields every element once
+    size_t count = 0;
+    for (const auto [k, v] : m.key_values())
+    {
+        assert(model.at(k) == v);
+        count += 1;
+    }
+    assert(count == model.size());
+}
+
+int main()
+{
+    // 64-bit & 32-bit keys with default sentinels
+    test_against_map<uint64_t>(HashTable::IntHashTable<uint64_t, uint64_t>(), VEC_SIZE);
+    test_against_map<uint32_t>(HashTable::IntHashTable<uint32_t, uint64_t>(), VEC_SIZE);
+    test_against_map<int16_t>(HashTable::IntHashTable<int16_t, uint64_t>(), VEC_SIZE);
+
+    // User chosen sentinels, the default sentinels are then valid keys
+    HashTable::IntHashTable<uint64_t, uint64_t> m(0, 1);
+    assert(m.empty_key() == 0 && m.deleted_key() == 1);
+    m.emplace(UINT64_MAX, 1);
+    m.emplace(UINT64_MAX - 1, 2);
+    assert(*m.find(UINT64_MAX).value() == 1);
+    assert(*m.find(UINT64_MAX - 1).value() == 2);
+    assert(!m.find(2).has_value());
+
+    // Sentinel keys are reported to callers before an emplace, & never found or removed
+    const size_t before = m.size();
+    assert(m.is_sentinel(0) && m.is_sentinel(1) && !m.is_sentinel(UINT64_MAX));
+    assert(!m.find(0) && !m.find(1) && !std::as_const(m).find(0));
+    const auto empty_kv = m.remove(0);
+    const auto deleted_kv = m.remove(1);
+    assert(!empty_kv && !deleted_kv);
+    assert(m.size() == before && *m.find(UINT64_MAX).value() == 1);
+    test_against_map<uint64_t>(HashTable::IntHashTable<uint64_t, uint64_t>(0, 1), UINT64_MAX);
+
+    // Dense sequential keys, misses stay cheap because the mixer breaks up the cluster
+    HashTable::IntHashTable<uint64_t, uint64_t> dense;
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        dense.emplace(i, i);
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        assert(*dense.find(i).value() == i);
+    for (uint64_t i = VEC_SIZE; i < 2 * VEC_SIZE; i++)
+        assert(!dense.find(i).has_value());
+
+    // Pointer keys
+    std::vector<int> objs(VEC_SIZE);
+    HashTable::IntHashTable<const int *, size_t> ptrs;
+    for (size_t i = 0; i < objs.size(); i++)
+        ptrs.emplace(&objs[i], i);
+    for (size_t i = 0; i < objs.size(); i++)
+        assert(*ptrs.find(&objs[i]).value() == i);
+
+    // Copy, move & shrink
+    auto copy = dense;
+    auto moved = std::move(dense);
+    assert(copy.size() == VEC_SIZE && moved.size() == VEC_SIZE && dense.size() == 0);
+    for (uint64_t i = 0; i < VEC_SIZE; i += 2)
+        copy.remove(i);
+    copy.shrink_to_fit();
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        assert(copy.find(i).has_value() == (i % 2 == 1));
+}
@@ -0,0 +1,80 @@
+#include "hashtable.h"
+#include "tests.h"
+
+#include <string>
+#include <string_view>
+
+constexpr size_t VEC_SIZE = 256;
+constexpr size_t STR_SIZE = 32;
+
+// Count elements through a const reference
+size_t count_const(const HashTable::HashTable<std::string, size_t> &m)
+{
+    size_t count = 0;
+    for (const auto &[k, v] : m.key_values())
+    {
+        assert(m.find(k).has_value());
+        assert(*m.find(k).value() == v);
+        count += 1;
+    }
+
+    size_t count_it = 0;
+    for (auto it = m.cbegin(); it != m.cend(); ++it)
+        count_it += 1;
+    assert(count_it == count);
+    return count;
+}
+
+int main()
+{
+    const auto vkey = make_rand_vec(VEC_SIZE, STR_SIZE);
+    HashTable::HashTable<std::string, size_t> m;
+
+    // Assert iterating an empty table yields nothing
+    assert(count_const(m) == 0);
+    assert(m.begin() == m.end());
+
+    // Insert into map
+    for (size_t i = 0; i < vkey.size(); i++)
+        m.emplace(vkey[i], i);
+    assert(count_const(m) == vkey.size());
+
+    // Assert non-const iterator converts to const iterator
+    HashTable::HashTable<std::string, size_t>::const_iterator cit = m.begin();
+    assert(cit == m.cbegin());
+
+    // Erase odd values while iterating
+    for (auto it = m.begin(); it != m.end();)
+    {
+        const auto [k, v] = *it;
+        if (v % 2 == 1)
+            it = m.erase(it);
+        else
+            ++it;
+    }
+    assert(m.size() == vkey.size() / 2);
+    assert(count_const(m) == vkey.size() / 2);
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(m.find(vkey[i]).has_value() == (i % 2 == 0));
+
+    // Erase values divisible by 4 with a predicate
+    const size_t erased = m.erase_if([](const std::string &, size_t v) { return v % 4 == 0; });
+    assert(erased == vkey.size() / 4);
+    assert(m.size() == vkey.size() / 4);
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(m.find(vkey[i]).has_value() == (i % 4 == 2));
+
+    // Assert erased slots are reused by insertion
+    const size_t cap = m.capacity();
+    for (size_t i = 0; i < vkey.size(); i++)
+        m.emplace(vkey[i], i);
+    assert(m.size() == vkey.size());
+    assert(m.capacity() == cap);
+    assert(count_const(m) == vkey.size());
+
+    // Assert values are mutable through the iterator
+    for (auto [k, v] : m.key_values())
+        v += 1;
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(*m.find(vkey[i]).value() == i + 1);
+}
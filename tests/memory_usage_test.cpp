@@ -0,0 +1,66 @@
+#include "hashtable.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr size_t VEC_SIZE = 256;
+constexpr size_t STR_SIZE = 64; // Past the small string buffer
+
+// Heap backend that tracks the bytes it holds
+struct CountingAlloc
+{
+    static constexpr bool PARALLEL_TOUCH = false;
+    inline static size_t live = 0;
+
+    [[nodiscard]] static void *allocate(size_t bytes, size_t align) noexcept
+    {
+        live += bytes;
+        return HashTable::HeapAlloc::allocate(bytes, align);
+    }
+
+    static void deallocate(void *p, size_t bytes, size_t align) noexcept
+    {
+        live -= bytes;
+        HashTable::HeapAlloc::deallocate(p, bytes, align);
+    }
+};
+
+int main()
+{
+    // The slot & control arrays are all the backend holds
+    {
+        HashTable::HashTable<uint64_t, uint64_t, HashTable::DefaultPolicy, CountingAlloc> m;
+        assert(m.memory_usage() == 0 && CountingAlloc::live == 0);
+        for (uint64_t i = 0; i < VEC_SIZE; i++)
+        {
+            m.emplace(i, i);
+            assert(m.memory_usage() == CountingAlloc::live);
+        }
+        assert(m.memory_usage(true) == m.memory_usage()); // Integers own no heap memory
+
+        auto copy = m;
+        assert(copy.memory_usage() == m.memory_usage() && CountingAlloc::live == 2 * m.memory_usage());
+        copy.shrink_to_fit();
+        assert(copy.memory_usage() < m.memory_usage());
+    }
+    assert(CountingAlloc::live == 0);
+
+    // Owned memory counts the heap buffers of long strings only
+    const auto v = make_rand_vec(VEC_SIZE, STR_SIZE);
+    HashTable::HashTable<std::string, std::string> m;
+    for (size_t i = 0; i < VEC_SIZE; i++)
+        m.emplace(v[i], std::string("short"));
+    const size_t owned = m.memory_usage(true) - m.memory_usage();
+    size_t expected = 0;
+    for (const auto &[key, val] : m)
+        expected += key.capacity() + 1;
+    assert(owned == expected && owned >= VEC_SIZE * (STR_SIZE + 1));
+
+    // Vectors count their buffer & what their elements own
+    HashTable::HashTable<uint64_t, std::vector<std::string>> mv;
+    mv.emplace(uint64_t(1), std::vector<std::string>{v[0], "short"});
+    const auto &vec = *mv.find(1).value();
+    assert(mv.memory_usage(true) - mv.memory_usage() == vec.capacity() * sizeof(std::string) + vec[0].capacity() + 1);
+}
@@ -0,0 +1,107 @@
+#include "hashtable.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+constexpr size_t VEC_SIZE = 256;
+constexpr size_t STR_SIZE = 32;
+
+int main()
+{
+    // Merge with a reducer sums the values of keys in both tables
+    HashTable::HashTable<uint64_t, uint64_t> a;
+    HashTable::HashTable<uint64_t, uint64_t> b;
+    for (uint64_t i = 0; i < VEC_SIZE * 2; i++)
+        a.emplace(i, i);
+    for (uint64_t i = VEC_SIZE; i < VEC_SIZE * 3; i++)
+        b.emplace(i, 1);
+    a.remove(0); // Tombstones in the target are reused
+    const size_t cap = b.capacity();
+    a.merge(std::move(b), [](uint64_t &val, uint64_t &&other)
+            { val += other; });
+    assert(b.empty() && b.capacity() == 0 && cap > 0);
+    assert(a.size() == VEC_SIZE * 3 - 1 && !a.find(0));
+    for (uint64_t i = 1; i < VEC_SIZE * 3; i++)
+        assert(*a.find(i).value() == (i < VEC_SIZE ? i : i < VEC_SIZE * 2 ? i + 1 : 1));
+
+    // Tombstones count against the load factor, repeated merges into a table full of them stay under it
+    HashTable::HashTable<uint64_t, uint64_t> t;
+    t.reserve(VEC_SIZE);
+    const size_t t_cap = t.capacity();
+    uint64_t next = 0;
+    while (static_cast<float>(t.occupancy() + 1) / t_cap < t.max_load_factor())
+        t.emplace(next++, 0);
+    for (uint64_t i = 0; i < next; i += 2)
+        t.remove(i);
+    assert(t.capacity() == t_cap);
+    for (int r = 0; r < 8; r++)
+    {
+        HashTable::HashTable<uint64_t, uint64_t> u;
+        for (uint64_t i = 0; i < VEC_SIZE / 4; i++)
+            u.emplace(next++, 1);
+        t.merge(std::move(u));
+        assert(static_cast<float>(t.occupancy()) / t.capacity() < t.max_load_factor());
+    }
+
+    // Merging into an empty table takes the other table's storage
+    HashTable::HashTable<uint64_t, uint64_t> empty;
+    const size_t a_cap = a.capacity();
+    empty.merge(std::move(a));
+    assert(empty.size() == VEC_SIZE * 3 - 1 && empty.capacity() == a_cap && a.empty());
+
+    // The default merge keeps other's value, as emplace would
+    HashTable::HashTable<uint64_t, uint64_t> c;
+    c.emplace(uint64_t(1), uint64_t(100));
+    c.emplace(uint64_t(VEC_SIZE * 5), uint64_t(5));
+    empty.merge(std::move(c));
+    assert(*empty.find(1).value() == 100 && *empty.find(VEC_SIZE * 5).value() == 5);
+    assert(empty.size() == VEC_SIZE * 3);
+
+    // Move only values are moved, not copied
+    const auto vkey = make_rand_vec(VEC_SIZE, STR_SIZE);
+    HashTable::HashTable<std::string, std::unique_ptr<int>> p;
+    HashTable::HashTable<std::string, std::unique_ptr<int>> q;
+    for (size_t i = 0; i < vkey.size(); i++)
+        (i % 2 ? p : q).emplace(vkey[i], std::make_unique<int>(i));
+    q.emplace(vkey[1], std::make_unique<int>(-1));
+    p.merge(std::move(q), [](std::unique_ptr<int> &val, std::unique_ptr<int> &&other)
+            { *val += *other; });
+    assert(p.size() == vkey.size());
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(**p.find(vkey[i]).value() == (i == 1 ? 0 : static_cast<int>(i)));
+
+    // Extract all leaves an empty table with its capacity
+    const size_t p_cap = p.capacity();
+    auto kvs = p.extract_all();
+    assert(kvs.size() == vkey.size() && p.empty() && p.capacity() == p_cap && p.occupancy() == 0);
+    std::unordered_map<std::string, int> extracted;
+    for (auto &[k, v] : kvs)
+        extracted[k] = *v;
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(extracted[vkey[i]] == (i == 1 ? 0 : static_cast<int>(i)));
+    assert(!p.find(vkey[0]));
+    p.emplace(vkey[0], std::make_unique<int>(7));
+    assert(**p.find(vkey[0]).value() == 7);
+
+    // Diff keeps the keys missing from or changed in the other table
+    const auto vval = make_rand_vec(VEC_SIZE, STR_SIZE);
+    HashTable::HashTable<std::string, std::string> x;
+    HashTable::HashTable<std::string, std::string> y;
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        x.emplace(vkey[i], vval[i]);
+        if (i % 3 == 1)
+            y.emplace(vkey[i], vval[i]);
+        else if (i % 3 == 2)
+            y.emplace(vkey[i], vval[i] + "x");
+    }
+    const auto d = x.diff(y);
+    assert(d.size() == vkey.size() - (vkey.size() + 1) / 3);
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(d.find(vkey[i]).has_value() == (i % 3 != 1));
+    assert(x.diff(x).empty() && x.diff(x).capacity() == 0);
+    assert(x.diff(HashTable::HashTable<std::string, std::string>()).size() == x.size());
+}
@@ -0,0 +1,109 @@
+#include "mvcc_hashtable.h"
+#include "tests.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr uint64_t N_ELEMS = 5000;
+constexpr uint64_t WINDOW = 1000; // Keys the churning writer keeps
+constexpr uint64_t N_CHURN = 200000;
+constexpr size_t N_READERS = 3;
+
+using StrTable = HashTable::MvccHashTable<uint64_t, std::string>;
+
+std::map<uint64_t, std::string> contents(const StrTable::View &view)
+{
+    std::map<uint64_t, std::string> m;
+    view.for_each([&](uint64_t key, const std::string &val) {
+        const bool added = m.emplace(key, val).second;
+        assert(added);
+    });
+    return m;
+}
+
+int main()
+{
+    // A pinned view keeps the contents of its epoch through updates, removes & rebuilds
+    StrTable m;
+    for (uint64_t i = 0; i < N_ELEMS; i++)
+    {
+        const auto old = m.emplace(i, std::to_string(i));
+        assert(!old);
+    }
+    assert(m.size() == N_ELEMS && *m.find(7).value() == "7");
+
+    auto before = m.pin();
+    const auto expected = contents(before);
+    assert(expected.size() == N_ELEMS);
+
+    const auto old = m.emplace(1, std::string("one"));
+    const auto removed = m.remove(2);
+    const auto removed_again = m.remove(2);
+    assert(old.value() == "1" && removed->second == "2" && !removed_again);
+    for (uint64_t i = N_ELEMS; i < N_ELEMS * 4; i++)
+        m.emplace(i, std::to_string(i));
+    assert(m.retired() > 0);
+
+    assert(contents(before) == expected);
+    assert(*before.find(1).value() == "1" && *before.find(2).value() == "2" && !before.find(N_ELEMS));
+    {
+        const auto after = m.pin();
+        assert(after.epoch() > before.epoch());
+        assert(*after.find(1).value() == "one" && !after.find(2) && *after.find(N_ELEMS).value() == std::to_string(N_ELEMS));
+        assert(contents(after).size() == m.size());
+    }
+
+    // Old generations are freed once no view pins them
+    m.reclaim();
+    assert(m.retired() > 0);
+    before.unpin();
+    m.reclaim();
+    assert(m.retired() == 0);
+
+    // Readers on other threads while a writer churns through a window of keys. Every view sees WINDOW or WINDOW + 1
+    // consecutive keys, each mapping to itself
+    HashTable::MvccHashTable<uint64_t, uint64_t> c;
+    for (uint64_t i = 0; i < WINDOW; i++)
+        c.emplace(i, i);
+    std::atomic<bool> done{false};
+    std::atomic<size_t> views{0};
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < N_READERS; t++)
+        readers.emplace_back([&] {
+            while (!done.load())
+            {
+                const auto view = c.pin();
+                uint64_t lo = UINT64_MAX;
+                uint64_t hi = 0;
+                uint64_t n = 0;
+                view.for_each([&](uint64_t key, uint64_t val) {
+                    assert(key == val);
+                    lo = std::min(lo, key);
+                    hi = std::max(hi, key);
+                    n += 1;
+                });
+                assert(n == WINDOW || n == WINDOW + 1);
+                assert(hi - lo + 1 == n);
+                assert(view.find(lo) && !view.find(hi + 1));
+                views += 1;
+            }
+        });
+
+    for (uint64_t i = WINDOW; i < WINDOW + N_CHURN; i++)
+    {
+        c.emplace(i, i);
+        c.remove(i - WINDOW);
+        if (i % 1024 == 0)
+            std::this_thread::yield();
+    }
+    done = true;
+    for (auto &t : readers)
+        t.join();
+    assert(views.load() > 0 && c.size() == WINDOW);
+    c.reclaim();
+    assert(c.retired() == 0);
+}
@@ -0,0 +1,60 @@
+#include "hashtable.h"
+#include "tests.h"
+
+#include <atomic>
+#include <string>
+#include <string_view>
+
+constexpr size_t VEC_SIZE = 256;
+constexpr size_t STR_SIZE = 32;
+constexpr size_t N_THREADS = 4;
+
+int main()
+{
+    const auto vkey = make_rand_vec(VEC_SIZE, STR_SIZE);
+    HashTable::HashTable<std::string, size_t> m;
+    for (size_t i = 0; i < vkey.size(); i++)
+        m.emplace(vkey[i], i);
+
+    // Assert partitions are disjoint and cover every element
+    for (size_t n = 1; n <= 2 * N_THREADS; n++)
+    {
+        const auto ranges = m.partition(n);
+        assert(ranges.size() == n);
+        std::vector<size_t> seen(vkey.size(), 0);
+        for (const auto &r : ranges)
+            for (const auto [k, v] : r)
+                seen[v] += 1;
+        for (const size_t c : seen)
+            assert(c == 1);
+    }
+
+    // Assert parallel for each visits every element once
+    std::atomic<size_t> sum = 0;
+    m.parallel_for_each([&](const std::string &, size_t v) { sum += v; }, N_THREADS);
+    assert(sum == vkey.size() * (vkey.size() - 1) / 2);
+
+    // Assert values can be updated in parallel
+    m.parallel_for_each([](const std::string &, size_t &v) { v *= 2; }, N_THREADS);
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(*m.find(vkey[i]).value() == i * 2);
+
+    // Assert parallel erase removes matching elements only
+    const size_t erased = m.parallel_erase_if([](const std::string &, size_t v) { return v % 4 == 0; }, N_THREADS);
+    assert(erased == vkey.size() / 2);
+    assert(m.size() == vkey.size() / 2);
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(m.find(vkey[i]).has_value() == (i % 2 == 1));
+
+    // Assert a const table can be scanned in parallel
+    const auto &cm = m;
+    std::atomic<size_t> count = 0;
+    cm.parallel_for_each([&](const std::string &, const size_t &) { count += 1; }, N_THREADS);
+    assert(count == m.size());
+
+    // Assert an empty table partitions into empty ranges
+    HashTable::HashTable<std::string, size_t> empty;
+    for (const auto &r : empty.partition(N_THREADS))
+        assert(r.begin() == r.end());
+    assert(empty.parallel_erase_if([](const std::string &, size_t) { return true; }, N_THREADS) == 0);
+}
@@ -0,0 +1,143 @@
+#include "partitioned_hashtable.h"
+#include "tests.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+constexpr size_t N_ELEMS = 20000;
+constexpr uint32_t MAX_PARTS = 64;
+constexpr size_t STR_SIZE = 16;
+
+// Growing by one partition only moves keys to the new one, about 1 / (n + 1) of them
+template <typename Router>
+void check_router(const std::vector<uint64_t> &keys)
+{
+    for (uint32_t n = 1; n < MAX_PARTS; n++)
+    {
+        size_t moved = 0;
+        for (const uint64_t k : keys)
+        {
+            const uint32_t a = HashTable::key_partition<Router>(k, n);
+            const uint32_t b = HashTable::key_partition<Router>(k, n + 1);
+            assert(a < n && b <= n);
+            assert(a == b || b == n);
+            moved += a != b;
+        }
+        const double expected = static_cast<double>(keys.size()) / (n + 1);
+        assert(moved > expected * 0.8 && moved < expected * 1.2);
+    }
+}
+
+template <typename Router>
+void check_layout(const HashTable::PartitionedHashTable<uint64_t, uint64_t, Router> &m, const std::vector<uint64_t> &keys)
+{
+    assert(m.size() == keys.size());
+    for (const uint64_t k : keys)
+        assert(*m.find(k).value() == k * 3);
+    for (uint32_t p = 0; p < m.partitions(); p++)
+        for (const auto [key, val] : m.partition(p))
+            assert(m.partition_of(key) == p);
+}
+
+template <typename Router>
+void check_resize(const std::vector<uint64_t> &keys)
+{
+    HashTable::PartitionedHashTable<uint64_t, uint64_t, Router> m(4);
+    for (const uint64_t k : keys)
+        m.emplace(k, k * 3);
+    check_layout(m, keys);
+
+    // Small batches, so a partition sends several
+    size_t batches = 0;
+    const auto stats = m.resize(6, [&](uint32_t target, const std::string &batch) {
+        assert(batch.size() < 1024 + 16 + sizeof(HashTable::MigrationHeader));
+        const bool ok = HashTable::migrate_in(m.partition(target), target, batch);
+        assert(ok);
+        batches += 1;
+    }, 1024);
+    assert(stats.batches == batches && batches > 4);
+    check_layout(m, keys);
+
+    // Grow & shrink, every move is counted & no other key moves
+    for (const uint32_t n : {5u, 16u, 17u, 3u, 1u, 8u})
+    {
+        size_t expected = 0;
+        for (const uint64_t k : keys)
+            expected += m.partition_of(k) != HashTable::key_partition<Router>(k, n);
+        const auto stats = m.resize(n);
+        assert(m.partitions() == n);
+        assert(stats.keys_moved == expected);
+        assert(stats.bytes >= expected * 16 && (expected == 0) == (stats.batches == 0));
+        check_layout(m, keys);
+    }
+}
+
+int main()
+{
+    std::mt19937_64 gen(5);
+    std::vector<uint64_t> keys;
+    for (size_t i = 0; i < N_ELEMS; i++)
+        keys.push_back(i % 2 ? gen() : i); // Sequential & random keys
+
+    check_router<HashTable::JumpRouter>(keys);
+    check_router<HashTable::RendezvousRouter>(keys);
+    check_resize<HashTable::JumpRouter>(keys);
+    check_resize<HashTable::RendezvousRouter>(keys);
+
+    // Harness of independent instances, e.g. one per process, that only exchange batches through per-instance inboxes
+    constexpr uint32_t N_OLD = 3;
+    constexpr uint32_t N_NEW = 7;
+    std::vector<HashTable::HashTable<std::string, std::string>> nodes(N_NEW);
+    const auto names = make_rand_vec(N_ELEMS / 4, STR_SIZE);
+    for (const auto &s : names)
+        nodes[HashTable::key_partition<HashTable::JumpRouter>(s, N_OLD)].emplace(s, s + "!");
+
+    std::vector<std::vector<std::string>> inbox(N_NEW);
+    size_t moved = 0;
+    for (uint32_t p = 0; p < N_OLD; p++)
+        moved += HashTable::migrate_out(nodes[p], p, N_NEW, [&](uint32_t target, const std::string &batch) { inbox[target].push_back(batch); }).keys_moved;
+    assert(moved > 0 && inbox[0].empty() && !inbox[N_NEW - 1].empty());
+
+    // A corrupt batch & one sent to the wrong instance are rejected without inserting anything
+    std::string corrupt = inbox[N_NEW - 1].front();
+    corrupt.back() ^= 1;
+    const bool corrupt_ok = HashTable::migrate_in(nodes[N_NEW - 1], N_NEW - 1, corrupt);
+    const bool misrouted_ok = HashTable::migrate_in(nodes[N_NEW - 2], N_NEW - 2, inbox[N_NEW - 1].front());
+    const bool short_ok = HashTable::migrate_in(nodes[N_NEW - 1], N_NEW - 1, std::string("short"));
+    assert(!corrupt_ok && !misrouted_ok && !short_ok);
+
+    // The count is outside the crc, a batch claiming fewer or more elements than it holds inserts none of them
+    for (const int delta : {-1, 1})
+    {
+        std::string bad = inbox[N_NEW - 1].front();
+        uint32_t count;
+        std::memcpy(&count, bad.data() + offsetof(HashTable::MigrationHeader, count), sizeof(count));
+        count += delta;
+        std::memcpy(bad.data() + offsetof(HashTable::MigrationHeader, count), &count, sizeof(count));
+        const bool ok = HashTable::migrate_in(nodes[N_NEW - 1], N_NEW - 1, bad);
+        assert(!ok);
+    }
+    assert(nodes[N_NEW - 1].empty() && nodes[N_NEW - 2].empty());
+
+    size_t received = 0;
+    for (uint32_t p = 0; p < N_NEW; p++)
+        for (const auto &batch : inbox[p])
+        {
+            const size_t before = nodes[p].size();
+            const bool ok = HashTable::migrate_in(nodes[p], p, batch);
+            assert(ok);
+            received += nodes[p].size() - before;
+        }
+    assert(received == moved);
+
+    size_t total = 0;
+    for (uint32_t p = 0; p < N_NEW; p++)
+        total += nodes[p].size();
+    assert(total == names.size());
+    for (const auto &s : names)
+        assert(*nodes[HashTable::key_partition<HashTable::JumpRouter>(s, N_NEW)].find(s).value() == s + "!");
+}
@@ -0,0 +1,48 @@
+#include "hashtable.h"
+#include "tests.h"
+
+#include <cstdint>
+
+constexpr size_t VEC_SIZE = 1 << 18; // Slot array past one huge page
+
+template <typename Alloc>
+void test_alloc()
+{
+    HashTable::HashTable<uint64_t, uint64_t, HashTable::DefaultPolicy, Alloc> m;
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+    {
+        const auto before = m.emplace(i * 0x9E3779B97F4A7C15ull, i);
+        assert(!before);
+    }
+    assert(m.capacity() * sizeof(std::pair<uint64_t, uint64_t>) > HashTable::MmapAlloc<>::HUGE_PAGE_SIZE);
+
+    // Copy, move & shrink reallocate through the backend
+    auto copy = m;
+    const auto moved = std::move(m);
+    for (uint64_t i = 0; i < VEC_SIZE; i += 2)
+    {
+        const auto kv = copy.remove(i * 0x9E3779B97F4A7C15ull);
+        assert(kv->second == i);
+    }
+    copy.shrink_to_fit();
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+    {
+        assert(*moved.find(i * 0x9E3779B97F4A7C15ull).value() == i);
+        assert(copy.find(i * 0x9E3779B97F4A7C15ull).has_value() == (i % 2 == 1));
+    }
+}
+
+int main()
+{
+    static_assert(HashTable::MmapAlloc<>::mapped_size(1) == HashTable::MmapAlloc<>::PAGE_SIZE);
+    static_assert(HashTable::MmapAlloc<>::mapped_size(HashTable::MmapAlloc<>::HUGE_PAGE_SIZE + 1) == 2 * HashTable::MmapAlloc<>::HUGE_PAGE_SIZE);
+    static_assert(HashTable::MmapAlloc<HashTable::HugePages::None>::mapped_size(HashTable::MmapAlloc<>::HUGE_PAGE_SIZE + 1) == HashTable::MmapAlloc<>::HUGE_PAGE_SIZE + HashTable::MmapAlloc<>::PAGE_SIZE);
+
+    test_alloc<HashTable::HeapAlloc>();
+    test_alloc<HashTable::MmapAlloc<HashTable::HugePages::None>>();
+    test_alloc<HashTable::MmapAlloc<HashTable::HugePages::Transparent>>();
+    test_alloc<HashTable::MmapAlloc<HashTable::HugePages::Explicit>>();
+    test_alloc<HashTable::MmapAlloc<HashTable::HugePages::Transparent, HashTable::Numa::Interleave>>();
+    test_alloc<HashTable::MmapAlloc<HashTable::HugePages::Transparent, HashTable::Numa::Bind, 0>>();
+    test_alloc<HashTable::MmapAlloc<HashTable::HugePages::Transparent, HashTable::Numa::FirstTouch>>();
+}
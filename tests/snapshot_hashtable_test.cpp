@@ -0,0 +1,236 @@
+#include "snapshot_hashtable.h"
+#include "tests.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+constexpr size_t VEC_SIZE = 4096;
+
+using Table = HashTable::SnapshotHashTable<uint64_t, uint64_t, 64>;
+
+// Every key of the model is in the snapshot with its value & nothing else is
+template <typename Snap>
+void check_snapshot(const Snap &snap, const std::unordered_map<uint64_t, uint64_t> &model)
+{
+    assert(snap.size() == model.size());
+    for (const auto &[k, v] : model)
+        assert(*snap.find(k).value() == v);
+    size_t count = 0;
+    snap.for_each([&](const auto &k, const auto &v)
+                  {
+                      assert(model.at(k) == v);
+                      count += 1; });
+    assert(count == model.size());
+}
+
+// Random inserts, updates & removals checked against std::unordered_map, with snapshots taken along the way
+void test_against_map(size_t key_range)
+{
+    Table m;
+    std::unordered_map<uint64_t, uint64_t> model;
+    std::vector<std::pair<Table::Snapshot, std::unordered_map<uint64_t, uint64_t>>> snaps;
+    std::mt19937_64 gen(42);
+    for (size_t i = 0; i < VEC_SIZE * 8; i++)
+    {
+        const uint64_t k = gen() % key_range;
+        if (gen() % 3 == 0)
+        {
+            const auto kv = m.remove(k);
+            assert(kv.has_value() == (model.count(k) == 1));
+            assert(!kv || kv->second == model[k]);
+            model.erase(k);
+        }
+        else if (gen() % 2 == 0)
+        {
+            const auto old = m.emplace(k, i);
+            assert(old.has_value() == (model.count(k) == 1));
+            assert(!old || old.value() == model[k]);
+            model[k] = i;
+        }
+        else if (auto v = m.find(k))
+        {
+            *v.value() = i;
+            model[k] = i;
+        }
+        assert(m.size() == model.size());
+
+        if (i % VEC_SIZE == 0)
+            snaps.emplace_back(m.snapshot(), model);
+    }
+
+    const auto &cm = m;
+    for (uint64_t k = 0; k < key_range; k++)
+    {
+        const auto v = cm.find(k);
+        assert(v.has_value() == (model.count(k) == 1));
+        assert(!v || *v.value() == model[k]);
+    }
+    for (const auto &[snap, snap_model] : snaps)
+        check_snapshot(snap, snap_model);
+    check_snapshot(m.snapshot(), model);
+}
+
+// A snapshot shares every segment, only written segments are copied
+void test_copy_on_write()
+{
+    Table m;
+    m.reserve(VEC_SIZE);
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        m.emplace(i, i);
+    const size_t cap = m.capacity();
+
+    // No snapshot, no copy
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        m.emplace(i, i + 1);
+    assert(m.segments_copied() == 0);
+
+    {
+        const auto snap = m.snapshot();
+        m.emplace(uint64_t(0), uint64_t(0));
+        assert(m.segments_copied() == 1);
+        m.emplace(uint64_t(0), uint64_t(1));
+        assert(m.segments_copied() == 1);
+
+        // Lookups & misses never copy
+        const auto &cm = m;
+        for (uint64_t i = 0; i < VEC_SIZE * 2; i++)
+            (void)cm.find(i);
+        const auto kv = m.remove(VEC_SIZE * 2);
+        assert(!kv);
+        assert(m.segments_copied() == 1);
+
+        for (uint64_t i = 0; i < VEC_SIZE; i++)
+            m.emplace(i, 0);
+        assert(m.segments_copied() <= m.segments());
+        assert(*snap.find(1).value() == 2);
+    }
+
+    // The snapshot is gone, writes are in place again
+    const size_t copied = m.segments_copied();
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        m.remove(i);
+    assert(m.segments_copied() == copied && m.capacity() == cap);
+
+    // A snapshot survives a rehash of the table
+    Table g;
+    for (uint64_t i = 0; i < 100; i++)
+        g.emplace(i, i);
+    const auto snap = g.snapshot();
+    for (uint64_t i = 100; i < VEC_SIZE; i++)
+        g.emplace(i, i);
+    assert(g.capacity() > snap.size() && snap.size() == 100);
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        assert(snap.find(i).has_value() == (i < 100));
+}
+
+// Readers scan a snapshot on other threads while the table is rewritten
+void test_concurrent_readers()
+{
+    Table m;
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        m.emplace(i, i);
+    auto snap = m.snapshot();
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; t++)
+        readers.emplace_back([snap]
+                             {
+                                 for (int r = 0; r < 8; r++)
+                                     for (uint64_t i = 0; i < VEC_SIZE; i++)
+                                         assert(*snap.find(i).value() == i); });
+    for (int r = 0; r < 8; r++)
+        for (uint64_t i = 0; i < VEC_SIZE * 2; i++)
+            m.emplace(i, i + r + 1);
+    for (auto &t : readers)
+        t.join();
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        assert(*snap.find(i).value() == i);
+}
+
+// Value that counts its copies
+struct Counted
+{
+    static inline size_t copies = 0;
+    uint64_t v = 0;
+
+    Counted() = default;
+    explicit Counted(uint64_t x) : v(x) {}
+    Counted(const Counted &other) : v(other.v) { copies += 1; }
+    Counted(Counted &&) = default;
+    Counted &operator=(const Counted &other)
+    {
+        v = other.v;
+        copies += 1;
+        return *this;
+    }
+    Counted &operator=(Counted &&) = default;
+};
+
+// Rehash moves the elements of segments no snapshot holds & copies the shared ones
+void test_rehash_moves()
+{
+    HashTable::SnapshotHashTable<uint64_t, Counted, 64> m;
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        m.emplace(i, Counted(i));
+    assert(Counted::copies == 0);
+
+    const auto snap = m.snapshot();
+    for (uint64_t i = VEC_SIZE; i < VEC_SIZE * 2; i++)
+        m.emplace(i, Counted(i));
+    assert(Counted::copies >= VEC_SIZE);
+    for (uint64_t i = 0; i < VEC_SIZE * 2; i++)
+        assert(m.find(i).value()->v == i && snap.find(i).has_value() == (i < VEC_SIZE));
+}
+
+// Snapshots dropped on reader threads, the table writes in place to the segments they released
+void test_release_on_readers()
+{
+    Table m;
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        m.emplace(i, i);
+    for (int r = 0; r < 8; r++)
+    {
+        std::thread reader([snap = m.snapshot(), r]() mutable
+                           {
+                               for (uint64_t i = 0; i < VEC_SIZE; i += 7)
+                                   assert(*snap.find(i).value() == (r == 0 ? i : i + r - 1));
+                               snap = Table::Snapshot(); });
+        for (uint64_t i = 0; i < VEC_SIZE; i++)
+            m.emplace(i, i + r);
+        reader.join();
+    }
+    for (uint64_t i = 0; i < VEC_SIZE; i++)
+        assert(*m.find(i).value() == i + 7);
+}
+
+int main()
+{
+    test_against_map(VEC_SIZE);
+    test_against_map(VEC_SIZE * 64);
+    test_copy_on_write();
+    test_concurrent_readers();
+    test_rehash_moves();
+    test_release_on_readers();
+
+    // Default segment size & non trivial keys
+    HashTable::SnapshotHashTable<std::string, std::string> s;
+    const auto vkey = make_rand_vec(VEC_SIZE, 16);
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const auto before = s.emplace(vkey[i], vkey[i]);
+        assert(!before);
+    }
+    const auto snap = s.snapshot();
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const auto kv = s.remove(vkey[i]);
+        assert(kv->second == vkey[i]);
+    }
+    assert(s.empty() && snap.size() == vkey.size());
+    for (size_t i = 0; i < vkey.size(); i++)
+        assert(*snap.find(vkey[i]).value() == vkey[i]);
+    assert((HashTable::SnapshotHashTable<std::string, std::string>::Snapshot().empty()));
+}
@@ -0,0 +1,164 @@
+#include "hashtable.h"
+#include "sorted_index.h"
+#include "tests.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr size_t N_ELEMS = 20000;
+constexpr size_t STR_SIZE = 16;
+
+template <typename K, typename V>
+std::vector<std::pair<K, V>> reference(const HashTable::HashTable<K, V> &m, HashTable::SortBy by)
+{
+    std::vector<std::pair<K, V>> kvs;
+    for (const auto [key, val] : m)
+        kvs.emplace_back(key, val);
+    if (by == HashTable::SortBy::KEY)
+        std::sort(kvs.begin(), kvs.end());
+    else
+        std::sort(kvs.begin(), kvs.end(), [&](const auto &a, const auto &b) { return m.hash(a.first) < m.hash(b.first); });
+    return kvs;
+}
+
+template <typename K, typename V>
+void check_export(HashTable::HashTable<K, V> m)
+{
+    const auto by_key = reference(m, HashTable::SortBy::KEY);
+    assert(m.sorted() == by_key);
+
+    // Distinct keys may share a hash, only the hashes have to be in order
+    const auto by_hash = m.sorted(HashTable::SortBy::HASH);
+    const auto expected_hash = reference(m, HashTable::SortBy::HASH);
+    assert(by_hash.size() == expected_hash.size());
+    for (size_t i = 0; i < by_hash.size(); i++)
+        assert(m.hash(by_hash[i].first) == m.hash(expected_hash[i].first));
+
+    // Extracting leaves the table empty & usable
+    HashTable::HashTable<K, V> copy = m;
+    const auto extracted = copy.extract_sorted();
+    assert(extracted == by_key);
+    assert(copy.empty() && copy.begin() == copy.end());
+    const auto extracted_hash = m.extract_sorted(HashTable::SortBy::HASH);
+    assert(extracted_hash.size() == by_hash.size());
+    assert(m.empty());
+    m.emplace(by_key.front().first, by_key.front().second);
+    assert(m.size() == 1 && *m.find(by_key.front().first).value() == by_key.front().second);
+}
+
+int main()
+{
+    std::mt19937_64 gen(11);
+
+    // Unsigned keys spanning every byte, with tombstones left by removes
+    HashTable::HashTable<uint64_t, uint64_t> u;
+    for (size_t i = 0; i < N_ELEMS; i++)
+        u.emplace(gen(), i);
+    for (size_t i = 0; i < N_ELEMS / 4; i++)
+        u.remove((*u.begin()).first);
+    check_export(u);
+
+    // Keys in a narrow range, most radix passes are skipped. Both parities of the number of passes are covered
+    for (const uint64_t span : {uint64_t(200), uint64_t(60000), uint64_t(1) << 20})
+    {
+        HashTable::HashTable<uint64_t, std::string> narrow;
+        for (size_t i = 0; i < N_ELEMS; i++)
+            narrow.emplace(gen() % span, std::to_string(i));
+        check_export(narrow);
+    }
+
+    // Negative before positive
+    HashTable::HashTable<int32_t, int32_t> s;
+    for (size_t i = 0; i < N_ELEMS; i++)
+        s.emplace(static_cast<int32_t>(gen()), static_cast<int32_t>(i));
+    check_export(s);
+
+    HashTable::HashTable<double, int> d;
+    for (size_t i = 0; i < N_ELEMS; i++)
+        d.emplace(std::uniform_real_distribution<double>(-1e6, 1e6)(gen), static_cast<int>(i));
+    d.emplace(0.0, 0);
+    check_export(d);
+
+    // String keys fall back to a comparison sort
+    HashTable::HashTable<std::string, int> str;
+    const auto keys = make_rand_vec(N_ELEMS, STR_SIZE);
+    for (size_t i = 0; i < keys.size(); i++)
+        str.emplace(keys[i], static_cast<int>(i));
+    check_export(str);
+
+    // An empty table exports nothing
+    HashTable::HashTable<uint64_t, uint64_t> empty;
+    const auto none = empty.extract_sorted();
+    assert(empty.sorted().empty() && none.empty());
+
+    // Sorted index, rebuilt only after keys change
+    HashTable::HashTable<uint64_t, uint64_t> m;
+    for (uint64_t k = 0; k < N_ELEMS; k++)
+        m.emplace(k * 2, k);
+    HashTable::SortedIndex index(m);
+    assert(index.stale());
+
+    std::vector<uint64_t> seen;
+    const auto collect = [&](uint64_t key, uint64_t val) {
+        assert(val == key / 2);
+        seen.push_back(key);
+    };
+    assert(index.range(100, 111, collect) == 6);
+    assert((seen == std::vector<uint64_t>{100, 102, 104, 106, 108, 110}));
+    assert(!index.stale());
+
+    // Replacing a value keeps the index & the scan sees the new value
+    m.emplace(100, 7);
+    assert(!index.stale());
+    uint64_t val = 0;
+    index.range(100, 101, [&](uint64_t, uint64_t v) { val = v; });
+    assert(val == 7);
+    m.emplace(100, 50);
+
+    // Adding & removing keys rebuilds it on the next scan
+    m.emplace(101, 50);
+    m.remove(102);
+    assert(index.stale());
+    seen.clear();
+    assert(index.range(100, 105, collect) == 3);
+    assert((seen == std::vector<uint64_t>{100, 101, 104}));
+
+    // Rehashing moves slots
+    m.remove(101);
+    index.rebuild();
+    m.reserve(N_ELEMS * 8);
+    assert(index.stale());
+    uint64_t prev = 0;
+    size_t count = 0;
+    index.for_each([&](uint64_t key, uint64_t v) {
+        assert(count == 0 || prev < key);
+        assert(*m.find(key).value() == v);
+        prev = key;
+        count += 1;
+    });
+    assert(count == m.size());
+
+    // Empty & reversed ranges
+    assert(index.range(N_ELEMS * 4, N_ELEMS * 5, collect) == 0);
+    assert(index.range(10, 5, collect) == 0);
+    m.clear();
+    assert(index.range(0, N_ELEMS * 4, collect) == 0);
+
+    // String keys
+    HashTable::SortedIndex sindex(str);
+    std::string prev_str;
+    count = 0;
+    sindex.for_each([&](const std::string &key, int v) {
+        assert(count == 0 || prev_str < key);
+        assert(*str.find(key).value() == v);
+        prev_str = key;
+        count += 1;
+    });
+    assert(count == str.size());
+    assert(sindex.range(prev_str, prev_str + "a", [](const std::string &, int) {}) == 1);
+}
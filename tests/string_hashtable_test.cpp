@@ -0,0 +1,94 @@
+#include "string_hashtable.h"
+#include "tests.h"
+
+#include <string>
+#include <string_view>
+
+constexpr size_t VEC_SIZE = 256;
+
+int main()
+{
+    // Keys of every length around the inline limit
+    for (const size_t str_size : {0, 1, 4, 5, 22, 23, 24, 64})
+    {
+        // Short lengths have few distinct strings
+        const size_t vec_size = str_size == 0 ? 1 : str_size == 1 ? 16 : VEC_SIZE;
+        const auto vkey = make_rand_vec(vec_size, str_size);
+        const auto vkey_wrong = make_rand_vec(str_size == 0 ? 0 : vec_size, str_size, vkey);
+        HashTable::StringHashTable<size_t> m;
+
+        // Insert
+        for (size_t i = 0; i < vkey.size(); i++)
+        {
+            const auto before = m.emplace(vkey[i], i);
+            assert(!before.has_value());
+        }
+        assert(m.size() == vkey.size());
+        assert(m.arena_size() == (str_size > HashTable::StringHashTable<size_t>::INLINE_SIZE ? vkey.size() * str_size : 0)); // Assert only long keys use the arena
+
+        // Update & lookup
+        for (size_t i = 0; i < vkey.size(); i++)
+        {
+            const auto before = m.emplace(vkey[i], i + 1);
+            assert(before.value() == i);
+        }
+        for (size_t i = 0; i < vkey.size(); i++)
+            assert(*m.find(vkey[i]).value() == i + 1);
+        for (size_t i = 0; i < vkey_wrong.size(); i++)
+            assert(!m.find(vkey_wrong[i]).has_value());
+
+        // Iterate
+        size_t count = 0;
+        for (const auto [k, v] : m.key_values())
+        {
+            assert(vkey[v - 1] == k);
+            count += 1;
+        }
+        assert(count == vkey.size());
+
+        // Remove half & shrink, the arena drops removed keys
+        for (size_t i = 0; i < vkey.size(); i += 2)
+        {
+            const auto kv = m.remove(vkey[i]);
+            assert(kv.has_value());
+            assert(kv->first == vkey[i]);
+            assert(kv->second == i + 1);
+        }
+        m.shrink_to_fit();
+        assert(m.arena_size() == (str_size > HashTable::StringHashTable<size_t>::INLINE_SIZE ? vkey.size() / 2 * str_size : 0));
+        for (size_t i = 0; i < vkey.size(); i++)
+            assert(m.find(vkey[i]).has_value() == (i % 2 == 1));
+
+        // Copy & move
+        const auto copy = m;
+        auto moved = std::move(m);
+        for (size_t i = 1; i < vkey.size(); i += 2)
+        {
+            assert(*copy.find(vkey[i]).value() == i + 1);
+            assert(*moved.find(vkey[i]).value() == i + 1);
+        }
+    }
+
+    // Keys sharing length & prefix are still told apart
+    HashTable::StringHashTable<int> m;
+    m.emplace(std::string_view("prefix-a\0", 9), 1);
+    m.emplace(std::string_view("prefix-a\1", 9), 2);
+    m.emplace(std::string(40, 'x') + "a", 3);
+    m.emplace(std::string(40, 'x') + "b", 4);
+    assert(*m.find(std::string_view("prefix-a\0", 9)).value() == 1);
+    assert(*m.find(std::string_view("prefix-a\1", 9)).value() == 2);
+    assert(*m.find(std::string(40, 'x') + "a").value() == 3);
+    assert(*m.find(std::string(40, 'x') + "b").value() == 4);
+    assert(!m.find(std::string(40, 'x') + "c").has_value());
+
+    // Removing & re-emplacing a long key reuses its tombstone without a rehash, the arena still stays bounded
+    const std::string long_key(100, 'y');
+    for (int i = 0; i < 100000; i++)
+    {
+        const auto kv = m.remove(long_key);
+        assert(kv.has_value() == (i > 0));
+        m.emplace(long_key, i);
+    }
+    assert(m.arena_size() <= 2 * (2 * 41 + long_key.size()) + m.capacity());
+    assert(*m.find(long_key).value() == 99999 && *m.find(std::string(40, 'x') + "b").value() == 4);
+}
@@ -0,0 +1,76 @@
+#include "string_interner.h"
+#include "tests.h"
+
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+constexpr size_t VEC_SIZE = 4096;
+constexpr size_t STR_SIZE = 16;
+constexpr size_t N_THREADS = 4;
+
+int main()
+{
+    const auto vkey = make_rand_vec(VEC_SIZE, STR_SIZE);
+    const auto vkey_wrong = make_rand_vec(VEC_SIZE, STR_SIZE, vkey);
+    HashTable::StringInterner interner;
+    assert(interner.empty());
+    assert(!interner.find("").has_value());
+
+    // IDs are dense & in insertion order
+    std::vector<std::string_view> views;
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const auto id = interner.intern(vkey[i]);
+        assert(id == i);
+        views.push_back(interner.resolve(i));
+    }
+    assert(interner.size() == vkey.size());
+
+    // Interning again returns the same ID
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        const auto id = interner.intern(vkey[i]);
+        assert(id == i);
+    }
+    assert(interner.size() == vkey.size());
+
+    // Lookup & resolve, views taken before rehashes still point at the same bytes
+    for (size_t i = 0; i < vkey.size(); i++)
+    {
+        assert(interner.find(vkey[i]).value() == i);
+        assert(interner.resolve(i) == vkey[i]);
+        assert(interner.resolve(i).data() == views[i].data());
+    }
+    for (size_t i = 0; i < vkey_wrong.size(); i++)
+        assert(!interner.find(vkey_wrong[i]).has_value());
+
+    // Empty & large strings
+    const std::string large(HashTable::StringInterner::CHUNK_SIZE, 'x');
+    const uint32_t empty_id = interner.intern("");
+    const uint32_t large_id = interner.intern(large);
+    assert(interner.resolve(empty_id).empty());
+    assert(interner.resolve(large_id) == large);
+    assert(interner.find(large).value() == large_id);
+    assert(interner.resolve(0) == vkey[0]);
+
+    // Freeze & read from several threads
+    const size_t size = interner.size();
+    const auto frozen = HashTable::freeze(std::move(interner));
+    assert(frozen.size() == size);
+    assert(frozen.memory_usage() > 0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < N_THREADS; t++)
+        threads.emplace_back([&]()
+                             {
+                                 for (size_t i = 0; i < vkey.size(); i++)
+                                 {
+                                     assert(frozen.find(vkey[i]).value() == i);
+                                     assert(frozen.resolve(i) == vkey[i]);
+                                     assert(!frozen.find(vkey_wrong[i]).has_value());
+                                 } });
+    for (auto &t : threads)
+        t.join();
+    assert(frozen.resolve(large_id) == large);
+}